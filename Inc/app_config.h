@@ -67,6 +67,41 @@
 #define TESTCONFIG_STOP_DELAY           500          // StopDelay [ms]
 #define TESTCONFIG_SLOT_GAP             100          // TxSlack [ms]
 #define TESTCONFIG_KEY                  "deadbeef"   // payload of RF packets (no special characters!)
+#ifndef TESTCONFIG_LOG_BINARY
+#define TESTCONFIG_LOG_BINARY           0            // 1: print RxDone/TxDone events as compact binary records (base64 encoded, see linktest_log.h) instead of json
+#endif /* TESTCONFIG_LOG_BINARY */
+#define TESTCONFIG_LOG_STATS            0            // 1: aggregate RxDone/TxDone events on the node and print a single RoundStats record per round (P2P mode only)
+#ifndef TESTCONFIG_LOG_DEFERRED
+#define TESTCONFIG_LOG_DEFERRED         0            // 1: radio callbacks only queue events (lock-free ring, see linktest_events.h), processing and printing is done by the logging task (P2P mode only)
+#endif /* TESTCONFIG_LOG_DEFERRED */
+#define TESTCONFIG_SLOT_CALIBRATION     0            // 1: derive the slot period from the TxDone latency measured at startup instead of TESTCONFIG_SLOT_GAP (P2P mode only)
+#define TESTCONFIG_SLOT_LATENCY_MAX     5000         // upper bound for the calibrated TxDone latency [us] (replaces TESTCONFIG_SLOT_GAP in the round period)
+#define TESTCONFIG_SLOT_MARGIN          1000         // safety margin added to the calibrated slot period [us]
+#define TESTCONFIG_SLOT_HS_TIMER        0            // 1: schedule slots with hs_timer compare interrupts (us resolution) instead of FreeRTOS ticks (P2P mode only)
+#define TESTCONFIG_BER_MODE             0            // 1: payload is a PRBS derived from the counter, receivers report bit errors and error bursts of every packet (P2P mode only)
+#define TESTCONFIG_BER_PAYLOAD_LEN      32           // number of PRBS bytes per packet (TESTCONFIG_BER_MODE only, replaces the key)
+#define TESTCONFIG_BER_HEX_DUMP         0            // 1: additionally print the error pattern (XOR of received and expected payload) as hex string
+#define TESTCONFIG_NUM_CONFIGS          1            // number of radio configs (>1: all rounds are repeated for each entry of RADIOCONFIG_LIST, P2P mode only)
+#define TESTCONFIG_NUM_PAYLOAD_LENS     1            // number of payload lengths (>1: slots cycle through TESTCONFIG_PAYLOAD_LEN_LIST, P2P mode only)
+#define TESTCONFIG_PAYLOAD_LEN_LIST     8, 16, 32, 64, 128, 255   // payload lengths incl. the 2 byte counter [bytes] (2...255, the key is truncated or repeated)
+#ifndef TESTCONFIG_SYNC_EXTI
+#define TESTCONFIG_SYNC_EXTI            0            // 1: capture the rising edge of FLOCKLAB_SIG1 with an EXTI interrupt (hs_timer timestamp) instead of polling the pin every 1ms
+#endif /* TESTCONFIG_SYNC_EXTI */
+#define TESTCONFIG_NUM_CHANNELS         1            // number of channels (>1: frequency-division parallel rounds, one transmitter per channel, requires Inc/linktest_schedule.h generated by run_linktest.py --schedule, P2P mode only)
+#define TESTCONFIG_CHANNEL_SPACING      200000       // spacing of the channels above the frequency of the radio config [Hz]
+#define TESTCONFIG_PING_PONG            0            // 1: every receiver of a packet replies in its own sub-slot (ordered by TESTCONFIG_NODE_IDS), the transmitter logs the round-trip time of each reply (P2P mode with TESTCONFIG_SLOT_HS_TIMER only)
+#define TESTCONFIG_PONG_DELAY           1500         // delay between the end of the packet and the start of the first reply sub-slot [us] (must cover the Tx->Rx turnaround of the transmitter)
+#define TESTCONFIG_PONG_GUARD           500          // guard time between two reply sub-slots [us]
+#define TESTCONFIG_CAPTURE_MODE         0            // 1: the node of the round and the next node in TESTCONFIG_NODE_IDS transmit concurrently, slots cycle through two reference slots (one transmitter each) and TESTCONFIG_CAPTURE_OFFSET_LIST (P2P mode with TESTCONFIG_SLOT_HS_TIMER only)
+#define TESTCONFIG_NUM_CAPTURE_OFFSETS  8            // number of entries of TESTCONFIG_CAPTURE_OFFSET_LIST (TESTCONFIG_NUM_SLOTS should be a multiple of TESTCONFIG_NUM_CAPTURE_OFFSETS + 2)
+#define TESTCONFIG_CAPTURE_OFFSET_LIST  0, 100, 1000, 10000, 30000, -100, -1000, -10000   // start of the second transmission relative to the first one [us]
+#define TESTCONFIG_CAPTURE_SAME_PAYLOAD 0            // 1: both nodes send identical packets, 0: the counter of the second node is marked with LINKTEST_CAPTURE_FLAG (receivers can tell which packet has been decoded)
+#define TESTCONFIG_LOG_STATE_TIME       0            // 1: print the CPU active time and the time spent in radio TX, RX and standby at the end of every round (StateTime record, see linktest_state_time.h)
+#ifndef TESTCONFIG_LOG_ARENA
+#define TESTCONFIG_LOG_ARENA            0            // 1: append the records of the rounds to a RAM arena instead of printing them, the arena is dumped after the last round (see linktest_arena.h, P2P mode with TESTCONFIG_LOG_DEFERRED only)
+#endif /* TESTCONFIG_LOG_ARENA */
+#define TESTCONFIG_LOG_ARENA_SIZE       16384        // size of the RAM arena [bytes] (multiple of LINKTEST_LOG_ARENA_BLOCK_SIZE)
+#define TESTCONFIG_LOG_ARENA_PAGES      32           // number of flash pages at the end of the flash to which full blocks are copied between rounds (0: RAM only)
 
 // flood config (required only for TESTCONFIG_FLOOD_MODE)
 #define FLOODCONFIG_RF_BAND             46           // frequency band index as defined in radio_constants.c
@@ -78,7 +113,14 @@
 #define FLOODCONFIG_DELAY_TX            1            // delay retransmissions
                                                      //   n=0: no node delays anything; in different rounds, different nodes initiate flood;
                                                      //   n!=0: in different rounds, different nodes delay retransmission by n hops (single fixed initiator for all rounds)
-#define FLOODCONFIG_INITIATOR           2            // node ID of flood initiator (has an effect only if FLOODCONFIG_DELAY_TX!=0)
+#define FLOODCONFIG_NUM_DELAYS          1            // number of entries of FLOODCONFIG_DELAY_LIST (>1: slots cycle through the delay values instead of FLOODCONFIG_DELAY_TX, requires FLOODCONFIG_DELAY_TX!=0)
+#define FLOODCONFIG_DELAY_LIST          1, 2, 3      // delay values [hops] (TESTCONFIG_NUM_SLOTS should be a multiple of FLOODCONFIG_NUM_DELAYS)
+#define FLOODCONFIG_INITIATOR           2            // node ID of flood initiator (has an effect only if FLOODCONFIG_DELAY_TX!=0 or FLOODCONFIG_ADAPTIVE!=0)
+#define FLOODCONFIG_ADAPTIVE            0            // 1: one calibration flood per node before the first round measures the max. hop distance, FLOODCONFIG_INITIATOR announces the reduced hop budget in feedback floods
+#define FLOODCONFIG_ADAPTIVE_MAX_HOPS   6            // upper bound for the adaptive hop budget (<= FLOODCONFIG_NUM_HOPS, determines the test duration)
+#define FLOODCONFIG_ADAPTIVE_MARGIN     1            // number of hops added to the max. hop distance measured in the calibration floods
+#define FLOODCONFIG_ADAPTIVE_GAP        20           // FLOODCONFIG_FLOOD_GAP used after the calibration [ms]
+#define FLOODCONFIG_TRACE               0            // 1: print a binary FloodTrace record per flood (slots with a received packet, RSSI/SNR per packet, t_ref)
 
 
 /* radio config (required only for TESTCONFIG_P2P_MODE) */
@@ -150,6 +192,17 @@
 // #define RADIOCONFIG_CRC_ON              1            // CRC enabled
 
 
+/* radio config sweep (required only for TESTCONFIG_NUM_CONFIGS > 1) */
+// one entry per config: { txPower, frequency, modulation, datarate, bandwidth, coderate, preambleLen, implicitHeader, crcOn }
+#define RADIOCONFIG_LIST \
+  {  14, 865440000, MODEM_LORA,     12,      0, 1, 10, 0, 1 },  /* mod0 (SF12) */        \
+  {  14, 865440000, MODEM_LORA,      8,      0, 1, 10, 0, 1 },  /* mod4 (SF8) */         \
+  {   4, 865440000, MODEM_LORA,      7,      0, 1, 10, 0, 1 },  /* mod5 (SF7) */         \
+  {  -9, 865440000, MODEM_LORA,      5,      0, 1, 12, 0, 1 },  /* mod7 (SF5) */         \
+  {  14, 869012500, MODEM_FSK,  125000, 234300, 0,  2, 0, 1 },  /* mod8 (FSK 125kHz) */  \
+  {   0, 869012500, MODEM_FSK,  250000, 312000, 0,  4, 0, 1 },  /* mod10 (FSK 250kHz) */
+
+
 /* debugging ******************************************************************/
 #define CPU_ON_IND()                    //PIN_SET(COM_GPIO2)  /* pin to indicate activity (e.g. to calculate the duty cycle) */
 #define CPU_OFF_IND()                   //PIN_CLR(COM_GPIO2)
@@ -157,15 +210,76 @@
                                         FLOCKLAB_PIN_SET(FLOCKLAB_INT2);
 #define GLORIA_STOP_IND()               led_off(LED_SYSTEM); \
                                         FLOCKLAB_PIN_CLR(FLOCKLAB_INT2);
-#define RADIO_TX_START_IND()            FLOCKLAB_PIN_SET(FLOCKLAB_LED2);
-#define RADIO_TX_STOP_IND()             FLOCKLAB_PIN_CLR(FLOCKLAB_LED2);
-#define RADIO_RX_START_IND()            FLOCKLAB_PIN_SET(FLOCKLAB_LED3);
-#define RADIO_RX_STOP_IND()             FLOCKLAB_PIN_CLR(FLOCKLAB_LED3);
+#if TESTCONFIG_LOG_STATE_TIME
+void linktest_state_time_radio(unsigned int state);
+#define RADIO_STATE_IND(state)          linktest_state_time_radio(state);   /* state: 0 = standby, 1 = TX, 2 = RX */
+#else /* TESTCONFIG_LOG_STATE_TIME */
+#define RADIO_STATE_IND(state)
+#endif /* TESTCONFIG_LOG_STATE_TIME */
+#define RADIO_TX_START_IND()            FLOCKLAB_PIN_SET(FLOCKLAB_LED2); \
+                                        RADIO_STATE_IND(1)
+#define RADIO_TX_STOP_IND()             FLOCKLAB_PIN_CLR(FLOCKLAB_LED2); \
+                                        RADIO_STATE_IND(0)
+#define RADIO_RX_START_IND()            FLOCKLAB_PIN_SET(FLOCKLAB_LED3); \
+                                        RADIO_STATE_IND(2)
+#define RADIO_RX_STOP_IND()             FLOCKLAB_PIN_CLR(FLOCKLAB_LED3); \
+                                        RADIO_STATE_IND(0)
 
 /* parameter checks ***********************************************************/
 #if TESTCONFIG_P2P_MODE && TESTCONFIG_FLOOD_MODE
 #error "cannot run test with TESTCONFIG_P2P_MODE and TESTCONFIG_FLOOD_MODE at the same time"
 #endif
+#if TESTCONFIG_SLOT_CALIBRATION && !TESTCONFIG_P2P_MODE
+#error "TESTCONFIG_SLOT_CALIBRATION is only supported in TESTCONFIG_P2P_MODE"
+#endif
+#if TESTCONFIG_SLOT_CALIBRATION && (TESTCONFIG_PING_PONG || TESTCONFIG_CAPTURE_MODE || (TESTCONFIG_NUM_CHANNELS > 1))
+#error "TESTCONFIG_SLOT_CALIBRATION cannot be combined with TESTCONFIG_PING_PONG, TESTCONFIG_CAPTURE_MODE or TESTCONFIG_NUM_CHANNELS > 1 (slot periods differ between the nodes)"
+#endif
+#if TESTCONFIG_SLOT_HS_TIMER && !TESTCONFIG_P2P_MODE
+#error "TESTCONFIG_SLOT_HS_TIMER is only supported in TESTCONFIG_P2P_MODE"
+#endif
+#if TESTCONFIG_LOG_DEFERRED && !TESTCONFIG_P2P_MODE
+#error "TESTCONFIG_LOG_DEFERRED is only supported in TESTCONFIG_P2P_MODE"
+#endif
+#if (FLOODCONFIG_NUM_DELAYS > 1) && !(TESTCONFIG_FLOOD_MODE && FLOODCONFIG_DELAY_TX)
+#error "FLOODCONFIG_NUM_DELAYS > 1 requires TESTCONFIG_FLOOD_MODE and FLOODCONFIG_DELAY_TX!=0"
+#endif
+#if TESTCONFIG_FLOOD_MODE && FLOODCONFIG_ADAPTIVE && (FLOODCONFIG_ADAPTIVE_MAX_HOPS > FLOODCONFIG_NUM_HOPS)
+#error "FLOODCONFIG_ADAPTIVE_MAX_HOPS must not exceed FLOODCONFIG_NUM_HOPS"
+#endif
+#if TESTCONFIG_LOG_ARENA && !(TESTCONFIG_P2P_MODE && TESTCONFIG_LOG_DEFERRED)
+#error "TESTCONFIG_LOG_ARENA requires TESTCONFIG_P2P_MODE and TESTCONFIG_LOG_DEFERRED"
+#endif
+#if TESTCONFIG_PING_PONG && !(TESTCONFIG_P2P_MODE && TESTCONFIG_SLOT_HS_TIMER)
+#error "TESTCONFIG_PING_PONG requires TESTCONFIG_P2P_MODE and TESTCONFIG_SLOT_HS_TIMER"
+#endif
+#if (TESTCONFIG_NUM_CHANNELS > 1) && (!TESTCONFIG_P2P_MODE || TESTCONFIG_LOG_STATS || TESTCONFIG_PING_PONG || TESTCONFIG_BER_MODE || (TESTCONFIG_NUM_PAYLOAD_LENS > 1))
+#error "TESTCONFIG_NUM_CHANNELS > 1 requires TESTCONFIG_P2P_MODE and cannot be combined with TESTCONFIG_LOG_STATS, TESTCONFIG_PING_PONG, TESTCONFIG_BER_MODE or TESTCONFIG_NUM_PAYLOAD_LENS > 1"
+#endif
+#if TESTCONFIG_CAPTURE_MODE && (!(TESTCONFIG_P2P_MODE && TESTCONFIG_SLOT_HS_TIMER) || TESTCONFIG_LOG_STATS || TESTCONFIG_PING_PONG || TESTCONFIG_BER_MODE || (TESTCONFIG_NUM_CHANNELS > 1))
+#error "TESTCONFIG_CAPTURE_MODE requires TESTCONFIG_P2P_MODE and TESTCONFIG_SLOT_HS_TIMER and cannot be combined with TESTCONFIG_LOG_STATS, TESTCONFIG_PING_PONG, TESTCONFIG_BER_MODE or TESTCONFIG_NUM_CHANNELS > 1"
+#endif
+#if TESTCONFIG_BER_MODE && !TESTCONFIG_P2P_MODE
+#error "TESTCONFIG_BER_MODE is only supported in TESTCONFIG_P2P_MODE"
+#endif
+#if TESTCONFIG_BER_MODE && TESTCONFIG_LOG_STATS
+#error "TESTCONFIG_BER_MODE cannot be combined with TESTCONFIG_LOG_STATS"
+#endif
+#if TESTCONFIG_BER_MODE && ((TESTCONFIG_BER_PAYLOAD_LEN < 1) || (TESTCONFIG_BER_PAYLOAD_LEN > 254))
+#error "TESTCONFIG_BER_PAYLOAD_LEN must be within 1 and 254"
+#endif
+#if (TESTCONFIG_NUM_CONFIGS > 1) && !TESTCONFIG_P2P_MODE
+#error "TESTCONFIG_NUM_CONFIGS > 1 is only supported in TESTCONFIG_P2P_MODE"
+#endif
+#if (TESTCONFIG_NUM_CONFIGS > 1) && TESTCONFIG_SLOT_CALIBRATION
+#error "TESTCONFIG_SLOT_CALIBRATION cannot be combined with TESTCONFIG_NUM_CONFIGS > 1"
+#endif
+#if (TESTCONFIG_NUM_PAYLOAD_LENS > 1) && !TESTCONFIG_P2P_MODE
+#error "TESTCONFIG_NUM_PAYLOAD_LENS > 1 is only supported in TESTCONFIG_P2P_MODE"
+#endif
+#if (TESTCONFIG_NUM_PAYLOAD_LENS > 1) && (TESTCONFIG_LOG_STATS || TESTCONFIG_BER_MODE)
+#error "TESTCONFIG_NUM_PAYLOAD_LENS > 1 cannot be combined with TESTCONFIG_LOG_STATS or TESTCONFIG_BER_MODE"
+#endif
 
 
 #endif /* CONFIG_H_ */
@@ -35,15 +35,196 @@
 #define FLOODCONFIG_DELAY_TX          0
 #endif /* FLOODCONFIG_DELAY_TX */
 
+#ifndef FLOODCONFIG_NUM_DELAYS
+#define FLOODCONFIG_NUM_DELAYS        1
+#define FLOODCONFIG_DELAY_LIST        FLOODCONFIG_DELAY_TX
+#endif /* FLOODCONFIG_NUM_DELAYS */
+
+#ifndef FLOODCONFIG_ADAPTIVE
+#define FLOODCONFIG_ADAPTIVE          0
+#endif /* FLOODCONFIG_ADAPTIVE */
+
+#ifndef FLOODCONFIG_ADAPTIVE_MAX_HOPS
+#define FLOODCONFIG_ADAPTIVE_MAX_HOPS FLOODCONFIG_NUM_HOPS
+#endif /* FLOODCONFIG_ADAPTIVE_MAX_HOPS */
+
+#ifndef FLOODCONFIG_ADAPTIVE_MARGIN
+#define FLOODCONFIG_ADAPTIVE_MARGIN   1
+#endif /* FLOODCONFIG_ADAPTIVE_MARGIN */
+
+#ifndef FLOODCONFIG_ADAPTIVE_GAP
+#define FLOODCONFIG_ADAPTIVE_GAP      FLOODCONFIG_FLOOD_GAP
+#endif /* FLOODCONFIG_ADAPTIVE_GAP */
+
+#ifndef FLOODCONFIG_TRACE
+#define FLOODCONFIG_TRACE             0
+#endif /* FLOODCONFIG_TRACE */
+
+#ifndef TESTCONFIG_SLOT_CALIBRATION
+#define TESTCONFIG_SLOT_CALIBRATION   0
+#endif /* TESTCONFIG_SLOT_CALIBRATION */
+
+#ifndef TESTCONFIG_SLOT_LATENCY_MAX
+#define TESTCONFIG_SLOT_LATENCY_MAX   5000
+#endif /* TESTCONFIG_SLOT_LATENCY_MAX */
+
+#ifndef TESTCONFIG_SLOT_MARGIN
+#define TESTCONFIG_SLOT_MARGIN        1000
+#endif /* TESTCONFIG_SLOT_MARGIN */
+
+#ifndef TESTCONFIG_SLOT_HS_TIMER
+#define TESTCONFIG_SLOT_HS_TIMER      0
+#endif /* TESTCONFIG_SLOT_HS_TIMER */
+
+#ifndef TESTCONFIG_NUM_CONFIGS
+#define TESTCONFIG_NUM_CONFIGS        1
+#endif /* TESTCONFIG_NUM_CONFIGS */
+
+#ifndef TESTCONFIG_SYNC_EXTI
+#define TESTCONFIG_SYNC_EXTI          0
+#endif /* TESTCONFIG_SYNC_EXTI */
+
+#ifndef TESTCONFIG_PING_PONG
+#define TESTCONFIG_PING_PONG          0
+#endif /* TESTCONFIG_PING_PONG */
+
+#ifndef TESTCONFIG_PONG_DELAY
+#define TESTCONFIG_PONG_DELAY         1500
+#endif /* TESTCONFIG_PONG_DELAY */
+
+#ifndef TESTCONFIG_PONG_GUARD
+#define TESTCONFIG_PONG_GUARD         500
+#endif /* TESTCONFIG_PONG_GUARD */
+
+/* FLOCKLAB_SIG1 is connected to COM_TREQ (EXTI line 3) */
+#define LINKTEST_SYNC_PIN             COM_TREQ_Pin
+#define LINKTEST_SYNC_GPIO_PORT       COM_TREQ_GPIO_Port
+#define LINKTEST_SYNC_IRQN            EXTI3_IRQn
+#define LINKTEST_SYNC_IRQ_PRIO        5             // must not be higher (numerically lower) than configMAX_SYSCALL_INTERRUPT_PRIORITY
+
+#ifndef TESTCONFIG_NUM_PAYLOAD_LENS
+#define TESTCONFIG_NUM_PAYLOAD_LENS   1
+#endif /* TESTCONFIG_NUM_PAYLOAD_LENS */
+
+#ifndef TESTCONFIG_CAPTURE_MODE
+#define TESTCONFIG_CAPTURE_MODE       0
+#endif /* TESTCONFIG_CAPTURE_MODE */
+
+#ifndef TESTCONFIG_NUM_CAPTURE_OFFSETS
+#define TESTCONFIG_NUM_CAPTURE_OFFSETS  1
+#define TESTCONFIG_CAPTURE_OFFSET_LIST  0
+#endif /* TESTCONFIG_NUM_CAPTURE_OFFSETS */
+
+#ifndef TESTCONFIG_CAPTURE_SAME_PAYLOAD
+#define TESTCONFIG_CAPTURE_SAME_PAYLOAD 0
+#endif /* TESTCONFIG_CAPTURE_SAME_PAYLOAD */
+
+#ifndef TESTCONFIG_NUM_CHANNELS
+#define TESTCONFIG_NUM_CHANNELS       1
+#endif /* TESTCONFIG_NUM_CHANNELS */
+
+#ifndef TESTCONFIG_CHANNEL_SPACING
+#define TESTCONFIG_CHANNEL_SPACING    200000
+#endif /* TESTCONFIG_CHANNEL_SPACING */
+
+#if TESTCONFIG_NUM_CHANNELS > 1
+/* frequency-division parallel rounds: the schedule is generated by run_linktest.py --schedule */
+#if __has_include("linktest_schedule.h")
+#include "linktest_schedule.h"
+#else
+#error "Inc/linktest_schedule.h not found, run ./Scripts/run_linktest.py --schedule"
+#endif
+#if (LINKTEST_SCHEDULE_NUM_NODES != TESTCONFIG_NUM_NODES) || (LINKTEST_SCHEDULE_NUM_CHANNELS != TESTCONFIG_NUM_CHANNELS) || (LINKTEST_SCHEDULE_NUM_SAMPLES != TESTCONFIG_NUM_SLOTS)
+#error "Inc/linktest_schedule.h does not match the config, run ./Scripts/run_linktest.py --schedule"
+#endif
+#define LINKTEST_SCHEDULE_TX          0x80          // schedule entry: LINKTEST_SCHEDULE_TX | channel (transmit), channel (receive) or LINKTEST_SCHEDULE_IDLE
+#define LINKTEST_SCHEDULE_IDLE        0xff
+#define LINKTEST_CHANNEL_SWITCH_TIME  1             // transmitters wait for the receivers to switch the channel at the start of the slot [ms]
+#define LINKTEST_ROUNDS_PER_CONFIG    LINKTEST_SCHEDULE_NUM_ROUNDS
+#define LINKTEST_NUM_SLOTS            LINKTEST_SCHEDULE_NUM_SLOTS
+/* one round per group of transmitters (group sizes differ by at most one), identified by the first node of the group */
+#define LINKTEST_ROUND_GROUP(r)       ((r) % LINKTEST_ROUNDS_PER_CONFIG)
+#define LINKTEST_ROUND_NODE_IDX(r)    (LINKTEST_ROUND_GROUP(r) * (TESTCONFIG_NUM_NODES / LINKTEST_ROUNDS_PER_CONFIG) + \
+                                       ((LINKTEST_ROUND_GROUP(r) < (TESTCONFIG_NUM_NODES % LINKTEST_ROUNDS_PER_CONFIG)) ? LINKTEST_ROUND_GROUP(r) : (TESTCONFIG_NUM_NODES % LINKTEST_ROUNDS_PER_CONFIG)))
+#else
+#define LINKTEST_ROUNDS_PER_CONFIG    TESTCONFIG_NUM_NODES
+#define LINKTEST_NUM_SLOTS            TESTCONFIG_NUM_SLOTS
+#define LINKTEST_ROUND_NODE_IDX(r)    ((r) % TESTCONFIG_NUM_NODES)
+#endif /* TESTCONFIG_NUM_CHANNELS */
+
+/* rounds are grouped by radio config, i.e. round r uses config r / LINKTEST_ROUNDS_PER_CONFIG */
+#define LINKTEST_NUM_ROUNDS           (LINKTEST_ROUNDS_PER_CONFIG * TESTCONFIG_NUM_CONFIGS)
+#define LINKTEST_ROUND_CONFIG_IDX(r)  ((r) / LINKTEST_ROUNDS_PER_CONFIG)
+/* capture mode: the node of the round is the first, the next node in TESTCONFIG_NODE_IDS the second transmitter of the round;
+ * slot s uses entry s % LINKTEST_CAPTURE_CYCLE: 0: first transmitter only, 1: second transmitter only, k >= 2: both (offset k - 2 of TESTCONFIG_CAPTURE_OFFSET_LIST) */
+#define LINKTEST_CAPTURE_NODE_IDX(r)  ((LINKTEST_ROUND_NODE_IDX(r) + 1) % TESTCONFIG_NUM_NODES)
+#define LINKTEST_CAPTURE_CYCLE        (TESTCONFIG_NUM_CAPTURE_OFFSETS + 2)
+/* slots cycle through the payload lengths, i.e. slot s uses entry s % TESTCONFIG_NUM_PAYLOAD_LENS of TESTCONFIG_PAYLOAD_LEN_LIST */
+#define LINKTEST_SLOT_LEN_IDX(s)      ((s) % TESTCONFIG_NUM_PAYLOAD_LENS)
+/* delayed-TX floods: slots cycle through the delay values, i.e. slot s uses entry s % FLOODCONFIG_NUM_DELAYS of FLOODCONFIG_DELAY_LIST */
+#define LINKTEST_SLOT_DELAY_IDX(s)    ((s) % FLOODCONFIG_NUM_DELAYS)
+
+#define LINKTEST_STARTUP_DELAY        100           // delay of vTask_linktest before printing the config (serial logging of the observer is up) [ms]
+#define LINKTEST_CALIBRATION_NUM_TX   5             // number of transmissions used to measure the TxDone latency
+#define LINKTEST_CALIBRATION_TIMEOUT  1000          // max. time to wait for a TxDone event during calibration [ms]
+#define LINKTEST_HS_TIMER_MIN_DELAY   50            // slots starting earlier than this are not scheduled but started immediately [us]
+#define LINKTEST_US_TO_HS_TICKS(us)   ((uint64_t)(us) * HS_TIMER_FREQUENCY / 1000000)
+#define LINKTEST_U64_STR_LEN          21            // max. length of a uint64_t in decimal representation (incl. zero termination)
+#define LINKTEST_PONG_FLAG            0x8000        // set in the counter of replies (TESTCONFIG_PING_PONG), slot indices never use this bit
+#define LINKTEST_CAPTURE_FLAG         0x4000        // set in the counter of the second transmitter (TESTCONFIG_CAPTURE_MODE without TESTCONFIG_CAPTURE_SAME_PAYLOAD)
+#define LINKTEST_CAPTURE_START_DELAY  500           // min. delay of the transmissions after the start of the slot [us]
+#define LINKTEST_FLOOD_REPEAT         3             // number of feedback floods announcing the hop budget (FLOODCONFIG_ADAPTIVE)
+#define LINKTEST_FLOOD_CAL            0xc1          // type of a calibration flood (one per node)
+#define LINKTEST_FLOOD_BUDGET         0xfb          // type of a feedback flood (sent by FLOODCONFIG_INITIATOR)
+
 typedef struct {
   uint16_t counter;
   char key[254];
 } linktest_message_t;
 
+/* payload of the calibration and feedback floods (FLOODCONFIG_ADAPTIVE) */
+typedef struct __attribute__((packed)) {
+  uint8_t  type;                      // LINKTEST_FLOOD_CAL or LINKTEST_FLOOD_BUDGET
+  uint8_t  value;                     // calibration: max. rx_idx known to the initiator of the flood, feedback: hop budget
+} linktest_flood_cal_t;
+
+/* reply of a receiver (TESTCONFIG_PING_PONG), padded to the payload length of the received packet */
+typedef struct __attribute__((packed)) {
+  uint16_t counter;                   // slot index | LINKTEST_PONG_FLAG
+  uint16_t node_id;                   // replying node
+  int16_t  rssi;                      // RSSI of the received packet [dBm]
+  int8_t   snr;                       // SNR of the received packet [dB]
+} linktest_pong_t;
+
+typedef struct {
+  int8_t   tx_power;                  // transmit power [dBm]
+  uint32_t frequency;                 // center frequency [Hz]
+  uint8_t  modulation;                // modem (MODEM_LORA, MODEM_FSK)
+  uint32_t datarate;                  // FSK: bits/s, LoRa: spreading-factor
+  uint32_t bandwidth;                 // LoRa: 0 = 125 kHz, FSK: bandwidth in Hz
+  uint8_t  coderate;
+  uint16_t preamble_len;              // LoRa: num symbols, FSK: num bytes
+  uint8_t  implicit_header;
+  uint8_t  crc_on;
+} linktest_radio_config_t;
+
 void linktest_init(uint32_t *slotTime);
-void linktest_round_pre(uint8_t roundIdx);
-void linktest_round_post(uint8_t roundIdx);
-void linktest_slot(uint8_t roundIdx, uint16_t slotIdx, TickType_t slotStartTs);
+void linktest_round_pre(uint16_t roundIdx);
+void linktest_round_post(uint16_t roundIdx);
+void linktest_slot(uint16_t roundIdx, uint16_t slotIdx, TickType_t slotStartTs);
+const linktest_radio_config_t* linktest_get_radio_config(uint8_t cfgIdx);
+uint16_t   linktest_get_payload_len(uint8_t lenIdx);
+uint32_t   linktest_get_time_on_air(uint8_t cfgIdx, uint8_t lenIdx);
+uint16_t   linktest_get_slot_idx(void);
+uint32_t   linktest_get_slot_gap(void);
+TickType_t linktest_get_slot_offset(uint16_t slotIdx);
+uint64_t   linktest_get_slot_start(uint16_t slotIdx);
+uint32_t   linktest_get_slots_time(uint8_t cfgIdx);
+void       linktest_wait_until(uint64_t timestamp);
+void       linktest_capture_set_slot_start(uint64_t timestamp);
+int32_t    linktest_get_capture_offset(uint8_t offsetIdx);
+uint64_t   linktest_wait_for_sync(TickType_t* syncTick);
+void       linktest_sync_isr(void);
 
 void linktest_set_tx_config_lora(void);
 void linktest_set_tx_config_fsk(void);
@@ -54,15 +235,20 @@ void linktest_radio_irq_capture_callback(void);
 void linktest_check_radio_status(bool restart_rx);
 extern void (*RadioOnDioIrqCallback)(void);
 extern const struct Radio_s Radio;
+extern const uint16_t TESTCONFIG_NODE_LIST[TESTCONFIG_NUM_NODES];
 
 void linktest_OnRadioCadDone(_Bool detected);
 void linktest_OnRadioRxDone(uint8_t* payload, uint16_t size, int16_t rssi, int8_t snr, bool crc_error);
 void linktest_OnRadioTxDone(void);
+void linktest_process_rxdone(uint8_t* payload, uint16_t size, int16_t rssi, int8_t snr, bool crc_error, uint16_t slotIdx, uint64_t syncTs);
+void linktest_process_txdone(uint64_t txDoneTs, uint16_t slotIdx);
 void linktest_OnRxSync(void);
 void linktest_Dummy(void);
 
 void linktest_sanitize_string(char *payload, uint8_t size);
+char* linktest_u64_to_str(uint64_t value, char* buf);
 void linktest_print_flood_stats(bool is_initiator, linktest_message_t* msg);
+void linktest_flood_calibrate(TickType_t* startTs, uint32_t slotPeriod, uint32_t* slotTime);
 
 #define LINKTEST_IRQ_MASK   (IRQ_HEADER_VALID | IRQ_SYNCWORD_VALID | IRQ_RX_DONE | IRQ_TX_DONE | IRQ_HEADER_ERROR | IRQ_CRC_ERROR)
 
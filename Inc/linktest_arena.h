@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2019 - 2021, ETH Zurich, Computer Engineering Group (TEC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * RAM log arena (deferred output of the records of the rounds, P2P mode)
+ *
+ * With TESTCONFIG_LOG_ARENA, the json lines and binary records printed during
+ * the rounds (LINKTEST_LOG(), linktest_log_record()) are appended to a
+ * preallocated arena of blocks instead of the log FIFO, i.e. there is no UART
+ * activity while the radio is in use and no record is lost if the FIFO is
+ * full. With TESTCONFIG_LOG_ARENA_PAGES > 0, full blocks are copied to
+ * pre-erased pages at the end of the flash between two rounds (the blocks have
+ * the size of a flash page). After the last round, all blocks are printed in
+ * a single burst (linktest_arena_dump()), every block is followed by a
+ * LogBlock record with the CRC-16 of its entries (checked by
+ * Scripts/eval_linktest.py).
+ */
+
+#ifndef LINKTEST_ARENA_H_
+#define LINKTEST_ARENA_H_
+
+#include <stdint.h>
+
+#ifndef TESTCONFIG_LOG_ARENA
+#define TESTCONFIG_LOG_ARENA          0
+#endif /* TESTCONFIG_LOG_ARENA */
+#ifndef TESTCONFIG_LOG_ARENA_SIZE
+#define TESTCONFIG_LOG_ARENA_SIZE     16384
+#endif /* TESTCONFIG_LOG_ARENA_SIZE */
+#ifndef TESTCONFIG_LOG_ARENA_PAGES
+#define TESTCONFIG_LOG_ARENA_PAGES    0
+#endif /* TESTCONFIG_LOG_ARENA_PAGES */
+
+#define LINKTEST_LOG_ARENA_BLOCK_SIZE 2048        // size of a block incl. header [bytes] (= FLASH_PAGE_SIZE)
+#define LINKTEST_LOG_ARENA_NUM_BLOCKS (TESTCONFIG_LOG_ARENA_SIZE / LINKTEST_LOG_ARENA_BLOCK_SIZE)
+#define LINKTEST_LOG_ARENA_LINE_LEN   384         // max. length of a json line stored in the arena (incl. zero termination)
+#define LINKTEST_LOG_ARENA_DUMP_RATE  8000        // max. output rate of the dump [bytes/s] (UART: 115200 baud)
+
+#if TESTCONFIG_LOG_ARENA
+#define LINKTEST_LOG(...)             linktest_arena_printf(__VA_ARGS__)
+#define LINKTEST_LOG_STACK_SIZE       (LINKTEST_LOG_ARENA_LINE_LEN / 4)   // additional stack of the tasks calling LINKTEST_LOG() [words]
+#else /* TESTCONFIG_LOG_ARENA */
+#define LINKTEST_LOG(...)             LOG_INFO(__VA_ARGS__)
+#define LINKTEST_LOG_STACK_SIZE       0
+#endif /* TESTCONFIG_LOG_ARENA */
+
+#if TESTCONFIG_LOG_ARENA && (LINKTEST_LOG_ARENA_NUM_BLOCKS < 2)
+#error "TESTCONFIG_LOG_ARENA_SIZE must hold at least 2 blocks"
+#endif
+
+typedef enum {
+  LINKTEST_ARENA_ENTRY_TEXT   = 0,    // json line (without zero termination)
+  LINKTEST_ARENA_ENTRY_BINARY = 1,    // binary record (see linktest_log.h), base64 encoded in the dump
+} linktest_arena_entry_type_t;
+
+typedef struct __attribute__((packed)) {
+  uint8_t  type;                      // entry type (linktest_arena_entry_type_t)
+  uint16_t len;                       // length of the data following the header
+} linktest_arena_entry_hdr_t;
+
+typedef struct {
+  uint16_t len;                       // number of used bytes in data
+  uint16_t num_entries;
+  uint8_t  data[LINKTEST_LOG_ARENA_BLOCK_SIZE - 2 * sizeof(uint16_t)];
+} linktest_arena_block_t;
+
+void linktest_arena_init(void);
+void linktest_arena_append(uint8_t type, const void* data, uint16_t len);
+void linktest_arena_printf(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+void linktest_arena_spill(void);
+void linktest_arena_dump(void);
+
+#endif /* LINKTEST_ARENA_H_ */
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2019 - 2021, ETH Zurich, Computer Engineering Group (TEC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Bit error pattern analysis (P2P mode)
+ *
+ * With TESTCONFIG_BER_MODE, the key in the payload is replaced by a pseudo
+ * random bit sequence (PRBS) which is derived from the counter of the slot.
+ * The receiver regenerates the expected payload and reports the bit errors of
+ * every received packet (incl. packets with CRC error) in a BitErrors record:
+ * Hamming distance, error bursts (runs of consecutive bit errors) and
+ * optionally the complete error pattern (XOR of received and expected
+ * payload) as hex string.
+ * Bit positions count from the MSB of the first payload byte (counter LSB).
+ */
+
+#ifndef LINKTEST_BER_H_
+#define LINKTEST_BER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef TESTCONFIG_BER_MODE
+#define TESTCONFIG_BER_MODE           0
+#endif /* TESTCONFIG_BER_MODE */
+
+#ifndef TESTCONFIG_BER_PAYLOAD_LEN
+#define TESTCONFIG_BER_PAYLOAD_LEN    32        // number of PRBS bytes (excl. counter)
+#endif /* TESTCONFIG_BER_PAYLOAD_LEN */
+
+#ifndef TESTCONFIG_BER_HEX_DUMP
+#define TESTCONFIG_BER_HEX_DUMP       0
+#endif /* TESTCONFIG_BER_HEX_DUMP */
+
+#ifndef LINKTEST_BER_MAX_BURSTS
+#define LINKTEST_BER_MAX_BURSTS       8         // max. number of bursts listed per packet (numBursts counts all bursts)
+#endif /* LINKTEST_BER_MAX_BURSTS */
+
+#define LINKTEST_BER_MSG_LEN          (sizeof(uint16_t) + TESTCONFIG_BER_PAYLOAD_LEN)
+
+void linktest_ber_fill(uint8_t* data, uint16_t counter, uint16_t len);
+void linktest_ber_rx(const uint8_t* payload, uint16_t size, int16_t rssi, int8_t snr, bool crc_error, uint16_t slotIdx);
+
+#endif /* LINKTEST_BER_H_ */
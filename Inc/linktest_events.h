@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2019 - 2021, ETH Zurich, Computer Engineering Group (TEC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Deferred processing of radio events (P2P mode)
+ *
+ * The radio callbacks run in interrupt context (hs_timer capture interrupt).
+ * With TESTCONFIG_LOG_DEFERRED, the callbacks only store a compact event
+ * record in a lock-free single-producer/single-consumer ring buffer. The
+ * records are processed (stats, formatting, printing) by the logging task
+ * (vTask_linktest_log), i.e. serial output no longer extends the ISR.
+ *
+ * Producer: radio ISR (linktest_events_push_xxx()), only writes ring_head.
+ * Consumer: logging task (linktest_events_process()), only writes ring_tail.
+ * A slot is released only after its record has been processed, i.e. an empty
+ * ring implies that all events have been printed (see linktest_events_flush()).
+ */
+
+#ifndef LINKTEST_EVENTS_H_
+#define LINKTEST_EVENTS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef TESTCONFIG_LOG_DEFERRED
+#define TESTCONFIG_LOG_DEFERRED       0
+#endif /* TESTCONFIG_LOG_DEFERRED */
+
+#ifndef LINKTEST_EVENT_RING_SIZE
+#define LINKTEST_EVENT_RING_SIZE      32        // number of event records, must be a power of 2
+#endif /* LINKTEST_EVENT_RING_SIZE */
+
+/* the linktest task has a higher priority than the logging task, i.e. printing never delays a slot */
+#if TESTCONFIG_LOG_DEFERRED
+#define LINKTEST_TASK_PRIORITY        (tskIDLE_PRIORITY + 2)
+#else
+#define LINKTEST_TASK_PRIORITY        (tskIDLE_PRIORITY + 1)
+#endif /* TESTCONFIG_LOG_DEFERRED */
+
+#if (LINKTEST_EVENT_RING_SIZE & (LINKTEST_EVENT_RING_SIZE - 1)) != 0
+#error "LINKTEST_EVENT_RING_SIZE must be a power of 2"
+#endif
+
+#if TESTCONFIG_BER_MODE
+#define LINKTEST_EVENT_PAYLOAD_LEN    (LINKTEST_BER_MSG_LEN)                         // complete payload (error pattern analysis)
+#else
+#define LINKTEST_EVENT_PAYLOAD_LEN    (sizeof(uint16_t) + sizeof(TESTCONFIG_KEY))   // counter and key (+1 byte, a longer key never matches)
+#endif /* TESTCONFIG_BER_MODE */
+
+/* orders the record and index accesses (full memory barrier) */
+#define LINKTEST_EVENT_BARRIER()      __sync_synchronize()
+
+typedef enum {
+  LINKTEST_EVENT_RXDONE = 1,
+  LINKTEST_EVENT_TXDONE = 2,
+} linktest_event_type_t;
+
+typedef struct {
+  uint64_t ts;                                    // hs_timer timestamp captured in the radio IRQ (RxDone: sync word, TxDone: end of TX)
+  uint32_t timestamp;                             // hs_timer timestamp of the event (lower 32 bits)
+  int16_t  rssi;
+  int8_t   snr;
+  uint8_t  type;                                  // linktest_event_type_t
+  uint8_t  size;                                  // size of the received payload
+  uint8_t  crc_error;
+  uint16_t slot;                                  // slot in which the event occurred
+  uint8_t  payload[LINKTEST_EVENT_PAYLOAD_LEN];   // first bytes of the received payload (header)
+} linktest_event_t;
+
+/* producer (ISR context) */
+bool linktest_events_push_rxdone(const uint8_t* payload, uint16_t size, int16_t rssi, int8_t snr, bool crc_error, uint16_t slotIdx, uint64_t syncTs);
+bool linktest_events_push_txdone(uint64_t txDoneTs, uint16_t slotIdx);
+void linktest_events_isr_time(uint32_t ticks);
+
+/* consumer (task context) */
+void linktest_events_set_consumer(TaskHandle_t task);
+void linktest_events_process(void);
+void linktest_events_flush(void);
+void linktest_events_print_stats(uint16_t roundIdx);
+void linktest_events_reset_stats(void);
+
+void vTask_linktest_log(void const * argument);
+
+#endif /* LINKTEST_EVENTS_H_ */
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2019 - 2021, ETH Zurich, Computer Engineering Group (TEC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Binary log records
+ *
+ * Each record is a packed struct consisting of a header (type tag, payload
+ * length, sequence number), a type-specific payload and a CRC-16 trailer.
+ * Since the FlockLab serial service is line based, records are base64 encoded
+ * and printed as a single line starting with LINKTEST_LOG_MARKER.
+ * The decoder is implemented in Scripts/eval_linktest.py (getBinaryRecord()).
+ */
+
+#ifndef LINKTEST_LOG_H_
+#define LINKTEST_LOG_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "linktest_stats.h"
+
+#ifndef TESTCONFIG_LOG_BINARY
+#define TESTCONFIG_LOG_BINARY         0
+#endif /* TESTCONFIG_LOG_BINARY */
+
+#define LINKTEST_LOG_MARKER           '$'
+#define LINKTEST_LOG_KEY_LEN          (sizeof(TESTCONFIG_KEY) - 1)   // number of key bytes stored in a RxDone record
+#define LINKTEST_LOG_FLOOD_MAX_SLOTS  32            // max. number of slots of a flood covered by a FloodTrace record (width of rx_bitmap)
+
+#if TESTCONFIG_FLOOD_MODE && FLOODCONFIG_TRACE && (FLOODCONFIG_N_TX + FLOODCONFIG_NUM_HOPS - 1 > LINKTEST_LOG_FLOOD_MAX_SLOTS)
+#error "FLOODCONFIG_TRACE supports at most LINKTEST_LOG_FLOOD_MAX_SLOTS slots per flood (FLOODCONFIG_N_TX + FLOODCONFIG_NUM_HOPS - 1)"
+#endif
+
+typedef enum {
+  LINKTEST_LOG_REC_RXDONE_V1 = 1,     // legacy RxDone record without sync timestamp (decoder only)
+  LINKTEST_LOG_REC_TXDONE    = 2,     // payload: linktest_log_txdone_t (empty in legacy logs)
+  LINKTEST_LOG_REC_STATS     = 3,     // payload: linktest_stats_t
+  LINKTEST_LOG_REC_RXDONE    = 4,     // payload: linktest_log_rxdone_t
+  LINKTEST_LOG_REC_FLOOD     = 5,     // payload: linktest_log_flood_t (rx[] truncated to num_rx entries)
+} linktest_log_rec_type_t;
+
+typedef struct __attribute__((packed)) {
+  uint8_t  type;                      // record type (linktest_log_rec_type_t)
+  uint8_t  len;                       // length of the payload (excl. header and CRC)
+  uint16_t seq;                       // sequence number (per node, incremented for every record)
+} linktest_log_hdr_t;
+
+typedef struct __attribute__((packed)) {
+  uint64_t ts_sync;                   // hs_timer timestamp of the sync word (0: not captured)
+  uint16_t counter;
+  int16_t  rssi;
+  int8_t   snr;
+  uint8_t  size;
+  uint8_t  crc_error;
+  uint8_t  key_len;                   // length of the received key (can exceed LINKTEST_LOG_KEY_LEN)
+  char     key[LINKTEST_LOG_KEY_LEN]; // raw (unsanitized) key bytes
+} linktest_log_rxdone_t;
+
+typedef struct __attribute__((packed)) {
+  uint64_t ts;                        // hs_timer timestamp of the TxDone interrupt
+  uint16_t slot;
+} linktest_log_txdone_t;
+
+typedef struct __attribute__((packed)) {
+  int16_t  rssi;
+  int8_t   snr;
+} linktest_log_flood_rx_t;
+
+typedef struct __attribute__((packed)) {
+  uint64_t t_ref;                     // gloria reference time (hs_timer timestamp of the start of the flood, 0: not updated)
+  uint32_t rx_bitmap;                 // bit i set: packet received in slot i of the flood (slot 0: transmission of the initiator)
+  uint16_t counter;                   // message counter (slot index of the round)
+  uint8_t  is_initiator;
+  uint8_t  rx_idx;                    // slot of the first received packet
+  uint8_t  rx_started;                // number of started receptions (incl. header and CRC errors)
+  uint8_t  num_rx;                    // number of valid entries in rx[] (one per bit set in rx_bitmap, in ascending slot order)
+  linktest_log_flood_rx_t rx[LINKTEST_LOG_FLOOD_MAX_SLOTS];
+} linktest_log_flood_t;
+
+#define LINKTEST_LOG_MAX(a, b)        (((a) > (b)) ? (a) : (b))
+#define LINKTEST_LOG_MAX_PAYLOAD_LEN  LINKTEST_LOG_MAX(LINKTEST_LOG_MAX(sizeof(linktest_log_rxdone_t), sizeof(linktest_stats_t)), sizeof(linktest_log_flood_t))
+#define LINKTEST_LOG_MAX_REC_LEN      (sizeof(linktest_log_hdr_t) + LINKTEST_LOG_MAX_PAYLOAD_LEN + sizeof(uint16_t))
+
+#if TESTCONFIG_FLOOD_MODE && FLOODCONFIG_TRACE
+#define LINKTEST_FLOOD_TRACE_STACK_SIZE ((LINKTEST_LOG_MAX_REC_LEN * 3) / 4)   // additional stack of the linktest task for linktest_log_record() (record + base64 line) [words]
+#else
+#define LINKTEST_FLOOD_TRACE_STACK_SIZE 0
+#endif /* TESTCONFIG_FLOOD_MODE && FLOODCONFIG_TRACE */
+
+uint16_t linktest_log_crc16(const uint8_t* data, uint32_t len, uint16_t crc);
+uint32_t linktest_log_encode(uint8_t type, const void* payload, uint8_t payload_len, uint8_t* out);
+uint32_t linktest_log_base64(const uint8_t* data, uint32_t len, char* out);
+void     linktest_log_record(uint8_t type, const void* payload, uint8_t payload_len);
+
+void linktest_log_rxdone(const uint8_t* payload, uint16_t size, int16_t rssi, int8_t snr, bool crc_error, uint64_t syncTs);
+void linktest_log_txdone(uint64_t ts, uint16_t slot);
+void linktest_log_flood(const linktest_log_flood_t* rec);
+
+#endif /* LINKTEST_LOG_H_ */
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2019 - 2021, ETH Zurich, Computer Engineering Group (TEC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Per-round accounting of CPU and radio state times
+ *
+ * The radio driver marks every radio state transition with the
+ * RADIO_xx_START_IND()/RADIO_xx_STOP_IND() macros (see app_config.h), which
+ * call linktest_state_time_radio() with TESTCONFIG_LOG_STATE_TIME. The time
+ * spent in each radio state is accumulated based on lptimer timestamps, the
+ * CPU active time is taken from the tickless idle hooks (RTOS_getActiveTime()).
+ * A single StateTime record (all times in us) is printed at the end of every
+ * round, i.e. the energy per delivered packet can be attributed per modulation
+ * (see Scripts/eval_linktest.py).
+ */
+
+#ifndef LINKTEST_STATE_TIME_H_
+#define LINKTEST_STATE_TIME_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef TESTCONFIG_LOG_STATE_TIME
+#define TESTCONFIG_LOG_STATE_TIME     0
+#endif /* TESTCONFIG_LOG_STATE_TIME */
+
+/* radio states, values are used by the indication macros in app_config.h */
+typedef enum {
+  LINKTEST_RADIO_STANDBY = 0,
+  LINKTEST_RADIO_TX      = 1,
+  LINKTEST_RADIO_RX      = 2,
+  LINKTEST_RADIO_NUM_STATES,
+} linktest_radio_state_t;
+
+void linktest_state_time_radio(unsigned int state);
+void linktest_state_time_start_round(void);
+void linktest_state_time_end_round(uint16_t roundIdx);
+
+#endif /* LINKTEST_STATE_TIME_H_ */
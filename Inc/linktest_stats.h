@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2019 - 2021, ETH Zurich, Computer Engineering Group (TEC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * On-node aggregation of per-link statistics (P2P mode)
+ *
+ * Instead of printing every RxDone/TxDone event, the events of a round are
+ * accumulated on the node and a single RoundStats record is printed at the
+ * end of the round (see linktest_round_post()).
+ */
+
+#ifndef LINKTEST_STATS_H_
+#define LINKTEST_STATS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef TESTCONFIG_LOG_STATS
+#define TESTCONFIG_LOG_STATS          0
+#endif /* TESTCONFIG_LOG_STATS */
+
+#ifndef LINKTEST_STATS_GAP_BINS
+#define LINKTEST_STATS_GAP_BINS       8         // number of bins of the loss burst histogram (last bin counts all bursts >= LINKTEST_STATS_GAP_BINS)
+#endif /* LINKTEST_STATS_GAP_BINS */
+
+typedef struct __attribute__((packed)) {
+  uint16_t round;                             // round index (incl. config index, see LINKTEST_ROUND_CONFIG_IDX())
+  uint16_t node;                              // node ID of the transmitter of the round
+  uint16_t num_tx;                            // number of TxDone events (only on the transmitter)
+  uint16_t num_rx;                            // number of packets received without CRC error and with the correct key
+  uint16_t num_crc_error;                     // number of packets received with CRC error
+  int32_t  rssi_sum;
+  uint32_t rssi_sq_sum;
+  int16_t  rssi_min;
+  int16_t  rssi_max;
+  int32_t  snr_sum;
+  uint32_t snr_sq_sum;
+  int8_t   snr_min;
+  int8_t   snr_max;
+  uint16_t gap_hist[LINKTEST_STATS_GAP_BINS]; // histogram of the number of consecutively lost packets (bin i: i+1 packets)
+} linktest_stats_t;
+
+void linktest_stats_start_round(uint16_t roundIdx);
+void linktest_stats_rx(const uint8_t* payload, uint16_t size, int16_t rssi, int8_t snr, bool crc_error);
+void linktest_stats_tx(void);
+void linktest_stats_end_round(uint16_t roundIdx);
+const linktest_stats_t* linktest_stats_get(uint16_t roundIdx);
+
+#endif /* LINKTEST_STATS_H_ */
@@ -37,6 +37,12 @@ extern "C" {
 #include "flora_lib.h"
 #include "cmsis_os.h"   /* includes all FreeRTOS files */
 #include "linktest.h"
+#include "linktest_stats.h"
+#include "linktest_log.h"
+#include "linktest_ber.h"
+#include "linktest_events.h"
+#include "linktest_state_time.h"
+#include "linktest_arena.h"
 
 /* USER CODE END Includes */
 
@@ -68,6 +74,7 @@ void Error_Handler(void);
 /* USER CODE BEGIN EFP */
 void RTOS_Init(void);
 uint32_t RTOS_getDutyCycle(void);
+uint64_t RTOS_getActiveTime(void);
 
 /* USER CODE END EFP */
 
@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Copyright (c) 2019 - 2021, ETH Zurich, Computer Engineering Group (TEC)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+
+@author: romantrueb
+@brief:  Benchmark the extraction of eval_linktest.py on a synthetic P2P log (dataframe vs. streaming path)
+"""
+
+import sys
+import os
+import time
+import json
+import tempfile
+import numpy as np
+
+import eval_linktest as ev
+
+################################################################################
+
+numNodes = 50
+numTx = 100
+key = 'deadbeef'
+
+################################################################################
+
+def generateSerialLog(serialPath, numNodes, numTx, seed=0):
+    '''Generates a synthetic serial.csv (FlockLab format) of a P2P linktest with random link qualities.
+    '''
+    rng = np.random.default_rng(seed)
+    prr = rng.uniform(0, 1, size=(numNodes, numNodes))
+    nodeList = list(range(1, numNodes+1))
+    testConfig = {'type': 'TestConfig', 'p2pMode': 1, 'floodMode': 0, 'numNodes': numNodes, 'numTx': numTx, 'key': key}
+    radioConfig = {'type': 'RadioConfig', 'txPower': 14, 'modulation': 1}
+    t = 0.0
+    with open(serialPath, 'w') as f:
+        f.write('# timestamp,observer_id,node_id,direction,output\n')
+        def out(node, d):
+            f.write('{:.6f},{},{},r,{}\n'.format(t, node, node, json.dumps(d)))
+        for node in nodeList:
+            out(node, testConfig)
+            out(node, radioConfig)
+        for roundIdx, txNode in enumerate(nodeList):
+            t += 1.0
+            for node in nodeList:
+                out(node, {'type': 'StartOfRound', 'round': roundIdx, 'node': txNode})
+            for txIdx in range(numTx):
+                t += 0.01
+                out(txNode, {'type': 'TxDone'})
+                for rxIdx, rxNode in enumerate(nodeList):
+                    if rxNode != txNode and rng.uniform() < prr[roundIdx][rxIdx]:
+                        out(rxNode, {'type': 'RxDone', 'key': key, 'size': 10, 'rssi': int(rng.integers(-120, -40)), 'snr': 5, 'crc_error': 0})
+            t += 1.0
+            for node in nodeList:
+                out(node, {'type': 'EndOfRound', 'round': roundIdx, 'node': txNode})
+
+
+def timeit(func):
+    start = time.perf_counter()
+    ret = func()
+    return ret, time.perf_counter() - start
+
+
+if __name__ == "__main__":
+    if len(sys.argv) > 1:
+        numNodes = int(sys.argv[1])
+    if len(sys.argv) > 2:
+        numTx = int(sys.argv[2])
+
+    with tempfile.TemporaryDirectory() as tmpDir:
+        serialPath = os.path.join(tmpDir, 'serial.csv')
+        generateSerialLog(serialPath, numNodes, numTx)
+        print('synthetic log: {} nodes, {} tx per round, {:.1f} MB'.format(numNodes, numTx, os.path.getsize(serialPath)/1e6))
+
+        dfd, tParse = timeit(lambda: ev.serial2Dfd(serialPath))
+        print('parsing serial log:            {:8.3f} s ({} records)'.format(tParse, len(dfd)))
+
+        # dataframe of the flocklab tools, records are fed into the streaming extractor
+        dListPandas, tPandas = timeit(lambda: ev.extractDataPandas(serialPath))
+        print('extractDataPandas() total:     {:8.3f} s'.format(tPandas))
+
+        # file is read line by line
+        dListStreaming, tStreaming = timeit(lambda: ev.extractDataStreaming(serialPath))
+        print('extractDataStreaming() total:  {:8.3f} s (speedup {:.1f}x)'.format(tStreaming, tPandas/tStreaming))
+
+        for dPandas, dStreaming in zip(dListPandas, dListStreaming):
+            for key in ['prrMatrix', 'crcErrorMatrix', 'pathlossMatrix']:
+                assert np.allclose(dPandas[key], dStreaming[key], equal_nan=True)
@@ -37,17 +37,26 @@ POSSIBILITY OF SUCH DAMAGE.
 
 import sys
 import os
+import re
+import argparse
 import numpy as np
 import pandas as pd
 import json
+import struct
+import base64
+import binascii
 from collections import OrderedDict
-import pickle
+import hashlib
+from concurrent.futures import ProcessPoolExecutor
 
 # construct html with python
 import dominate
 from dominate.tags import *
 from dominate.util import raw
 
+import linktest_data
+import linktest_schedule
+
 from flocklab import Flocklab
 from flocklab import *
 
@@ -57,6 +66,24 @@ fl = Flocklab()
 
 assertionOverride = False
 outputDir = './data'
+cacheDir = os.path.join(outputDir, 'cache')
+
+# version of the extraction, needs to be incremented whenever the content of the extracted data changes (invalidates the cache)
+EVALUATOR_VERSION = 10
+
+# energy model (typical values of the SX1262 and the STM32L433 at 3.3V, see datasheets) to convert the StateTime records into energy
+SUPPLY_VOLTAGE = 3.3                      # [V]
+CPU_ACTIVE_CURRENT = 4.8e-3               # [A] (STM32L433, run mode at 48MHz)
+RADIO_RX_CURRENT = 5.3e-3                 # [A] (Rx boosted)
+RADIO_STANDBY_CURRENT = 0.6e-3            # [A] (STDBY_XOSC)
+RADIO_TX_CURRENT_POINTS = ([14, 17, 20, 22], [45e-3, 58e-3, 84e-3, 118e-3])   # [dBm], [A] (high power PA, optimal PA settings)
+STATE_TIME_KEYS = ['cpu', 'tx', 'rx', 'standby', 'duration']
+
+# capture mode (concurrent transmissions of two nodes)
+CAPTURE_FLAG = 0x4000                     # LINKTEST_CAPTURE_FLAG: counter of the second transmitter
+CAPTURE_SAMPLE_KEYS = ['txNode1', 'txNode2', 'rxNode', 'slot', 'offset', 'txTsOffset', 'rssiDiff', 'outcome']
+CAPTURE_NONE, CAPTURE_FIRST, CAPTURE_SECOND, CAPTURE_ANY = 0, 1, 2, 3   # outcome (CAPTURE_ANY: identical packets)
+CAPTURE_RSSI_BIN = 3                      # bin width of the RSSI difference [dB]
 
 
 ################################################################################
@@ -83,24 +110,459 @@ def getJson(text):
     return ret
 
 
-def getRows(nodeOfRound, df):
-    '''Extract rows for requested round from df
+# binary log records (see Inc/linktest_log.h)
+binRecMarker = '$'
+binRecHdr = struct.Struct('<BBH')            # type, len, seq
+binRecCrc = struct.Struct('<H')
+binRecRxDoneV1 = struct.Struct('<HhbBBB')    # counter, rssi, snr, size, crc_error, key_len (followed by key bytes)
+binRecRxDone = struct.Struct('<QHhbBBB')     # ts_sync, counter, rssi, snr, size, crc_error, key_len (followed by key bytes)
+binRecTxDone = struct.Struct('<QH')          # ts, slot
+binRecStats = struct.Struct('<HHHHHiIhhiIbb') # see linktest_stats_t (followed by gap histogram)
+binRecFlood = struct.Struct('<QIHBBBB')      # t_ref, rx_bitmap, counter, is_initiator, rx_idx, rx_started, num_rx (followed by num_rx entries of binRecFloodRx)
+binRecFloodRx = struct.Struct('<hb')         # rssi, snr
+BIN_REC_RXDONE_V1 = 1
+BIN_REC_TXDONE    = 2
+BIN_REC_STATS     = 3
+BIN_REC_RXDONE    = 4
+BIN_REC_FLOOD     = 5
+
+def sanitizeKey(key):
+    '''Apply the same character replacement as linktest_sanitize_string() in the firmware.
+    '''
+    return ''.join(c if (33 <= ord(c) <= 126 and c not in '\\"') else '?' for c in key)
+
+
+def getBinaryRecord(text):
+    '''Find and decode a base64 encoded binary record in a single line from serial output.
+    Returns a dict identical to the one produced by the json output of the same event, or None if no valid record could be found.
+    '''
+    idx = text.find(binRecMarker)
+    if idx < 0:
+        return None
+    try:
+        raw = base64.b64decode(text[idx+1:].strip(), validate=True)
+    except (binascii.Error, ValueError):
+        return None
+    if len(raw) < binRecHdr.size + binRecCrc.size:
+        return None
+    recType, recLen, seq = binRecHdr.unpack_from(raw, 0)
+    if len(raw) != binRecHdr.size + recLen + binRecCrc.size:
+        print('WARNING: binary record has invalid length: {}'.format(text[idx:]))
+        return None
+    crc, = binRecCrc.unpack_from(raw, binRecHdr.size + recLen)
+    if binascii.crc_hqx(raw[:binRecHdr.size + recLen], 0xffff) != crc:
+        print('WARNING: binary record with invalid CRC: {}'.format(text[idx:]))
+        return None
+    payload = raw[binRecHdr.size:binRecHdr.size + recLen]
+
+    if recType in (BIN_REC_RXDONE, BIN_REC_RXDONE_V1):
+        if recType == BIN_REC_RXDONE:
+            tsSync, counter, rssi, snr, size, crcError, keyLen = binRecRxDone.unpack_from(payload, 0)
+            keyBytes = payload[binRecRxDone.size:]
+        else:
+            counter, rssi, snr, size, crcError, keyLen = binRecRxDoneV1.unpack_from(payload, 0)
+            keyBytes = payload[binRecRxDoneV1.size:]
+        key = sanitizeKey(keyBytes[:keyLen].decode('latin-1'))
+        # key bytes which did not fit into the record are unknown
+        key += '?'*max(0, keyLen - len(keyBytes))
+        rec = OrderedDict([
+            ('type', 'RxDone'),
+            ('key', key),
+            ('size', size),
+            ('counter', counter),
+            ('rssi', rssi),
+            ('snr', snr),
+            ('crc_error', crcError),
+        ])
+        if recType == BIN_REC_RXDONE:
+            rec['ts_sync'] = tsSync
+        return rec
+    elif recType == BIN_REC_TXDONE:
+        if len(payload) >= binRecTxDone.size:
+            ts, slot = binRecTxDone.unpack_from(payload, 0)
+            return OrderedDict([('type', 'TxDone'), ('slot', slot), ('ts', ts)])
+        return OrderedDict([('type', 'TxDone')])
+    elif recType == BIN_REC_STATS:
+        fields = binRecStats.unpack_from(payload, 0)
+        numBins = (len(payload) - binRecStats.size)//2
+        gapHist = list(struct.unpack_from('<{}H'.format(numBins), payload, binRecStats.size))
+        keys = ('round', 'node', 'numTx', 'numRx', 'numCrcError', 'rssiSum', 'rssiSqSum', 'rssiMin', 'rssiMax', 'snrSum', 'snrSqSum', 'snrMin', 'snrMax')
+        return OrderedDict([('type', 'RoundStats')] + list(zip(keys, fields)) + [('gapHist', gapHist)])
+    elif recType == BIN_REC_FLOOD:
+        tRef, rxBitmap, counter, isInitiator, rxIdx, rxStarted, numRx = binRecFlood.unpack_from(payload, 0)
+        rx = [binRecFloodRx.unpack_from(payload, binRecFlood.size + i*binRecFloodRx.size) for i in range(numRx)]
+        return OrderedDict([
+            ('type', 'FloodTrace'),
+            ('counter', counter),
+            ('is_initiator', isInitiator),
+            ('rx_idx', rxIdx),
+            ('rx_started', rxStarted),
+            ('t_ref', tRef),
+            ('rx_slots', [i for i in range(rxBitmap.bit_length()) if (rxBitmap >> i) & 1]),
+            ('rssi', [elem[0] for elem in rx]),
+            ('snr', [elem[1] for elem in rx]),
+        ])
+    else:
+        print('WARNING: unknown binary record type {}'.format(recType))
+    return None
+
+
+def getRecord(text):
+    '''Returns the dict of a json or binary record in a single line from serial output, or None.
+    '''
+    if '{' in text:
+        return getJson(text)
+    return getBinaryRecord(text)
+
+
+# log arena entries (see Inc/linktest_arena.h)
+arenaEntryHdr = struct.Struct('<BH')         # type, len
+ARENA_ENTRY_TEXT   = 0
+ARENA_ENTRY_BINARY = 1
+
+class LogBlockChecker():
+    '''Checks the CRC of the blocks dumped after the last round with TESTCONFIG_LOG_ARENA.
+    The stored entries of a block are reconstructed from the printed lines (json: text, binary record: decoded bytes).
+    Call add() for every line of an observer (in the order of the serial output) and report() at the end.
+    '''
+    def __init__(self):
+        self.crc = {}            # observer -> CRC of the entries of the current block (only during the dump)
+        self.numEntries = {}     # observer -> number of entries of the current block
+        self.numBlocks = 0
+        self.corruptBlocks = []  # (observer, block)
+        self.numDropped = {}     # observer -> number of records which did not fit into the arena
+
+    def add(self, obs, output, rec):
+        if rec is not None and rec['type'] == 'LogArena':
+            self.crc[obs] = 0xffff
+            self.numEntries[obs] = 0
+            self.numDropped[obs] = rec['numDropped']
+            return
+        if obs not in self.crc:
+            return
+        if rec is not None and rec['type'] == 'LogBlock':
+            self.numBlocks += 1
+            if (self.crc[obs] != rec['crc']) or (self.numEntries[obs] != rec['numEntries']):
+                self.corruptBlocks.append((obs, rec['block']))
+            self.crc[obs] = 0xffff
+            self.numEntries[obs] = 0
+            return
+        output = output.strip()
+        if output.startswith(binRecMarker):
+            try:
+                entry = (ARENA_ENTRY_BINARY, base64.b64decode(output[1:], validate=True))
+            except (binascii.Error, ValueError):
+                entry = (ARENA_ENTRY_BINARY, b'')
+        elif '{' in output:
+            entry = (ARENA_ENTRY_TEXT, output[output.find('{'):].encode('latin-1', errors='replace'))
+        else:
+            return   # not stored in the arena (e.g. warnings)
+        self.crc[obs] = binascii.crc_hqx(arenaEntryHdr.pack(entry[0], len(entry[1])) + entry[1], self.crc[obs])
+        self.numEntries[obs] += 1
+
+    def report(self):
+        if self.corruptBlocks:
+            print('WARNING: {} of {} log blocks are corrupted (observer, block): {}'.format(len(self.corruptBlocks), self.numBlocks, self.corruptBlocks))
+        dropped = {obs: num for obs, num in self.numDropped.items() if num}
+        if dropped:
+            print('WARNING: records dropped (log arena full) per observer: {}'.format(dropped))
+
+
+def getBitErrorPositions(rec):
+    '''Returns the bit positions of the bit errors of a BitErrors record (exact if the error pattern is available, otherwise based on the listed bursts)
+    '''
+    if 'xor' in rec:
+        bits = np.unpackbits(np.frombuffer(bytes.fromhex(rec['xor']), dtype=np.uint8))
+        return np.flatnonzero(bits)
+    positions = [np.arange(start, start + length) for start, length in rec['bursts']]
+    return np.concatenate(positions) if positions else np.zeros(0, dtype=int)
+
+
+def isKeyValid(rec, testConfig):
+    '''Checks the key of a RxDone record. With a payload length sweep (numPayloadLens > 1), the key is truncated or repeated
+    to the payload length and only the first repetition is logged, i.e. only this part is compared.
+    '''
+    if testConfig.get('numPayloadLens', 1) > 1:
+        n = min(max(rec['size'] - 2, 0), len(testConfig['key']))
+        return len(rec['key']) >= n and rec['key'][:n] == testConfig['key'][:n]
+    return rec['key'] == testConfig['key']
+
+
+def getPayloadLenIdx(rec, payloadLens):
+    '''Returns the index of the payload length of a RxDone record (payload length sweep) or None if it cannot be determined.
+    Packets without CRC error are assigned by the counter (slot), packets with CRC error by the received size.
+    '''
+    if rec['crc_error'] == 0:
+        lenIdx = rec['counter'] % len(payloadLens)
+        return lenIdx if payloadLens[lenIdx] == rec['size'] else None
+    return payloadLens.index(rec['size']) if rec['size'] in payloadLens else None
+
+
+def getPayloadLens(payloadLenRecs, configIdx=0):
+    '''Returns the payload lengths and the corresponding time-on-air [us] (lists ordered by lenIdx) of a radio config from the PayloadLen records of a node.
+    '''
+    recs = sorted((rec for rec in payloadLenRecs if rec['configIdx'] == configIdx), key=lambda rec: rec['lenIdx'])
+    return [rec['payloadLen'] for rec in recs], [rec['timeOnAir'] for rec in recs]
+
+
+def getStateTimes(rec):
+    '''Returns the times of a StateTime record as array [s] (order as in STATE_TIME_KEYS)
+    '''
+    return np.array([rec[key] for key in STATE_TIME_KEYS])/1e6
+
+
+def getEnergyPerPacket(stateTimeMatrix, prrMatrix, numTx, txPower):
+    '''Estimates the energy [mJ] per packet which has been successfully delivered over a link from the state times of the
+    transmitter and the receiver during the round of the transmitter (energy model: see SUPPLY_VOLTAGE etc.)
     Args:
-        nodeOfRound: nodeID which identifies the round
-        df: dataframe containing all rows to search through
-    '''
-    inRange = False
-    ret = []
-    for d in df.data.to_list():
-        if d['type'] == 'StartOfRound':
-            if d['node'] == nodeOfRound:
-                inRange = True
-        elif d['type'] == 'EndOfRound':
-            if d['node'] == nodeOfRound:
-                break
-        elif inRange:
-            ret.append(d)
-    return ret
+        stateTimeMatrix: state times [s] (dimensions: node of round, observer, STATE_TIME_KEYS)
+        prrMatrix: PRR matrix (rows: tx node, columns: rx node)
+        numTx: number of transmissions per round
+        txPower: transmit power [dBm]
+    Returns:
+        energyMatrix (energy [mJ] per node of round and observer), energyPerPacketMatrix (rows: tx node, columns: rx node, NaN if no packet has been received)
+    '''
+    # the current below 14dBm is not modeled (low power PA), the 14dBm value is used as upper bound
+    txCurrent = np.interp(txPower, *RADIO_TX_CURRENT_POINTS)
+    currents = np.array([CPU_ACTIVE_CURRENT, txCurrent, RADIO_RX_CURRENT, RADIO_STANDBY_CURRENT])
+    energyMatrix = SUPPLY_VOLTAGE * (stateTimeMatrix[:, :, :4] @ currents) * 1e3
+    roundEnergy = np.diagonal(energyMatrix)[:, np.newaxis] + energyMatrix   # energy of the tx node and of the rx node during the round of the tx node
+    numRx = prrMatrix*numTx
+    energyPerPacketMatrix = np.where(numRx > 0, roundEnergy/np.where(numRx > 0, numRx, 1), np.nan)
+    np.fill_diagonal(energyPerPacketMatrix, np.nan)
+    return energyMatrix, energyPerPacketMatrix
+
+
+def getPingPongMatrices(numPongMatrix, turnaroundSumMatrix, turnaroundMaxMatrix, prrMatrix, numTx):
+    '''Returns the link statistics of the replies (TESTCONFIG_PING_PONG, rows: tx node of the round, columns: replying node, i.e. the reply is sent over the link column -> row)
+    Returns:
+        pongPrrMatrix (ratio of round trips, i.e. packet and reply received), reversePrrMatrix (reply received if the packet has been received),
+        turnaroundMatrix (mean) and turnaroundMaxMatrix (max) of the turnaround time [us], NaN if no reply has been received
+    '''
+    numRx = prrMatrix*numTx
+    pongPrrMatrix = numPongMatrix/numTx
+    np.fill_diagonal(pongPrrMatrix, np.nan)
+    reversePrrMatrix = np.where(numRx > 0, numPongMatrix/np.where(numRx > 0, numRx, 1), np.nan)
+    turnaroundMatrix = np.where(numPongMatrix > 0, turnaroundSumMatrix/np.where(numPongMatrix > 0, numPongMatrix, 1), np.nan)
+    turnaroundMaxMatrix = np.where(numPongMatrix > 0, turnaroundMaxMatrix, np.nan)
+    return pongPrrMatrix, reversePrrMatrix, turnaroundMatrix, turnaroundMaxMatrix
+
+
+class ClockFit():
+    '''Running least-squares fit of the rx clock - tx clock difference over the tx clock of one link (see fitClock()).
+    Only the sums of the paired timestamps are kept (python ints, i.e. exact), the order of the pairs does not matter.
+    '''
+    __slots__ = ('n', 'x0', 'xMin', 'sx', 'sy', 'sxx', 'sxy', 'syy')
+
+    def __init__(self):
+        self.n = 0
+        self.x0 = 0       # tx timestamp of the first added pair (reference of the sums) [ticks]
+        self.xMin = 0     # tx timestamp of the first slot [ticks]
+        self.sx = 0
+        self.sy = 0
+        self.sxx = 0
+        self.sxy = 0
+        self.syy = 0
+
+    def add(self, txTs, rxTs):
+        txTs, rxTs = int(txTs), int(rxTs)
+        if self.n == 0:
+            self.x0 = self.xMin = txTs
+        self.xMin = min(self.xMin, txTs)
+        x = txTs - self.x0                        # time on the tx clock [ticks]
+        y = rxTs - txTs                           # rx clock - tx clock [ticks]
+        self.n += 1
+        self.sx += x
+        self.sy += y
+        self.sxx += x*x
+        self.sxy += x*y
+        self.syy += y*y
+
+    def getFit(self):
+        '''Returns intercept [ticks] at the first slot, slope and variance of the residuals [ticks^2], None if less than 2 slots could be paired
+        '''
+        n = self.n
+        dxx = n*self.sxx - self.sx*self.sx
+        if n < 2 or dxx == 0:
+            return None
+        dxy = n*self.sxy - self.sx*self.sy
+        dyy = n*self.syy - self.sy*self.sy
+        slope = dxy/dxx
+        intercept = (self.sy*dxx - dxy*self.sx + dxy*n*(self.xMin - self.x0))/(n*dxx)
+        variance = max(dyy*dxx - dxy*dxy, 0)/(n*n*dxx)
+        return intercept, slope, variance
+
+
+def fitClock(clockFit, hsTimerFreq):
+    '''Estimates the clock offset and drift of a receiver relative to a transmitter from the hs_timer timestamps of one round.
+    Args:
+        clockFit: ClockFit of the link (pairs of the TxDone timestamp on the transmitter and the sync word timestamp of the
+                  packets received without CRC error, see getClockFit()), None if no packet has been received
+        hsTimerFreq: frequency of the hs_timer [Hz]
+    Returns:
+        offset [us] at the first received slot (incl. the constant delay between TxDone and the sync word of the packet),
+        drift [ppm] and jitter [us] (std of the residuals of the linear fit), NaN if less than 2 packets could be paired
+    '''
+    fit = clockFit.getFit() if clockFit is not None else None
+    if fit is None:
+        return np.nan, np.nan, np.nan
+    intercept, slope, variance = fit
+    return intercept/hsTimerFreq*1e6, slope*1e6, np.sqrt(variance)/hsTimerFreq*1e6
+
+
+def getClockFit(txTsDict, rxTsList):
+    '''Returns the ClockFit of the rx timestamps (list of (counter, timestamp)) paired with the tx timestamps (dict counter -> timestamp)
+    '''
+    clockFit = ClockFit()
+    for counter, ts in rxTsList:
+        if counter in txTsDict and ts > 0:
+            clockFit.add(txTsDict[counter], ts)
+    return clockFit
+
+
+def getClockResiduals(txTsDict, rxTsList):
+    '''Residuals [ticks] of the linear fit (see getClockFit()) of all paired timestamps, None if less than 2 timestamps could be paired
+    '''
+    clockFit = getClockFit(txTsDict, rxTsList)
+    fit = clockFit.getFit()
+    if fit is None:
+        return None
+    intercept, slope, _ = fit
+    pairs = np.array([(txTsDict[counter], ts) for counter, ts in rxTsList if counter in txTsDict and ts > 0], dtype=np.int64).reshape(-1, 2)
+    x = pairs[:, 0] - clockFit.xMin               # time on the tx clock since the first slot [ticks]
+    y = pairs[:, 1] - pairs[:, 0]                 # rx clock - tx clock [ticks]
+    return y - (slope*x + intercept)
+
+
+def getScheduleMatrices(testConfig, radioConfig, nodeList, scheduleRec, rxRecs):
+    '''Link statistics of frequency-division parallel rounds (numChannels > 1): the transmitter of a received packet is
+    determined by the schedule (regenerated with linktest_schedule.py, checked against the CRC in the TestConfig)
+    Args:
+        scheduleRec: Schedule record (node IDs in the order of the schedule columns)
+        rxRecs: iterable of (node of round, rx node, counter, valid, crc error, rssi) of all RxDone records
+    Returns:
+        pathlossMatrix, prrMatrix, crcErrorMatrix (rows: tx node, columns: rx node)
+    '''
+    nodeIds = scheduleRec['nodeIds']
+    schedule = linktest_schedule.generateSchedule(len(nodeIds), testConfig['numChannels'], testConfig['numTx'])
+    assert linktest_schedule.getScheduleCrc(schedule) == testConfig['scheduleCrc'], 'schedule does not match the schedule of the test'
+    groupOfRound = {nodeIds[members[0]]: groupIdx for groupIdx, members in enumerate(linktest_schedule.getGroups(len(nodeIds), testConfig['numChannels']))}
+    # column of the schedule -> index in nodeList (-1 if the node is not an observer)
+    numNodes = len(nodeList)
+    colIdx = np.array([nodeList.index(node) if node in nodeList else -1 for node in nodeIds])
+    schedIdx = {node: idx for idx, node in enumerate(nodeIds)}
+
+    # number of samples of each link (numTx for all pairs, unless the schedule is truncated)
+    numSamples = np.zeros( (numNodes, numNodes,) )
+    for roundIdx, slotIdx, rxCol in zip(*np.nonzero((schedule & linktest_schedule.SCHEDULE_TX) == 0)):
+        txCol = linktest_schedule.getTxNode(schedule, roundIdx, slotIdx, rxCol)
+        if txCol is not None and colIdx[txCol] >= 0 and colIdx[rxCol] >= 0:
+            numSamples[colIdx[txCol]][colIdx[rxCol]] += 1
+
+    numRx = np.zeros( (numNodes, numNodes,) )
+    numCrcError = np.zeros( (numNodes, numNodes,) )
+    rssiSum = np.zeros( (numNodes, numNodes,) )
+    for roundNode, rxNode, counter, valid, crcError, rssi in rxRecs:
+        if roundNode not in groupOfRound or rxNode not in schedIdx or counter >= schedule.shape[1]:
+            continue
+        txCol = linktest_schedule.getTxNode(schedule, groupOfRound[roundNode], counter, schedIdx[rxNode])
+        if txCol is None or colIdx[txCol] < 0:
+            continue
+        txNodeIdx, rxNodeIdx = colIdx[txCol], nodeList.index(rxNode)
+        if crcError:
+            numCrcError[txNodeIdx][rxNodeIdx] += 1
+        elif valid:
+            numRx[txNodeIdx][rxNodeIdx] += 1
+            rssiSum[txNodeIdx][rxNodeIdx] += rssi
+
+    samples = np.where(numSamples > 0, numSamples, np.nan)
+    prrMatrix = numRx/samples
+    crcErrorMatrix = numCrcError/samples
+    pathlossMatrix = np.where(numRx > 0, -(rssiSum/np.where(numRx > 0, numRx, 1) - radioConfig['txPower']), np.nan)
+    return pathlossMatrix, prrMatrix, crcErrorMatrix
+
+
+def getCaptureStats(testConfig, radioConfig, nodeList, captureConfig, rounds):
+    '''Link statistics and outcome of the concurrent transmissions in capture mode (TESTCONFIG_CAPTURE_MODE)
+    Args:
+        captureConfig: CaptureConfig record (offsets of the second transmitter [us])
+        rounds: iterable of (node of round, dict observer -> list of (counter, valid, crc error, rssi) of all RxDone records,
+                dict observer -> dict slot -> hs_timer timestamp of the TxDone events)
+    Returns:
+        pathlossMatrix, prrMatrix, crcErrorMatrix (from the reference slots with a single transmitter),
+        captureSamples (one row per receiver and slot with concurrent transmissions, columns: CAPTURE_SAMPLE_KEYS;
+        rssiDiff: RSSI of the first minus RSSI of the second transmitter in the reference slots of the round,
+        txTsOffset: difference of the TxDone timestamps [us])
+    '''
+    numNodes = len(nodeList)
+    nodeIdx = {node: idx for idx, node in enumerate(nodeList)}
+    offsets = captureConfig['offsets']
+    samePayload = captureConfig['samePayload']
+    cycle = len(offsets) + 2
+    hsTimerFreq = testConfig.get('hsTimerFreq', 1e6)
+    numRef = np.zeros( (numNodes, numNodes,) )
+    numRx = np.zeros( (numNodes, numNodes,) )
+    numCrcError = np.zeros( (numNodes, numNodes,) )
+    rssiSum = np.zeros( (numNodes, numNodes,) )
+    samples = []
+    for roundNode, rxDict, txTsDict in rounds:
+        # second transmitter: the other node with TxDone events in the round
+        txNodes = [node for node, ts in txTsDict.items() if ts and node != roundNode]
+        if roundNode not in nodeIdx or len(txNodes) != 1 or txNodes[0] not in nodeIdx:
+            continue
+        txNodes = [roundNode, txNodes[0]]
+        refSlots = [[s for s in range(testConfig['numTx']) if s % cycle == i] for i in range(2)]
+        for rxNode, rxList in rxDict.items():
+            if rxNode in txNodes or rxNode not in nodeIdx:
+                continue
+            decoded = {}   # slot -> outcome
+            refRssi = [[], []]
+            for counter, valid, crcError, rssi in rxList:
+                slot = counter & ~CAPTURE_FLAG
+                if slot >= testConfig['numTx']:
+                    continue
+                k = slot % cycle
+                if k < 2:
+                    # reference slot (single transmitter)
+                    tx = nodeIdx[txNodes[k]]
+                    if crcError:
+                        numCrcError[tx][nodeIdx[rxNode]] += 1
+                    elif valid:
+                        numRx[tx][nodeIdx[rxNode]] += 1
+                        rssiSum[tx][nodeIdx[rxNode]] += rssi
+                        refRssi[k].append(rssi)
+                elif valid and not crcError:
+                    decoded[slot] = CAPTURE_ANY if samePayload else (CAPTURE_SECOND if counter & CAPTURE_FLAG else CAPTURE_FIRST)
+            for k in range(2):
+                numRef[nodeIdx[txNodes[k]]][nodeIdx[rxNode]] += len(refSlots[k])
+            rssiDiff = (np.mean(refRssi[0]) - np.mean(refRssi[1])) if (refRssi[0] and refRssi[1]) else np.nan
+            for slot in range(testConfig['numTx']):
+                if slot % cycle < 2:
+                    continue
+                ts1, ts2 = txTsDict[txNodes[0]].get(slot), txTsDict[txNodes[1]].get(slot)
+                txTsOffset = (ts2 - ts1)/hsTimerFreq*1e6 if (ts1 and ts2) else np.nan
+                samples.append([txNodes[0], txNodes[1], rxNode, slot, offsets[slot % cycle - 2], txTsOffset, rssiDiff, decoded.get(slot, CAPTURE_NONE)])
+
+    ref = np.where(numRef > 0, numRef, np.nan)
+    prrMatrix = numRx/ref
+    crcErrorMatrix = numCrcError/ref
+    pathlossMatrix = np.where(numRx > 0, -(rssiSum/np.where(numRx > 0, numRx, 1) - radioConfig['txPower']), np.nan)
+    captureSamples = np.array(samples, dtype=float).reshape(-1, len(CAPTURE_SAMPLE_KEYS))
+    return pathlossMatrix, prrMatrix, crcErrorMatrix, captureSamples
+
+
+def getCaptureTables(captureSamples, offsets):
+    '''Returns the probability of decoding the first, the second and any of the two packets and the number of samples
+    as DataFrames (rows: RSSI difference bins [dB], columns: offset of the second transmitter [us])
+    '''
+    df = pd.DataFrame(captureSamples, columns=CAPTURE_SAMPLE_KEYS).dropna(subset=['rssiDiff'])
+    df['rssiBin'] = (np.floor(df.rssiDiff/CAPTURE_RSSI_BIN)*CAPTURE_RSSI_BIN).astype(int)
+    df['first'] = (df.outcome == CAPTURE_FIRST)
+    df['second'] = (df.outcome == CAPTURE_SECOND)
+    df['any'] = (df.outcome != CAPTURE_NONE)
+    g = df.groupby(['rssiBin', 'offset'])
+    tables = [g[key].mean().unstack() for key in ['first', 'second', 'any']] + [g.size().unstack()]
+    return [t.reindex(columns=sorted(set(offsets))) for t in tables]
 
 
 def styleDf(df, cmap='inferno', format='{:.1f}', replaceNan=True, applymap=None):
@@ -127,58 +589,71 @@ htmlStyleBlock = '''
 
 ################################################################################
 
-def extractData(testNo, testDir):
-    serialPath = os.path.join(testDir, "{}/serial.csv".format(testNo))
-
-    # download test results if directory does not exist
-    if not os.path.isfile(serialPath):
-        fl.getResults(testNo)
-
-    df = fl.serial2Df(serialPath, error='ignore')
-    df.sort_values(by=['timestamp', 'observer_id'], inplace=True, ignore_index=True)
-
-    # convert output with valid json to dict and remove other rows
-    keepMask = []
-    resList = []
-    for idx, row in df.iterrows():
-        jsonDict = getJson(row['output'])
-        keepMask.append(1 if jsonDict else 0)
-        if jsonDict:
-            resList.append(jsonDict)
-    dfd = df[np.asarray(keepMask).astype(bool)].copy()
-    dfd['data'] = resList
+def getCacheKey(serialPath):
+    '''Returns the cache key of a test, i.e. a hash of the content of the serial file and the evaluator version.
+    '''
+    h = hashlib.sha256()
+    h.update('linktest-eval-v{}\n'.format(EVALUATOR_VERSION).encode())
+    with open(serialPath, 'rb') as f:
+        for chunk in iter(lambda: f.read(1 << 20), b''):
+            h.update(chunk)
+    return h.hexdigest()
 
-    nodeList = sorted(dfd.observer_id.unique())
 
-    groups = dfd.groupby('observer_id')
+def getResultName(testNo, configIdx, numConfigs):
+    '''Returns the name of a result, tests with multiple radio configs are split into one result per config.
+    '''
+    return '{}_cfg{}'.format(testNo, configIdx) if numConfigs > 1 else '{}'.format(testNo)
 
-    # Get TestConfig and RadioConfig & check for consistency
-    testConfigDict = OrderedDict()
-    radioConfigDict = OrderedDict()
-    floodConfigDict = OrderedDict()
-    for node in nodeList:
-        testConfigFound = False
-        radioConfigFound = False
-        floodConfigFound = False
-        testConfigDict[node] = None
-        radioConfigDict[node] = None
-        floodConfigDict[node] = None
-        gDf = groups.get_group(node)
-        for d in gDf.data.to_list():
-            if d['type'] == 'TestConfig':
-                testConfigDict[node] = d
-                testConfigFound = True
-            if d['type'] == 'RadioConfig':
-                radioConfigDict[node] = d
-                radioConfigFound = True
-            if d['type'] == 'FloodConfig':
-                floodConfigDict[node] = d
-                floodConfigFound = True
-            if testConfigFound and (radioConfigFound or floodConfigFound):
-                break
 
+def extractData(testNo, testDir, streaming=True, useCache=True):
+    '''Returns a list of extracted results (one per radio config, i.e. a single element if no config sweep was used).
+    '''
+    serialPath = os.path.join(testDir, "{}/serial.csv".format(testNo))
 
+    # download test results if directory does not exist
+    if not os.path.isfile(serialPath):
+        fl.getResults(testNo)
 
+    # load extracted data from cache if the serial file (and the evaluator) did not change
+    dList = None
+    if useCache:
+        cacheKey = getCacheKey(serialPath)
+        cachePath = os.path.join(cacheDir, cacheKey)
+        if os.path.isdir(cachePath):
+            try:
+                d = linktest_data.loadData(cachePath, mmapMode=None)
+                numConfigs = d['testConfig'].get('numConfigs', 1)
+                dList = [d] + [linktest_data.loadData('{}_cfg{}'.format(cachePath, k), mmapMode=None) for k in range(1, numConfigs)]
+            except (OSError, ValueError, KeyError) as e:
+                # incomplete or outdated cache entry -> extract again (overwrites the entry)
+                print('Ignoring cache entry of test {}: {}'.format(testNo, e))
+                dList = None
+
+    if dList is None:
+        if streaming:
+            dList = extractDataStreaming(serialPath)
+        else:
+            dList = extractDataPandas(serialPath)
+        if useCache:
+            os.makedirs(cacheDir, exist_ok=True)
+            # the primary entry is written last, it marks the cache entry as complete
+            for k in range(1, len(dList)):
+                linktest_data.saveData(dList[k], '{}_cfg{}'.format(cachePath, k))
+            linktest_data.saveData(dList[0], cachePath)
+
+    # save obtained data (see linktest_data.py for the format)
+    os.makedirs(outputDir, exist_ok=True)
+    for k, d in enumerate(dList):
+        linktest_data.saveData(d, os.path.join(outputDir, 'linktest_data_{}'.format(getResultName(testNo, k, len(dList)))))
+
+    return dList
+
+
+def checkConfigs(nodeList, testConfigDict, radioConfigDict, floodConfigDict):
+    '''Checks the configs of all nodes for consistency and returns testConfig, radioConfigs (list ordered by configIdx) and floodConfig.
+    radioConfigDict contains a dict configIdx -> RadioConfig record per node.
+    '''
     testConfig = testConfigDict[nodeList[0]]
     if not('p2pMode' in testConfig) and (len(radioConfigDict) == len(nodeList)):
         # backwards compatibility for test results without linktest mode indication
@@ -186,10 +661,11 @@ def extractData(testNo, testDir):
         testConfig['floodMode'] = 0
 
     if testConfig['p2pMode'] and not testConfig['floodMode']:
-        radioConfig = radioConfigDict[nodeList[0]]
+        radioConfigs = [radioConfigDict[nodeList[0]][k] for k in sorted(radioConfigDict[nodeList[0]])]
+        assert len(radioConfigs) == testConfig.get('numConfigs', 1)
         floodConfig = None
     elif testConfig['floodMode'] and not testConfig['p2pMode']:
-        radioConfig = None
+        radioConfigs = None
         floodConfig = floodConfigDict[nodeList[0]]
     else:
         raise Exception('TestConfig seems invalid!')
@@ -202,153 +678,530 @@ def extractData(testNo, testDir):
         if len(floodConfigDict) == len(nodeList):
             assert floodConfigDict[nodeList[0]] == floodConfigDict[node]
 
-    # Make sure that round boundaries do not overlap
-    if not assertionOverride:
-        stack = []
-        currentNode = -1
-        for d in dfd.data.to_list():
-            if d['type'] == 'StartOfRound':
-                if len(stack)==0:
-                    currentNode = d['node']
+    return testConfig, radioConfigs, floodConfig
+
+
+def serial2Dfd(serialPath):
+    '''Reads serial.csv into a dataframe and keeps only rows containing a json or binary record (decoded in column data)
+    '''
+    df = fl.serial2Df(serialPath, error='ignore')
+    df.sort_values(by=['timestamp', 'observer_id'], inplace=True, ignore_index=True)
+
+    # convert output with valid json (or binary records) to dict and remove other rows
+    keepMask = []
+    resList = []
+    logBlockChecker = LogBlockChecker()
+    for idx, row in df.iterrows():
+        jsonDict = getRecord(row['output'])
+        logBlockChecker.add(row['observer_id'], row['output'], jsonDict)
+        keepMask.append(1 if jsonDict else 0)
+        if jsonDict:
+            resList.append(jsonDict)
+    logBlockChecker.report()
+    dfd = df[np.asarray(keepMask).astype(bool)].copy()
+    dfd['data'] = resList
+
+    return dfd
+
+
+################################################################################
+# Streaming extraction
+################################################################################
+
+serialLineRegex = re.compile(r'^([0-9.]+),(\d+),(\d+),[^,]*,(.*)$')
+
+def iterSerialRecords(serialPath):
+    '''Reads a FlockLab serial.csv file line by line and yields (observer_id, record dict) for all lines containing a json or binary record.
+    '''
+    logBlockChecker = LogBlockChecker()
+    with open(serialPath, 'r', encoding='utf-8', errors='ignore') as f:
+        for line in f:
+            m = serialLineRegex.match(line)
+            if m is None:
+                continue
+            obs = int(m.group(2))
+            output = m.group(4)
+            idx = output.find('{')
+            rec = None
+            if idx >= 0:
+                try:
+                    rec = json.loads(output[idx:], strict=False)
+                except json.JSONDecodeError:
+                    print('WARNING: json could not be parsed: {}'.format(output[idx:]))
+            elif binRecMarker in output:
+                rec = getBinaryRecord(output)
+            logBlockChecker.add(obs, output, rec)
+            if rec is not None:
+                yield obs, rec
+    logBlockChecker.report()
+
+
+class LinkAccumulator():
+    '''Accumulated events of one round (identified by the radio config and the node of the round) on one observer.
+    '''
+    __slots__ = ('numTx', 'numRx', 'numCrcError', 'rssiSum', 'roundStats', 'numFloodsRx', 'hopSum', 'hopSqSum', 'numBitErrors', 'numBits', 'errorPosHist', 'numRxLen', 'numCrcErrorLen', 'txTsDict', 'rxTsList', 'clockFit', 'stateTime', 'pongDict', 'rxList', 'numTraces', 'slotRxCnt', 'slotRssiSum', 'delayDict')
+
+    def __init__(self):
+        self.numTx = 0
+        self.numRx = 0
+        self.numCrcError = 0
+        self.rssiSum = 0
+        self.roundStats = None
+        self.numFloodsRx = 0
+        self.hopSum = 0
+        self.hopSqSum = 0
+        self.numBitErrors = 0
+        self.numBits = 0
+        self.errorPosHist = None
+        self.numRxLen = None
+        self.numCrcErrorLen = None
+        self.txTsDict = None
+        self.rxTsList = None
+        self.clockFit = None
+        self.stateTime = None
+        self.pongDict = None
+        self.rxList = None
+        self.numTraces = 0
+        self.slotRxCnt = None
+        self.slotRssiSum = None
+        self.delayDict = None
+
+
+class StreamingExtractor():
+    '''Single pass extraction of link statistics. Records are dispatched directly into per (round, observer) accumulators,
+    i.e. memory consumption is bounded by the matrix size and not by the log size. The hs_timer timestamps of TxDone and RxDone
+    are paired while reading and only added to the running sums of the clock fit (ClockFit), timestamps are only buffered until
+    all observers have finished the round (with TESTCONFIG_LOG_ARENA, until the last node has dumped the round). Exceptions:
+    capture mode, parallel rounds and FLOODCONFIG_TRACE keep per-packet samples.
+    '''
+    def __init__(self):
+        self.testConfigDict = OrderedDict()
+        self.radioConfigDict = OrderedDict()
+        self.floodConfigDict = OrderedDict()
+        self.payloadLenDict = OrderedDict()   # observer -> list of PayloadLen records
+        self.payloadLens = {}                 # observer -> list of payload lengths (payload length sweep)
+        self.scheduleDict = OrderedDict()     # observer -> Schedule record (frequency-division parallel rounds)
+        self.captureConfigDict = OrderedDict()   # observer -> CaptureConfig record (capture mode)
+        self.floodCalibrationDict = OrderedDict()   # observer -> FloodCalibration record (adaptive floods)
+        self.floodDelays = set()                    # delay values of the delayed-TX floods (FLOODCONFIG_NUM_DELAYS > 1)
+        self.currentRound = {}     # observer -> (configIdx, node) of the current round (None if outside of a round)
+        self.acc = {}              # (configIdx, node of round, observer) -> LinkAccumulator
+        self.clockRounds = {}      # (configIdx, node of round) -> (slot -> tx timestamp, slot -> list of (LinkAccumulator, rx timestamp) without tx timestamp yet, observers which have finished the round)
+
+    def getClockRound(self, roundKey):
+        '''Returns the timestamps of the round used to pair TxDone and RxDone events (see ClockFit).
+        '''
+        r = self.clockRounds.get(roundKey)
+        if r is None:
+            r = self.clockRounds[roundKey] = ({}, {}, set())
+        return r
+
+    def endClockRound(self, roundKey, obs):
+        '''Drops the timestamps of the round as soon as all observers have finished it (the records of a round are not necessarily
+        close together in the log, e.g. with TESTCONFIG_LOG_ARENA every node dumps all of its rounds after the test).
+        '''
+        ended = self.getClockRound(roundKey)[2]
+        ended.add(obs)
+        if ended.issuperset(self.testConfigDict):
+            del self.clockRounds[roundKey]
+
+    def addClockTx(self, roundKey, slot, ts):
+        txTs, pending, _ = self.getClockRound(roundKey)
+        txTs[slot] = ts
+        for a, rxTs in pending.pop(slot, []):
+            a.clockFit.add(ts, rxTs)
+
+    def addClockRx(self, roundKey, a, counter, ts):
+        txTs, pending, _ = self.getClockRound(roundKey)
+        if a.clockFit is None:
+            a.clockFit = ClockFit()
+        if counter in txTs:
+            a.clockFit.add(txTs[counter], ts)
+        else:
+            pending.setdefault(counter, []).append((a, ts))
+
+    def add(self, obs, d):
+        recType = d['type']
+        roundKey = self.currentRound.get(obs)
+        if roundKey is not None and recType not in ('StartOfRound', 'EndOfRound'):
+            key = roundKey + (obs,)
+            a = self.acc.get(key)
+            if a is None:
+                a = self.acc[key] = LinkAccumulator()
+            if recType == 'RxDone':
+                testConfig = self.testConfigDict.get(obs, {})
+                validRx = (d['crc_error'] == 0 and 'key' in testConfig and isKeyValid(d, testConfig))
+                if testConfig.get('numChannels', 1) > 1 or testConfig.get('captureMode', 0):
+                    # transmitter is determined by the schedule (see getScheduleMatrices()) or by the slot (see getCaptureStats())
+                    if a.rxList is None:
+                        a.rxList = []
+                    a.rxList.append((d['counter'], validRx, d['crc_error'] == 1, d['rssi']))
+                elif d['crc_error'] == 1:
+                    a.numCrcError += 1
+                elif validRx:
+                    a.numRx += 1
+                    a.rssiSum += d['rssi']
+                    if 'ts_sync' in d and d['ts_sync'] > 0:
+                        self.addClockRx(roundKey, a, d['counter'], d['ts_sync'])
+                payloadLens = self.payloadLens.get(obs)
+                if payloadLens and (validRx or d['crc_error'] == 1):
+                    lenIdx = getPayloadLenIdx(d, payloadLens)
+                    if lenIdx is not None:
+                        if a.numRxLen is None:
+                            a.numRxLen = np.zeros(len(payloadLens))
+                            a.numCrcErrorLen = np.zeros(len(payloadLens))
+                        if validRx:
+                            a.numRxLen[lenIdx] += 1
+                        else:
+                            a.numCrcErrorLen[lenIdx] += 1
+            elif recType == 'TxDone':
+                a.numTx += 1
+                if 'ts' in d:
+                    if self.testConfigDict.get(obs, {}).get('captureMode', 0):
+                        # timestamps of both transmitters per slot (see getCaptureStats())
+                        if a.txTsDict is None:
+                            a.txTsDict = {}
+                        a.txTsDict[d['slot']] = d['ts']
+                    elif obs == roundKey[1]:
+                        self.addClockTx(roundKey, d['slot'], d['ts'])
+            elif recType == 'FloodDone':
+                if 'delay_tx' in d:
+                    self.floodDelays.add(d['delay_tx'])
+                if d['rx_cnt'] > 0 and d['is_initiator'] == 0:
+                    hop = d['rx_idx'] + 1
+                    a.numFloodsRx += 1
+                    a.hopSum += hop
+                    a.hopSqSum += hop*hop
+                    if 'delay_tx' in d:
+                        # number of received floods, sum and squared sum of the hop distance per delay value
+                        if a.delayDict is None:
+                            a.delayDict = {}
+                        s = a.delayDict.setdefault(d['delay_tx'], [0, 0, 0])
+                        s[0] += 1
+                        s[1] += hop
+                        s[2] += hop*hop
+            elif recType == 'FloodTrace':
+                floodConfig = self.floodConfigDict.get(obs, {})
+                addFloodTrace(a, d, floodConfig.get('nTx', 0) + floodConfig.get('numHops', 0) - 1)
+            elif recType == 'RoundStats':
+                a.roundStats = d
+            elif recType == 'Pong':
+                # replies are logged by the tx node of the round: replying node -> [number of replies, sum and max of the turnaround time]
+                if a.pongDict is None:
+                    a.pongDict = {}
+                p = a.pongDict.setdefault(d['node'], [0, 0, -np.inf])
+                p[0] += 1
+                p[1] += d['turnaround']
+                p[2] = max(p[2], d['turnaround'])
+            elif recType == 'StateTime':
+                a.stateTime = getStateTimes(d) if a.stateTime is None else a.stateTime + getStateTimes(d)
+            elif recType == 'BitErrors':
+                # payload is a PRBS instead of the key (TESTCONFIG_BER_MODE)
+                if d['crc_error'] == 1:
+                    a.numCrcError += 1
+                elif d['bitErrors'] >= 0:
+                    a.numRx += 1
+                    a.rssiSum += d['rssi']
+                if d['bitErrors'] >= 0:
+                    a.numBitErrors += d['bitErrors']
+                    a.numBits += 8*d['size']
+                    if a.errorPosHist is None:
+                        a.errorPosHist = np.zeros(8*d['size'], dtype=np.uint32)
+                    np.add.at(a.errorPosHist, getBitErrorPositions(d), 1)
+        elif recType == 'StartOfRound':
+            if not assertionOverride:
+                assert roundKey is None, 'overlapping rounds on observer {}'.format(obs)
+            self.currentRound[obs] = (d.get('config', 0), d['node'])
+        elif recType == 'EndOfRound':
+            if not assertionOverride:
+                assert roundKey == (d.get('config', 0), d['node']), 'round boundaries do not match on observer {}'.format(obs)
+            if roundKey is not None:
+                self.endClockRound(roundKey, obs)
+            self.currentRound[obs] = None
+        elif recType == 'TestConfig':
+            self.testConfigDict.setdefault(obs, d)
+        elif recType == 'RadioConfig':
+            self.radioConfigDict.setdefault(obs, OrderedDict()).setdefault(d.get('configIdx', 0), d)
+        elif recType == 'FloodConfig':
+            self.floodConfigDict.setdefault(obs, d)
+        elif recType == 'Schedule':
+            self.scheduleDict.setdefault(obs, d)
+        elif recType == 'CaptureConfig':
+            self.captureConfigDict.setdefault(obs, d)
+        elif recType == 'FloodCalibration':
+            self.floodCalibrationDict.setdefault(obs, d)
+        elif recType == 'PayloadLen':
+            self.payloadLenDict.setdefault(obs, []).append(d)
+            self.payloadLens[obs] = getPayloadLens(self.payloadLenDict[obs])[0]
+
+    def getData(self):
+        '''Returns a list of extracted results (one per radio config).
+        '''
+        nodeList = sorted(self.testConfigDict.keys())
+        testConfig, radioConfigs, floodConfig = checkConfigs(nodeList, self.testConfigDict, self.radioConfigDict, self.floodConfigDict)
+
+        if testConfig['p2pMode'] and (not testConfig['floodMode']):
+            return [self.getP2pData(testConfig, nodeList, configIdx, radioConfig) for configIdx, radioConfig in enumerate(radioConfigs)]
+        elif testConfig['floodMode'] and (not testConfig['p2pMode']):
+            return [self.getFloodData(testConfig, nodeList, floodConfig)]
+        return []
+
+    def getP2pData(self, testConfig, nodeList, configIdx, radioConfig):
+        numNodes = len(nodeList)
+        nodeIdx = {node: idx for idx, node in enumerate(nodeList)}
+        pathlossMatrix = np.full( (numNodes, numNodes,), np.nan )
+        prrMatrix = np.full( (numNodes, numNodes,), np.nan )
+        crcErrorMatrix = np.full( (numNodes, numNodes,), np.nan )
+        gapHistMatrix = None
+        parallelRounds = testConfig.get('numChannels', 1) > 1 or testConfig.get('captureMode', 0)
+        if testConfig.get('numChannels', 1) > 1:
+            # frequency-division parallel rounds: packets of several transmitters per round
+            rxRecs = [(roundNode, obs) + rec for (cfgIdx, roundNode, obs), a in self.acc.items() if cfgIdx == configIdx and a.rxList for rec in a.rxList]
+            pathlossMatrix, prrMatrix, crcErrorMatrix = getScheduleMatrices(testConfig, radioConfig, nodeList, self.scheduleDict[nodeList[0]], rxRecs)
+        elif testConfig.get('captureMode', 0):
+            # concurrent transmissions of two nodes per round
+            rounds = []
+            for roundNode in nodeList:
+                accs = [(node, self.acc.get((configIdx, roundNode, node), LinkAccumulator())) for node in nodeList]
+                rounds.append((roundNode, OrderedDict((node, a.rxList or []) for node, a in accs), OrderedDict((node, a.txTsDict or {}) for node, a in accs)))
+            pathlossMatrix, prrMatrix, crcErrorMatrix, captureSamples = getCaptureStats(testConfig, radioConfig, nodeList, self.captureConfigDict[nodeList[0]], rounds)
+        for txNode in (nodeList if not parallelRounds else []):
+            txNodeIdx = nodeIdx[txNode]
+            a = self.acc.get((configIdx, txNode, txNode), LinkAccumulator())
+            numTx = a.roundStats['numTx'] if a.roundStats else a.numTx
+            assert numTx == testConfig['numTx']
+            for rxNode in nodeList:
+                if rxNode == txNode:
+                    continue
+                rxNodeIdx = nodeIdx[rxNode]
+                a = self.acc.get((configIdx, txNode, rxNode), LinkAccumulator())
+                if a.roundStats:
+                    # events have already been aggregated on the node (TESTCONFIG_LOG_STATS)
+                    rs = a.roundStats
+                    numRx, numCrcError, rssiSum = rs['numRx'], rs['numCrcError'], rs['rssiSum']
+                    if gapHistMatrix is None:
+                        gapHistMatrix = np.zeros( (numNodes, numNodes, len(rs['gapHist'])) )
+                    gapHistMatrix[txNodeIdx][rxNodeIdx] = rs['gapHist']
                 else:
-                    assert d['node'] == stack[-1]
-                stack.append(d['node'])
-            elif d['type'] == 'EndOfRound':
-                assert d['node'] == stack.pop()
-
-    # collect extracted data (including nodeList to resolve idx <-> node ID relations)
-    d = {
-        'testConfig': testConfig,
-        'nodeList': nodeList,
-    }
-    if testConfig['p2pMode'] and (not testConfig['floodMode']):
-        pathlossMatrix, prrMatrix, crcErrorMatrix = extractP2pStats(dfd, testConfig, radioConfig)
+                    numRx, numCrcError, rssiSum = a.numRx, a.numCrcError, a.rssiSum
+                if numRx:
+                    pathlossMatrix[txNodeIdx][rxNodeIdx] = -(rssiSum/numRx - radioConfig['txPower'])
+                prrMatrix[txNodeIdx][rxNodeIdx] = numRx/numTx
+                crcErrorMatrix[txNodeIdx][rxNodeIdx] = numCrcError/numTx
+        d = {
+            'testConfig': testConfig,
+            'nodeList': nodeList,
+            'configIdx': configIdx,
+        }
         d['radioConfig'] = radioConfig
         d['prrMatrix'] = prrMatrix
         d['crcErrorMatrix'] = crcErrorMatrix
         d['pathlossMatrix'] = pathlossMatrix
-    elif testConfig['floodMode'] and (not testConfig['p2pMode']):
-        if floodConfig['delayTx'] == 0:
-            numFloodsRxMatrix, hopDistanceMatrix, hopDistanceStdMatrix = extractFloodNormal(dfd, testConfig, floodConfig)
-        else: # floods with delayed Tx
-            numFloodsRxMatrix, hopDistanceMatrix, hopDistanceStdMatrix = extractFloodDelayedTx(dfd, testConfig, floodConfig)
+        if gapHistMatrix is not None:
+            d['gapHistMatrix'] = gapHistMatrix
+        if testConfig.get('captureMode', 0):
+            d['captureSamples'] = captureSamples
+        if testConfig.get('berMode', 0):
+            numBits = 8*(2 + testConfig['berPayloadLen'])
+            berMatrix = np.full( (numNodes, numNodes,), np.nan )
+            errorPosHistMatrix = np.zeros( (numNodes, numNodes, numBits), dtype=np.uint32 )
+            for (cfgIdx, txNode, rxNode), a in self.acc.items():
+                if cfgIdx == configIdx and a.numBits:
+                    berMatrix[nodeIdx[txNode]][nodeIdx[rxNode]] = a.numBitErrors/a.numBits
+                    errorPosHistMatrix[nodeIdx[txNode]][nodeIdx[rxNode]] = a.errorPosHist
+            d['berMatrix'] = berMatrix
+            d['errorPosHistMatrix'] = errorPosHistMatrix
+        if testConfig.get('numPayloadLens', 1) > 1:
+            d['payloadLens'], d['timeOnAir'] = getPayloadLens(self.payloadLenDict[nodeList[0]], configIdx)
+            numLens = len(d['payloadLens'])
+            # slots cycle through the payload lengths
+            numTxLen = np.bincount(np.arange(testConfig['numTx']) % numLens, minlength=numLens)
+            numTxLen = np.where(numTxLen > 0, numTxLen, np.nan)
+            prrLenMatrix = np.full( (numNodes, numNodes, numLens), np.nan )
+            crcErrorLenMatrix = np.full( (numNodes, numNodes, numLens), np.nan )
+            for txNode in nodeList:
+                for rxNode in nodeList:
+                    if rxNode == txNode:
+                        continue
+                    a = self.acc.get((configIdx, txNode, rxNode), LinkAccumulator())
+                    numRxLen = a.numRxLen if a.numRxLen is not None else np.zeros(numLens)
+                    numCrcErrorLen = a.numCrcErrorLen if a.numCrcErrorLen is not None else np.zeros(numLens)
+                    prrLenMatrix[nodeIdx[txNode]][nodeIdx[rxNode]] = numRxLen/numTxLen
+                    crcErrorLenMatrix[nodeIdx[txNode]][nodeIdx[rxNode]] = numCrcErrorLen/numTxLen
+            d['prrLenMatrix'] = prrLenMatrix
+            d['crcErrorLenMatrix'] = crcErrorLenMatrix
+        # clock and energy statistics are based on the rounds of single transmitters (not available with parallel rounds or concurrent transmissions)
+        if 'hsTimerFreq' in testConfig and not parallelRounds:
+            clockOffsetMatrix = np.full( (numNodes, numNodes,), np.nan )
+            clockDriftMatrix = np.full( (numNodes, numNodes,), np.nan )
+            syncJitterMatrix = np.full( (numNodes, numNodes,), np.nan )
+            for txNode in nodeList:
+                for rxNode in nodeList:
+                    if rxNode == txNode:
+                        continue
+                    clockFit = self.acc.get((configIdx, txNode, rxNode), LinkAccumulator()).clockFit
+                    clockOffsetMatrix[nodeIdx[txNode]][nodeIdx[rxNode]], clockDriftMatrix[nodeIdx[txNode]][nodeIdx[rxNode]], syncJitterMatrix[nodeIdx[txNode]][nodeIdx[rxNode]] = fitClock(clockFit, testConfig['hsTimerFreq'])
+            if not np.all(np.isnan(clockOffsetMatrix)):
+                d['clockOffsetMatrix'] = clockOffsetMatrix
+                d['clockDriftMatrix'] = clockDriftMatrix
+                d['syncJitterMatrix'] = syncJitterMatrix
+        if testConfig.get('pingPong', 0):
+            numPongMatrix = np.zeros( (numNodes, numNodes,) )
+            turnaroundSumMatrix = np.zeros( (numNodes, numNodes,) )
+            turnaroundMaxMatrix = np.full( (numNodes, numNodes,), -np.inf )
+            for txNode in nodeList:
+                pongDict = self.acc.get((configIdx, txNode, txNode), LinkAccumulator()).pongDict or {}
+                for rxNode, (numPong, turnaroundSum, turnaroundMax) in pongDict.items():
+                    if rxNode in nodeIdx:
+                        numPongMatrix[nodeIdx[txNode]][nodeIdx[rxNode]] = numPong
+                        turnaroundSumMatrix[nodeIdx[txNode]][nodeIdx[rxNode]] = turnaroundSum
+                        turnaroundMaxMatrix[nodeIdx[txNode]][nodeIdx[rxNode]] = turnaroundMax
+            d['pongPrrMatrix'], d['reversePrrMatrix'], d['turnaroundMatrix'], d['turnaroundMaxMatrix'] = getPingPongMatrices(numPongMatrix, turnaroundSumMatrix, turnaroundMaxMatrix, prrMatrix, testConfig['numTx'])
+        stateTimeMatrix = np.full( (numNodes, numNodes, len(STATE_TIME_KEYS)), np.nan )
+        for (cfgIdx, roundNode, obs), a in self.acc.items():
+            if cfgIdx == configIdx and a.stateTime is not None:
+                stateTimeMatrix[nodeIdx[roundNode]][nodeIdx[obs]] = a.stateTime
+        if not np.all(np.isnan(stateTimeMatrix)) and not parallelRounds:
+            d['stateTimeMatrix'] = stateTimeMatrix
+            d['energyMatrix'], d['energyPerPacketMatrix'] = getEnergyPerPacket(stateTimeMatrix, prrMatrix, testConfig['numTx'], radioConfig['txPower'])
+        return d
+
+    def getFloodData(self, testConfig, nodeList, floodConfig):
+        # rounds are identified by the initiator (delayTx==0) or by the delayed node (delayTx!=0)
+        numNodes = len(nodeList)
+        nodeIdx = {node: idx for idx, node in enumerate(nodeList)}
+        numFloodsRxMatrix = np.full( (numNodes, numNodes,), np.nan )
+        hopDistanceMatrix = np.full( (numNodes, numNodes,), np.nan )
+        hopDistanceStdMatrix = np.full( (numNodes, numNodes,), np.nan )
+        for roundNode in nodeList:
+            for rxNode in nodeList:
+                a = self.acc.get((0, roundNode, rxNode), LinkAccumulator())
+                numFloodsRxMatrix[nodeIdx[roundNode]][nodeIdx[rxNode]] = a.numFloodsRx
+                if a.numFloodsRx:
+                    mean = a.hopSum/a.numFloodsRx
+                    hopDistanceMatrix[nodeIdx[roundNode]][nodeIdx[rxNode]] = mean
+                    hopDistanceStdMatrix[nodeIdx[roundNode]][nodeIdx[rxNode]] = np.sqrt(max(0, a.hopSqSum/a.numFloodsRx - mean**2))
+        d = {
+            'testConfig': testConfig,
+            'nodeList': nodeList,
+        }
         d['floodConfig'] = floodConfig
         d['numFloodsRxMatrix'] = numFloodsRxMatrix
         d['hopDistanceMatrix'] = hopDistanceMatrix
         d['hopDistanceStdMatrix'] = hopDistanceStdMatrix
-    # save obtained data to file
-    pklPath = os.path.join(outputDir, 'linktest_data_{}.pkl'.format(testNo))
-    os.makedirs(os.path.split(pklPath)[0], exist_ok=True)
-    with open(pklPath, 'wb' ) as f:
-        pickle.dump(d, f)
-
-    return d
-
-
-def extractP2pStats(dfd, testConfig, radioConfig):
-    groups = dfd.groupby('observer_id')
-    nodeList = sorted(dfd.observer_id.unique())
-    numNodes = len(nodeList)
-
-    # prepare
-    pathlossMatrix = np.empty( (numNodes, numNodes,) ) * np.nan  # path loss
-    prrMatrix = np.empty( (numNodes, numNodes,) ) * np.nan       # packet reception ratio (PRR)
-    crcErrorMatrix = np.empty( (numNodes, numNodes,) ) * np.nan  # ratio of packets with CRC error
-
-    # iterate over rounds
-    for nodeOfRound in nodeList:
-        txNode = nodeOfRound
-        txNodeIdx = nodeList.index(txNode)
-
-        numTx = 0
-        numRxDict = OrderedDict()
-        numCrcErrorDict = OrderedDict()
-        rssiAvgDict = OrderedDict()
-        # iterate over nodes
-        for node in nodeList:
-            rows = getRows(nodeOfRound, groups.get_group(node))
-            if node == txNode:
-                txDoneList = [elem for elem in rows if (elem['type']=='TxDone')]
-                numTx = len(txDoneList)
-                assert numTx == testConfig['numTx']
-            else:
-                rxDoneList = [elem for elem in rows if (elem['type']=='RxDone' and elem['key']==testConfig['key'] and elem['crc_error']==0)]
-                crcErrorList = [elem for elem in rows if (elem['type']=='RxDone' and elem['crc_error']==1)]
-                numRxDict[node] = len(rxDoneList)
-                numCrcErrorDict[node] = len(crcErrorList)
-                rssiAvgDict[node] = np.mean([elem['rssi'] for elem in rxDoneList]) if len(rxDoneList) else np.nan
-
-        # fill path loss matrix
-        for rxNode, rssi in rssiAvgDict.items():
-            rxNodeIdx = nodeList.index(rxNode)
-            pathlossMatrix[txNodeIdx][rxNodeIdx] = -(rssi - radioConfig['txPower'])
-
-        # fill PRR matrix
-        for rxNode, numRx in numRxDict.items():
-            rxNodeIdx = nodeList.index(rxNode)
-            prrMatrix[txNodeIdx][rxNodeIdx] = numRx/numTx
-
-        # fill CRC error matrix
-        for rxNode, numCrcError in numCrcErrorDict.items():
-            rxNodeIdx = nodeList.index(rxNode)
-            crcErrorMatrix[txNodeIdx][rxNodeIdx] = numCrcError/numTx
-        # NOTE: some CRC error cases are ignored while getting the rows (getRows()) because the json parser cannot parse the RxDone output
-
-    return pathlossMatrix, prrMatrix, crcErrorMatrix
+        if floodConfig.get('adaptive', 0):
+            d['floodNumHops'], d['floodSlotTime'] = getFloodCalibration(nodeList, self.floodCalibrationDict)
+        if floodConfig.get('numDelays', 1) > 1:
+            delays = sorted(self.floodDelays)
+            numFloodsRxDelayMatrix = np.full( (numNodes, numNodes, len(delays),), np.nan )
+            hopDistanceDelayMatrix = np.full( (numNodes, numNodes, len(delays),), np.nan )
+            hopDistanceStdDelayMatrix = np.full( (numNodes, numNodes, len(delays),), np.nan )
+            for roundNode in nodeList:
+                for rxNode in nodeList:
+                    a = self.acc.get((0, roundNode, rxNode), LinkAccumulator())
+                    for delayIdx, delay in enumerate(delays):
+                        n, hopSum, hopSqSum = (a.delayDict or {}).get(delay, (0, 0, 0))
+                        numFloodsRxDelayMatrix[nodeIdx[roundNode]][nodeIdx[rxNode]][delayIdx] = n
+                        if n:
+                            mean = hopSum/n
+                            hopDistanceDelayMatrix[nodeIdx[roundNode]][nodeIdx[rxNode]][delayIdx] = mean
+                            hopDistanceStdDelayMatrix[nodeIdx[roundNode]][nodeIdx[rxNode]][delayIdx] = np.sqrt(max(0, hopSqSum/n - mean**2))
+            d['floodDelays'] = np.array(delays)
+            d['numFloodsRxDelayMatrix'] = numFloodsRxDelayMatrix
+            d['hopDistanceDelayMatrix'] = hopDistanceDelayMatrix
+            d['hopDistanceStdDelayMatrix'] = hopDistanceStdDelayMatrix
+        if floodConfig.get('trace', 0):
+            numSlots = floodConfig['nTx'] + floodConfig['numHops'] - 1
+            accDict = {(roundNode, obs): a for (configIdx, roundNode, obs), a in self.acc.items()}
+            d['floodSlotRxMatrix'], d['floodSlotRssiMatrix'], d['syncErrorMatrix'], d['syncErrors'] = getFloodTraceMatrices(nodeList, accDict, numSlots, testConfig['hsTimerFreq'])
+        return d
+
+
+def extractDataStreaming(serialPath):
+    extractor = StreamingExtractor()
+    for obs, rec in iterSerialRecords(serialPath):
+        extractor.add(obs, rec)
+    return extractor.getData()
+
+
+def extractDataPandas(serialPath):
+    '''Same as extractDataStreaming(), but the records are read with the dataframe of the flocklab tools (sorted by timestamp)
+    '''
+    dfd = serial2Dfd(serialPath)
+    extractor = StreamingExtractor()
+    for obs, rec in zip(dfd.observer_id.to_list(), dfd.data.to_list()):
+        extractor.add(obs, rec)
+    return extractor.getData()
 
 
-def extractFloodNormal(dfd, testConfig, floodConfig):
-    groups = dfd.groupby('observer_id')
-    nodeList = sorted(dfd.observer_id.unique())
-    numNodes = len(nodeList)
-    numFloodsRxMatrix = np.empty( (numNodes, numNodes,) ) * np.nan
-    hopDistanceMatrix = np.empty( (numNodes, numNodes,) ) * np.nan
-    hopDistanceStdMatrix = np.empty( (numNodes, numNodes,) ) * np.nan
-
-    # iterate over rounds
-    for nodeOfRound in nodeList:
-        txNode = nodeOfRound
-        txNodeIdx = nodeList.index(txNode)
-        # iterate over nodes
-        for rxNode in nodeList:
-            rxNodeIdx = nodeList.index(rxNode)
-            rows = getRows(txNode, groups.get_group(rxNode))
-            floodRxList = [elem for elem in rows if (elem['type']=='FloodDone' and elem['rx_cnt']>0 and elem['is_initiator']==0)]
-            # fill matrix
-            numFloodsRxMatrix[txNodeIdx][rxNodeIdx] = len(floodRxList)
-            hopDistanceMatrix[txNodeIdx][rxNodeIdx] = np.mean([elem['rx_idx']+1 for elem in floodRxList]) if len(floodRxList) else np.nan
-            hopDistanceStdMatrix[txNodeIdx][rxNodeIdx] = np.std([elem['rx_idx']+1 for elem in floodRxList]) if len(floodRxList) else np.nan
-
-    return numFloodsRxMatrix, hopDistanceMatrix, hopDistanceStdMatrix
-
-
-def extractFloodDelayedTx(dfd, testConfig, floodConfig):
-    groups = dfd.groupby('observer_id')
-    nodeList = sorted(dfd.observer_id.unique())
+def getFloodCalibration(nodeList, floodCalibrationDict):
+    '''Returns the hop budget and the slot time [ms] used by every node after the calibration floods (FLOODCONFIG_ADAPTIVE),
+    nan for nodes without a FloodCalibration record. Nodes which missed all feedback floods keep the full hop budget.
+    '''
+    floodNumHops = np.full(len(nodeList), np.nan)
+    floodSlotTime = np.full(len(nodeList), np.nan)
+    for nodeIdx, node in enumerate(nodeList):
+        d = floodCalibrationDict.get(node)
+        if d is not None:
+            floodNumHops[nodeIdx] = d['numHops']
+            floodSlotTime[nodeIdx] = d['slotTime']
+    validHops = floodNumHops[~np.isnan(floodNumHops)]
+    if len(validHops) and np.any(validHops != validHops[0]):
+        print('WARNING: hop budget differs between nodes (missed feedback floods?): {}'.format({int(node): int(numHops) for node, numHops in zip(nodeList, floodNumHops) if not np.isnan(numHops)}))
+    return floodNumHops, floodSlotTime
+
+
+def addFloodTrace(a, d, numSlots):
+    '''Adds a FloodTrace record to the LinkAccumulator a of the round: received packets and RSSI per slot of the flood,
+    t_ref of the initiator (txTsDict, counter -> t_ref) and of the receivers (rxTsList) for the sync error
+    '''
+    if a.slotRxCnt is None:
+        a.slotRxCnt = np.zeros(numSlots)
+        a.slotRssiSum = np.zeros(numSlots)
+    a.numTraces += 1
+    for slot, rssi in zip(d['rx_slots'], d['rssi']):
+        if slot < numSlots:
+            a.slotRxCnt[slot] += 1
+            a.slotRssiSum[slot] += rssi
+    if d['is_initiator']:
+        if a.txTsDict is None:
+            a.txTsDict = {}
+        a.txTsDict[d['counter']] = d['t_ref']
+    elif d['t_ref'] > 0:
+        if a.rxTsList is None:
+            a.rxTsList = []
+        a.rxTsList.append((d['counter'], d['t_ref']))
+
+
+def getFloodTraceMatrices(nodeList, accDict, numSlots, hsTimerFreq):
+    '''Returns the per-slot statistics of the floods (FLOODCONFIG_TRACE) from the LinkAccumulators (node of round, observer) -> LinkAccumulator:
+        floodSlotRxMatrix (ratio of floods with a packet received in slot i, rows: node of the round, columns: rx node, 3rd dim: slot),
+        floodSlotRssiMatrix (mean RSSI per slot), syncErrorMatrix (std of the t_ref residuals [us]) and syncErrors (residuals of all links [us])
+    The sync error is the deviation of the t_ref of a receiver from the t_ref of the initiator after removing the clock offset and drift (see getClockResiduals()).
+    '''
     numNodes = len(nodeList)
-    numFloodsRxMatrix = np.empty( (numNodes, numNodes,) ) * np.nan
-    hopDistanceMatrix = np.empty( (numNodes, numNodes,) ) * np.nan
-    hopDistanceStdMatrix = np.empty( (numNodes, numNodes,) ) * np.nan
-
-    # iterate over rounds
-    for nodeOfRound in nodeList:
-        delayedNode = nodeOfRound
-        delayedNodeIdx = nodeList.index(delayedNode)
-        # iterate over nodes
-        for rxNode in nodeList:
-            rxNodeIdx = nodeList.index(rxNode)
-            rows = getRows(delayedNode, groups.get_group(rxNode))
-            floodRxList = [elem for elem in rows if (elem['type']=='FloodDone' and elem['rx_cnt']>0 and elem['is_initiator']==0)]
-            # fill matrix
-            # hop distance = rx_idx + 1
-            numFloodsRxMatrix[delayedNodeIdx][rxNodeIdx] = len(floodRxList)
-            hopDistanceMatrix[delayedNodeIdx][rxNodeIdx] = np.mean([elem['rx_idx']+1 for elem in floodRxList]) if len(floodRxList) else np.nan
-            hopDistanceStdMatrix[delayedNodeIdx][rxNodeIdx] = np.std([elem['rx_idx']+1 for elem in floodRxList]) if len(floodRxList) else np.nan
-
-    return numFloodsRxMatrix, hopDistanceMatrix, hopDistanceStdMatrix
-
-
-def saveP2pMatricesToHtml(extractionDict):
+    floodSlotRxMatrix = np.full( (numNodes, numNodes, numSlots,), np.nan )
+    floodSlotRssiMatrix = np.full( (numNodes, numNodes, numSlots,), np.nan )
+    syncErrorMatrix = np.full( (numNodes, numNodes,), np.nan )
+    syncErrors = []
+    for roundNodeIdx, roundNode in enumerate(nodeList):
+        accs = [accDict.get((roundNode, node)) for node in nodeList]
+        txTsDicts = [a.txTsDict for a in accs if a is not None and a.txTsDict]
+        for rxNodeIdx, a in enumerate(accs):
+            if a is None or not a.numTraces:
+                continue
+            floodSlotRxMatrix[roundNodeIdx][rxNodeIdx] = a.slotRxCnt/a.numTraces
+            with np.errstate(invalid='ignore', divide='ignore'):
+                floodSlotRssiMatrix[roundNodeIdx][rxNodeIdx] = np.where(a.slotRxCnt > 0, a.slotRssiSum/a.slotRxCnt, np.nan)
+            residuals = getClockResiduals(txTsDicts[0], a.rxTsList) if (txTsDicts and a.rxTsList) else None
+            if residuals is not None:
+                residuals = residuals/hsTimerFreq*1e6
+                syncErrorMatrix[roundNodeIdx][rxNodeIdx] = np.std(residuals)
+                syncErrors.extend(residuals)
+    return floodSlotRxMatrix, floodSlotRssiMatrix, syncErrorMatrix, np.array(syncErrors)
+
+
+def saveP2pMatricesToHtml(extractionDict, testNo):
     nodeList = extractionDict['nodeList']
 
     prrMatrixDf = pd.DataFrame(data=extractionDict['prrMatrix'], index=nodeList, columns=nodeList)
@@ -414,8 +1267,156 @@ def saveP2pMatricesToHtml(extractionDict):
     with open(htmlPath,"w") as fp:
        fp.write(h.render())
 
+    if 'berMatrix' in extractionDict:
+        saveBitErrorsToHtml(extractionDict, testNo)
+    if 'prrLenMatrix' in extractionDict:
+        savePayloadLenToHtml(extractionDict, testNo)
+    if 'clockOffsetMatrix' in extractionDict:
+        saveClockToHtml(extractionDict, testNo)
+    if 'energyPerPacketMatrix' in extractionDict:
+        saveEnergyToHtml(extractionDict, testNo)
+    if 'reversePrrMatrix' in extractionDict:
+        savePingPongToHtml(extractionDict, testNo)
+    if 'captureSamples' in extractionDict:
+        saveCaptureToHtml(extractionDict, testNo)
+
+
+def saveBitErrorsToHtml(extractionDict, testNo):
+    nodeList = extractionDict['nodeList']
+    berMatrixDf = pd.DataFrame(data=extractionDict['berMatrix'], index=nodeList, columns=nodeList)
+    # error positions of all links (rows: payload byte, columns: bit within the byte, MSB first)
+    errorPosHist = np.sum(extractionDict['errorPosHistMatrix'], axis=(0, 1))
+    errorPosHistDf = pd.DataFrame(data=errorPosHist.reshape(-1, 8), columns=['bit{}'.format(i) for i in range(8)])
+    errorPosHistDf.index.name = 'byte'
+
+    saveMatricesToHtml(
+        [berMatrixDf, errorPosHistDf],
+        '{}_ber.html'.format(testNo),
+        ['BER Matrix', 'Error Position Histogram (all links)'],
+        ['inferno_r', 'YlGnBu'],
+        ['{:.1e}', '{:.0f}'],
+        applymaps=[lambda x: 'background: white' if pd.isnull(x) else '', lambda x: ''],
+        outputDir=outputDir,
+    )
+
+
+def savePayloadLenToHtml(extractionDict, testNo):
+    nodeList = extractionDict['nodeList']
+    payloadLens = np.array(extractionDict['payloadLens'])
+    prrLenMatrix = extractionDict['prrLenMatrix']
+    crcErrorLenMatrix = extractionDict['crcErrorLenMatrix']
+
+    # PRR and CRC error curves of all links with at least one received packet (rows: tx->rx, columns: payload length)
+    links = [(txIdx, rxIdx) for txIdx in range(len(nodeList)) for rxIdx in range(len(nodeList))
+             if np.nansum(prrLenMatrix[txIdx][rxIdx]) + np.nansum(crcErrorLenMatrix[txIdx][rxIdx]) > 0]
+    linkNames = ['{}->{}'.format(nodeList[txIdx], nodeList[rxIdx]) for txIdx, rxIdx in links]
+    columns = ['{}B'.format(l) for l in payloadLens]
+    prrLenDf = pd.DataFrame(data=[prrLenMatrix[txIdx][rxIdx] for txIdx, rxIdx in links], index=linkNames, columns=columns)
+    crcErrorLenDf = pd.DataFrame(data=[crcErrorLenMatrix[txIdx][rxIdx] for txIdx, rxIdx in links], index=linkNames, columns=columns)
+
+    # goodput (key bytes per time-on-air) and the payload length which maximizes it per link
+    goodput = np.nan_to_num(prrLenMatrix * 8*(payloadLens - 2) / np.array(extractionDict['timeOnAir']) * 1e3)   # [kbit/s]
+    maxGoodput = goodput.max(axis=2)
+    bestLenMatrix = np.where(maxGoodput > 0, payloadLens[goodput.argmax(axis=2)], np.nan)
+    maxGoodputMatrix = np.where(maxGoodput > 0, maxGoodput, np.nan)
+
+    saveMatricesToHtml(
+        [prrLenDf, crcErrorLenDf,
+         pd.DataFrame(data=bestLenMatrix, index=nodeList, columns=nodeList), pd.DataFrame(data=maxGoodputMatrix, index=nodeList, columns=nodeList)],
+        '{}_payload.html'.format(testNo),
+        ['PRR vs. Payload Length', 'CRC Error Ratio vs. Payload Length', 'Payload Length with max. Goodput [B]', 'Max. Goodput [kbit/s]'],
+        ['inferno', 'YlGnBu', 'YlGnBu', 'inferno'],
+        ['{:.2f}', '{:.2f}', '{:.0f}', '{:.2f}'],
+        applymaps=[lambda x: 'background: white' if pd.isnull(x) else '']*4,
+        outputDir=outputDir,
+    )
+
+
+def saveClockToHtml(extractionDict, testNo):
+    nodeList = extractionDict['nodeList']
+    # rows: tx node (reference clock), columns: rx node
+    clockOffsetMatrixDf = pd.DataFrame(data=extractionDict['clockOffsetMatrix'], index=nodeList, columns=nodeList)
+    clockDriftMatrixDf = pd.DataFrame(data=extractionDict['clockDriftMatrix'], index=nodeList, columns=nodeList)
+    syncJitterMatrixDf = pd.DataFrame(data=extractionDict['syncJitterMatrix'], index=nodeList, columns=nodeList)
+
+    saveMatricesToHtml(
+        [clockOffsetMatrixDf, clockDriftMatrixDf, syncJitterMatrixDf],
+        '{}_clock.html'.format(testNo),
+        ['Clock Offset Rx - Tx [us] (at the first received packet, incl. TxDone to sync word delay)', 'Clock Drift Rx - Tx [ppm]', 'Sync Jitter [us]'],
+        ['coolwarm', 'coolwarm', 'YlGnBu'],
+        ['{:.0f}', '{:.2f}', '{:.1f}'],
+        applymaps=[lambda x: 'background: white' if pd.isnull(x) else '']*3,
+        outputDir=outputDir,
+    )
+
+
+def savePingPongToHtml(extractionDict, testNo):
+    nodeList = extractionDict['nodeList']
+    # rows: tx node of the round, columns: replying node
+    reversePrrMatrixDf = pd.DataFrame(data=extractionDict['reversePrrMatrix'], index=nodeList, columns=nodeList)
+    asymmetryMatrixDf = pd.DataFrame(data=extractionDict['prrMatrix'] - extractionDict['reversePrrMatrix'], index=nodeList, columns=nodeList)
+    turnaroundMatrixDf = pd.DataFrame(data=extractionDict['turnaroundMatrix'], index=nodeList, columns=nodeList)
+    turnaroundMaxMatrixDf = pd.DataFrame(data=extractionDict['turnaroundMaxMatrix'], index=nodeList, columns=nodeList)
+
+    saveMatricesToHtml(
+        [reversePrrMatrixDf, asymmetryMatrixDf, turnaroundMatrixDf, turnaroundMaxMatrixDf],
+        '{}_pingpong.html'.format(testNo),
+        ['Reverse PRR (reply received by the Tx node if the packet has been received)', 'PRR Asymmetry (PRR - Reverse PRR, measured in the same slots)', 'Turnaround Time (mean) [us]', 'Turnaround Time (max) [us]'],
+        ['inferno', 'coolwarm', 'YlGnBu', 'YlGnBu'],
+        ['{:.2f}', '{:.2f}', '{:.0f}', '{:.0f}'],
+        applymaps=[lambda x: 'background: white' if pd.isnull(x) else '']*4,
+        outputDir=outputDir,
+    )
+
+
+def saveCaptureToHtml(extractionDict, testNo):
+    captureSamples = extractionDict['captureSamples']
+    offsets = sorted(set(captureSamples[:, CAPTURE_SAMPLE_KEYS.index('offset')]))
+    firstDf, secondDf, anyDf, numSamplesDf = getCaptureTables(captureSamples, offsets)
+    # per offset (all RSSI differences): ratio of decoded packets and offset of the TxDone timestamps
+    df = pd.DataFrame(captureSamples, columns=CAPTURE_SAMPLE_KEYS)
+    g = df.groupby('offset')
+    offsetDf = pd.DataFrame([
+        (df.outcome == CAPTURE_FIRST).groupby(df.offset).mean(),
+        (df.outcome == CAPTURE_SECOND).groupby(df.offset).mean(),
+        (df.outcome != CAPTURE_NONE).groupby(df.offset).mean(),
+    ], index=['first', 'second', 'any'])
+    txTsOffsetDf = pd.DataFrame([g.txTsOffset.mean(), g.txTsOffset.std()], index=['mean', 'std'])
+
+    saveMatricesToHtml(
+        [firstDf, secondDf, anyDf, numSamplesDf, offsetDf, txTsOffsetDf],
+        '{}_capture.html'.format(testNo),
+        ['First Packet Decoded (rows: RSSI first - second [dB], columns: offset of the second transmitter [us])', 'Second Packet Decoded',
+         'Any Packet Decoded', 'Number of Samples',
+         'Decoded Packets (all RSSI differences)', 'Offset of the TxDone Timestamps [us]'],
+        ['inferno', 'inferno', 'inferno', 'YlGnBu', 'inferno', 'YlGnBu'],
+        ['{:.2f}', '{:.2f}', '{:.2f}', '{:.0f}', '{:.2f}', '{:.1f}'],
+        applymaps=[lambda x: 'background: white' if pd.isnull(x) else '']*6,
+        outputDir=outputDir,
+    )
+
 
-def saveFloodNormalMatricesToHtml(extractionDict):
+def saveEnergyToHtml(extractionDict, testNo):
+    nodeList = extractionDict['nodeList']
+    # state times and energy of each node summed over all rounds
+    stateTimes = np.nansum(extractionDict['stateTimeMatrix'], axis=0)
+    duration = np.where(stateTimes[:, -1] > 0, stateTimes[:, -1], np.nan)
+    dutyCycleDf = pd.DataFrame(data=stateTimes[:, :4]/duration[:, np.newaxis]*100, index=nodeList, columns=STATE_TIME_KEYS[:4])
+    dutyCycleDf['energy [mJ]'] = np.nansum(extractionDict['energyMatrix'], axis=0)
+    energyPerPacketMatrixDf = pd.DataFrame(data=extractionDict['energyPerPacketMatrix'], index=nodeList, columns=nodeList)
+
+    saveMatricesToHtml(
+        [dutyCycleDf, energyPerPacketMatrixDf],
+        '{}_energy.html'.format(testNo),
+        ['CPU and Radio State Duty Cycle [%] and Energy (all rounds)', 'Energy per Delivered Packet (Tx + Rx node during the round of the Tx node) [mJ]'],
+        ['YlGnBu', 'inferno_r'],
+        ['{:.2f}', '{:.2f}'],
+        applymaps=[lambda x: 'background: white' if pd.isnull(x) else '']*2,
+        outputDir=outputDir,
+    )
+
+
+def saveFloodNormalMatricesToHtml(extractionDict, testNo):
     nodeList = extractionDict['nodeList']
     initiator = extractionDict['floodConfig']['initiator']
 
@@ -423,6 +1424,8 @@ def saveFloodNormalMatricesToHtml(extractionDict):
     hopDistanceMatrixDf = pd.DataFrame(data=extractionDict['hopDistanceMatrix'], index=nodeList, columns=nodeList)
     hopDistanceStdMatrixDf = pd.DataFrame(data=extractionDict['hopDistanceStdMatrix'], index=nodeList, columns=nodeList)
     configHtml = 'testConfig:<br />{}<br /><br />floodConfig:<br />{}'.format(extractionDict['testConfig'], extractionDict['floodConfig'])
+    if 'floodNumHops' in extractionDict:
+        configHtml += '<br /><br />adaptive hop budget / slot time [ms] per node:<br />{}'.format({int(node): (int(numHops), int(slotTime)) for node, numHops, slotTime in zip(nodeList, extractionDict['floodNumHops'], extractionDict['floodSlotTime']) if not np.isnan(numHops)})
 
     saveMatricesToHtml(
         matrixDfList=(
@@ -444,8 +1447,11 @@ def saveFloodNormalMatricesToHtml(extractionDict):
         filename='{}.html'.format(testNo)
     )
 
+    if 'floodSlotRxMatrix' in extractionDict:
+        saveFloodTraceToHtml(extractionDict, testNo)
+
 
-def saveFloodDelayedTxMatricesToHtml(extractionDict):
+def saveFloodDelayedTxMatricesToHtml(extractionDict, testNo):
     nodeList = extractionDict['nodeList']
     initiator = extractionDict['floodConfig']['initiator']
 
@@ -457,6 +1463,8 @@ def saveFloodDelayedTxMatricesToHtml(extractionDict):
         axis=0
     )
     configHtml = 'testConfig:<br />{}<br /><br />floodConfig:<br />{}'.format(extractionDict['testConfig'], extractionDict['floodConfig'])
+    if 'floodNumHops' in extractionDict:
+        configHtml += '<br /><br />adaptive hop budget / slot time [ms] per node:<br />{}'.format({int(node): (int(numHops), int(slotTime)) for node, numHops, slotTime in zip(nodeList, extractionDict['floodNumHops'], extractionDict['floodSlotTime']) if not np.isnan(numHops)})
 
     saveMatricesToHtml(
         matrixDfList=(
@@ -482,6 +1490,65 @@ def saveFloodDelayedTxMatricesToHtml(extractionDict):
         filename='{}.html'.format(testNo)
     )
 
+    if 'floodSlotRxMatrix' in extractionDict:
+        saveFloodTraceToHtml(extractionDict, testNo)
+    if 'floodDelays' in extractionDict:
+        saveFloodDelaySweepToHtml(extractionDict, testNo)
+
+
+def saveFloodDelaySweepToHtml(extractionDict, testNo):
+    nodeList = extractionDict['nodeList']
+    initiator = extractionDict['floodConfig']['initiator']
+    delays = extractionDict['floodDelays']
+
+    # hop distance diff per delay value (the round of the initiator has no delayed node and serves as reference)
+    hopDistanceDfList = []
+    hopDistanceDiffDfList = []
+    for delayIdx in range(len(delays)):
+        hopDistanceDf = pd.DataFrame(data=extractionDict['hopDistanceDelayMatrix'][:, :, delayIdx], index=nodeList, columns=nodeList)
+        hopDistanceDfList.append(hopDistanceDf)
+        hopDistanceDiffDfList.append(hopDistanceDf.apply(func=lambda col: col - col[initiator], axis=0))
+    # mean hop distance diff over all rx nodes (rows: delayed node, columns: delay value)
+    meanDiffDf = pd.DataFrame(data=np.array([df.mean(axis=1).to_numpy() for df in hopDistanceDiffDfList]).T, index=nodeList, columns=['delay {}'.format(delay) for delay in delays])
+
+    saveMatricesToHtml(
+        [meanDiffDf] + [df for pair in zip(hopDistanceDiffDfList, hopDistanceDfList) for df in pair],
+        '{}_delay.html'.format(testNo),
+        ['Mean hop distance diff over all Rx nodes (rows: delayed node, columns: delay value [hops], initiator={})'.format(initiator)] +
+        [title.format(delay, initiator) for delay in delays for title in ('Hop distance diff, delay {} (delayed node -> Rx node, initiator={})', 'Hop distance, delay {} (delayed node -> Rx node, initiator={})')],
+        ['coolwarm'] + ['inferno_r']*(2*len(delays)),
+        ['{:.2f}'] + ['{:.1f}']*(2*len(delays)),
+        applymaps=[lambda x: 'background: white' if pd.isnull(x) else '']*(1 + 2*len(delays)),
+        outputDir=outputDir,
+    )
+
+
+def saveFloodTraceToHtml(extractionDict, testNo):
+    nodeList = extractionDict['nodeList']
+    numSlots = extractionDict['floodSlotRxMatrix'].shape[2]
+    columns = ['slot{}'.format(i) for i in range(numSlots)]
+    # per rx node and slot, averaged over the rounds of all nodes
+    slotRxMatrix = extractionDict['floodSlotRxMatrix']
+    slotRssiMatrix = extractionDict['floodSlotRssiMatrix']
+    with np.errstate(invalid='ignore', divide='ignore'):
+        slotRxDf = pd.DataFrame(data=np.nansum(slotRxMatrix, axis=0)/np.sum(~np.isnan(slotRxMatrix), axis=0), index=nodeList, columns=columns)
+        slotRssiDf = pd.DataFrame(data=np.nansum(slotRssiMatrix, axis=0)/np.sum(~np.isnan(slotRssiMatrix), axis=0), index=nodeList, columns=columns)
+    syncErrorMatrixDf = pd.DataFrame(data=extractionDict['syncErrorMatrix'], index=nodeList, columns=nodeList)
+    syncErrors = np.abs(extractionDict['syncErrors'])
+    syncErrorDf = pd.DataFrame(data=[[len(syncErrors)] + (list(np.percentile(syncErrors, [50, 90, 99, 100])) if len(syncErrors) else [np.nan]*4)],
+                               index=['all links'], columns=['numSamples', 'p50', 'p90', 'p99', 'max'])
+
+    saveMatricesToHtml(
+        [slotRxDf, slotRssiDf, syncErrorMatrixDf, syncErrorDf],
+        '{}_floodtrace.html'.format(testNo),
+        ['Ratio of Floods with a Packet Received in the Slot (rows: rx node, all rounds)', 'Mean RSSI per Slot [dBm]',
+         'Sync Error (std of t_ref after removing clock offset and drift) [us] (rows: node of the round, columns: rx node)', 'Abs. Sync Error [us]'],
+        ['inferno', 'inferno', 'YlGnBu', 'YlGnBu'],
+        ['{:.2f}', '{:.0f}', '{:.1f}', '{:.1f}'],
+        applymaps=[lambda x: 'background: white' if pd.isnull(x) else '']*4,
+        outputDir=outputDir,
+    )
+
 
 def saveMatricesToHtml(matrixDfList, filename, titles, cmaps, formats, applymaps=None, outputDir='data'):
     numMatrices = len(matrixDfList)
@@ -530,22 +1597,38 @@ def saveMatricesToHtml(matrixDfList, filename, titles, cmaps, formats, applymaps
 # Main
 ################################################################################
 
-if __name__ == "__main__":
-    # check arguments
-    if len(sys.argv) < 2:
-        print("no test number specified!")
-        sys.exit(1)
-    testNoList = map(int, sys.argv[1:])
-    testDir = os.getcwd()
-
-    for testNo in testNoList:
-        print('testNo: {}'.format(testNo))
+def evaluateTest(testNo, testDir, useCache=True):
+    '''Extracts the data of a single test and saves the html overview (can be executed in a worker process).
+    '''
+    print('testNo: {}'.format(testNo))
 
-        d = extractData(testNo, testDir)
+    dList = extractData(testNo, testDir, useCache=useCache)
+    for configIdx, d in enumerate(dList):
+        resultName = getResultName(testNo, configIdx, len(dList))
         if 'radioConfig' in d:
-            saveP2pMatricesToHtml(d)
+            saveP2pMatricesToHtml(d, resultName)
         elif 'floodConfig' in d:
             if d['floodConfig']['delayTx'] == 0:
-                saveFloodNormalMatricesToHtml(d)
+                saveFloodNormalMatricesToHtml(d, resultName)
             else:
-                saveFloodDelayedTxMatricesToHtml(d)
+                saveFloodDelayedTxMatricesToHtml(d, resultName)
+    return testNo
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description='Evaluate linktest results (serial.csv of FlockLab tests).')
+    parser.add_argument('testNo', type=int, nargs='+', help='FlockLab test number(s)')
+    parser.add_argument('-j', '--jobs', type=int, default=1, help='number of tests evaluated in parallel (0: number of cores)')
+    parser.add_argument('--no-cache', action='store_true', help='always re-parse serial.csv (ignore cached extraction results)')
+    args = parser.parse_args()
+    testDir = os.getcwd()
+    numJobs = args.jobs if args.jobs > 0 else os.cpu_count()
+
+    if numJobs == 1 or len(args.testNo) == 1:
+        for testNo in args.testNo:
+            evaluateTest(testNo, testDir, not args.no_cache)
+    else:
+        with ProcessPoolExecutor(max_workers=numJobs) as executor:
+            futures = [executor.submit(evaluateTest, testNo, testDir, not args.no_cache) for testNo in args.testNo]
+            for future in futures:
+                future.result()
@@ -0,0 +1,267 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Copyright (c) 2019 - 2021, ETH Zurich, Computer Engineering Group (TEC)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+
+
+@author: romantrueb
+@brief:  Monte Carlo prediction of flood tests from the PRR matrix of a point-to-point test
+
+Every flood is simulated slot by slot with the same number of slots as the firmware (FLOODCONFIG_N_TX +
+FLOODCONFIG_NUM_HOPS - 1, see linktest_init()): the initiator transmits in slot 0, a node which received the packet
+for the first time in slot k retransmits in slots k+1, k+3, ... (FLOODCONFIG_N_TX transmissions in total). A node
+which does not have the packet yet receives it in a slot with probability 1 - prod(1 - prr[tx][rx]) over all nodes
+transmitting in that slot, i.e. links are independent and concurrent transmissions never destroy each other
+(optimistic for nodes without a dominant transmitter). The hop distance is rx_idx + 1 as in the FloodDone records (see eval_linktest.py).
+
+A batch of floods is simulated at once (one matrix product with the log of the link loss probabilities per slot),
+batches are distributed to multiple processes with independent random streams.
+
+Usage:
+  ./flood_predict.py data/linktest_data_<p2pTestNo> --n-tx 2 --num-hops 6
+  ./flood_predict.py data/linktest_data_<p2pTestNo> --flood data/linktest_data_<floodTestNo>   (config of the flood test, prediction error)
+"""
+
+import sys
+import os
+import argparse
+import time
+from concurrent.futures import ProcessPoolExecutor
+import numpy as np
+
+import linktest_data
+
+################################################################################
+
+BATCH_SIZE = 10000        # number of floods simulated at once (memory: BATCH_SIZE x numNodes)
+PRR_MAX    = 1 - 1e-12    # upper bound of the PRR (log of the loss probability)
+
+################################################################################
+
+def getNumSlots(nTx, numHops):
+    '''Number of slots of a flood (same as gloria_get_flood_time() in linktest_init())
+    '''
+    return nTx + numHops - 1
+
+
+def simulateFloods(logLossMatrix, initiatorIdx, nTx, numSlots, numFloods, rng):
+    '''Simulates numFloods floods of the initiator and returns the number of floods received, the sum and the squared sum
+    of the hop distance per node.
+    Args:
+        logLossMatrix: log(1 - prr), rows: tx node, columns: rx node
+    '''
+    numNodes = logLossMatrix.shape[0]
+    rxIdx = np.full( (numFloods, numNodes,), -1, dtype=np.int16 )    # slot of the first reception (-1: initiator or not received)
+    hasPkt = np.zeros( (numFloods, numNodes,), dtype=bool )
+    hasPkt[:, initiatorIdx] = True
+    for slot in range(numSlots):
+        # the initiator transmits in slots 0, 2, ..., the other nodes starting in the slot after the first reception
+        txOffset = slot - (rxIdx + 1)
+        isTx = hasPkt & (txOffset >= 0) & (txOffset % 2 == 0) & (txOffset < 2*nTx)
+        if not isTx.any():
+            break
+        # probability that none of the transmitters is received
+        pLoss = np.exp(isTx.astype(np.float64) @ logLossMatrix)
+        isRx = ~hasPkt & (rng.random((numFloods, numNodes)) >= pLoss)
+        rxIdx[isRx] = slot
+        hasPkt |= isRx
+    received = hasPkt.copy()
+    received[:, initiatorIdx] = False
+    hops = np.where(received, rxIdx + 1, 0).astype(np.float64)
+    return received.sum(axis=0), hops.sum(axis=0), (hops**2).sum(axis=0)
+
+
+def simulateTask(logLossMatrix, nTx, numSlots, workItems):
+    '''Worker function: simulates the work items (initiator index, number of floods, random stream) in batches of at most BATCH_SIZE floods
+    '''
+    results = []
+    numNodes = logLossMatrix.shape[0]
+    for initiatorIdx, numFloods, seedSeq in workItems:
+        rng = np.random.default_rng(seedSeq)
+        numRx = np.zeros(numNodes)
+        hopSum = np.zeros(numNodes)
+        hopSqSum = np.zeros(numNodes)
+        for start in range(0, numFloods, BATCH_SIZE):
+            n, s, sq = simulateFloods(logLossMatrix, initiatorIdx, nTx, numSlots, min(BATCH_SIZE, numFloods - start), rng)
+            numRx += n
+            hopSum += s
+            hopSqSum += sq
+        results.append((initiatorIdx, numRx, hopSum, hopSqSum))
+    return results
+
+
+def predictFloods(prrMatrix, nTx, numHops, numFloods=100000, initiators=None, numJobs=1, seed=None):
+    '''Predicts the flood statistics of every initiator from the PRR matrix (rows: tx node, columns: rx node, NaN: no link).
+    Returns:
+        floodRxRatioMatrix (ratio of floods received), hopDistanceMatrix and hopDistanceStdMatrix (rows: initiator, columns: rx node),
+        NaN for rows of nodes which are not in initiators
+    '''
+    prrMatrix = np.asarray(prrMatrix, dtype=np.float64)
+    numNodes = prrMatrix.shape[0]
+    initiators = list(range(numNodes)) if initiators is None else list(initiators)
+    prr = np.clip(np.nan_to_num(prrMatrix, nan=0.0), 0.0, PRR_MAX)
+    np.fill_diagonal(prr, 0.0)
+    logLossMatrix = np.log1p(-prr)
+    numSlots = getNumSlots(nTx, numHops)
+
+    # work items: the floods of an initiator are split into several parts if there are fewer initiators than workers,
+    # the work items are distributed to one task per worker (the matrix is transferred once per task)
+    numJobs = max(1, numJobs)
+    numParts = -(-numJobs // len(initiators))
+    seedSeqs = np.random.SeedSequence(seed).spawn(len(initiators)*numParts)
+    workItems = []
+    for k, initiatorIdx in enumerate(initiators):
+        for part in range(numParts):
+            n = numFloods//numParts + (1 if part < numFloods % numParts else 0)
+            if n:
+                workItems.append((initiatorIdx, n, seedSeqs[k*numParts + part]))
+    tasks = [workItems[t::numJobs] for t in range(numJobs) if workItems[t::numJobs]]
+
+    numRxMatrix = np.full( (numNodes, numNodes,), np.nan )
+    hopSumMatrix = np.zeros( (numNodes, numNodes,) )
+    hopSqSumMatrix = np.zeros( (numNodes, numNodes,) )
+    numRxMatrix[list(initiators)] = 0
+    if numJobs == 1:
+        results = [simulateTask(logLossMatrix, nTx, numSlots, task) for task in tasks]
+    else:
+        with ProcessPoolExecutor(max_workers=numJobs) as executor:
+            futures = [executor.submit(simulateTask, logLossMatrix, nTx, numSlots, task) for task in tasks]
+            results = [future.result() for future in futures]
+    for initiatorIdx, numRx, hopSum, hopSqSum in (r for taskResults in results for r in taskResults):
+        numRxMatrix[initiatorIdx] += numRx
+        hopSumMatrix[initiatorIdx] += hopSum
+        hopSqSumMatrix[initiatorIdx] += hopSqSum
+
+    floodRxRatioMatrix = numRxMatrix/numFloods
+    with np.errstate(invalid='ignore', divide='ignore'):
+        hopDistanceMatrix = np.where(numRxMatrix > 0, hopSumMatrix/numRxMatrix, np.nan)
+        hopDistanceStdMatrix = np.where(numRxMatrix > 0, np.sqrt(np.maximum(0, hopSqSumMatrix/numRxMatrix - hopDistanceMatrix**2)), np.nan)
+    return floodRxRatioMatrix, hopDistanceMatrix, hopDistanceStdMatrix
+
+
+def getPredictionError(pred, meas):
+    '''Compares the prediction with a flood test (both dicts with nodeList, floodRxRatioMatrix and hopDistanceMatrix, measured
+    floodRxRatioMatrix = numFloodsRxMatrix / numTx). Returns a dict with the error statistics over all links and the per-link error matrices
+    (nodeList of the measurement).
+    '''
+    predIdx = {node: idx for idx, node in enumerate(pred['nodeList'])}
+    idx = [predIdx.get(node) for node in meas['nodeList']]
+    valid = np.array([i is not None for i in idx])
+    idx = np.array([i if i is not None else 0 for i in idx])
+    ratioErrorMatrix = np.full( (len(idx), len(idx),), np.nan )
+    hopErrorMatrix = np.full( (len(idx), len(idx),), np.nan )
+    sel = np.ix_(np.where(valid)[0], np.where(valid)[0])
+    predSel = np.ix_(idx[valid], idx[valid])
+    ratioErrorMatrix[sel] = pred['floodRxRatioMatrix'][predSel] - meas['floodRxRatioMatrix'][sel]
+    hopErrorMatrix[sel] = pred['hopDistanceMatrix'][predSel] - meas['hopDistanceMatrix'][sel]
+    np.fill_diagonal(ratioErrorMatrix, np.nan)
+
+    ratioErrors = ratioErrorMatrix[~np.isnan(ratioErrorMatrix)]
+    hopErrors = hopErrorMatrix[~np.isnan(hopErrorMatrix)]
+    stats = {
+        'numLinks': len(ratioErrors),
+        'ratioMae': np.mean(np.abs(ratioErrors)) if len(ratioErrors) else np.nan,
+        'ratioRmse': np.sqrt(np.mean(ratioErrors**2)) if len(ratioErrors) else np.nan,
+        'ratioBias': np.mean(ratioErrors) if len(ratioErrors) else np.nan,
+        'numHopLinks': len(hopErrors),
+        'hopMae': np.mean(np.abs(hopErrors)) if len(hopErrors) else np.nan,
+        'hopBias': np.mean(hopErrors) if len(hopErrors) else np.nan,
+        'hopWithin0.5': np.mean(np.abs(hopErrors) <= 0.5) if len(hopErrors) else np.nan,
+    }
+    return stats, ratioErrorMatrix, hopErrorMatrix
+
+
+################################################################################
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description='Predict flood tests from the PRR matrix of a point-to-point linktest result (Monte Carlo).')
+    parser.add_argument('p2pResult', help='result directory of a P2P test (linktest_data_<testNo>, see linktest_data.py)')
+    parser.add_argument('--flood', help='result directory of a flood test (FLOODCONFIG_DELAY_TX=0): use its config and report the prediction error')
+    parser.add_argument('--n-tx', type=int, help='number of transmissions per node (FLOODCONFIG_N_TX)')
+    parser.add_argument('--num-hops', type=int, help='hop budget (FLOODCONFIG_NUM_HOPS)')
+    parser.add_argument('-n', '--num-floods', type=int, default=100000, help='number of simulated floods per initiator')
+    parser.add_argument('-j', '--jobs', type=int, default=1, help='number of worker processes (0: number of cores)')
+    parser.add_argument('--seed', type=int, help='seed of the random number generator')
+    parser.add_argument('-o', '--output', help='save the prediction as result directory (same layout as a flood test)')
+    args = parser.parse_args()
+    numJobs = args.jobs if args.jobs > 0 else os.cpu_count()
+
+    p2p = linktest_data.loadData(args.p2pResult, arrays=['prrMatrix'], mmapMode=None)
+    nTx, numHops = args.n_tx, args.num_hops
+    flood = None
+    if args.flood:
+        flood = linktest_data.loadData(args.flood, arrays=['numFloodsRxMatrix', 'hopDistanceMatrix'], mmapMode=None)
+        if flood['floodConfig']['delayTx'] != 0:
+            print('ERROR: only flood tests without delayed retransmissions (FLOODCONFIG_DELAY_TX=0) can be predicted')
+            sys.exit(1)
+        nTx = flood['floodConfig']['nTx'] if nTx is None else nTx
+        numHops = flood['floodConfig']['numHops'] if numHops is None else numHops
+    if nTx is None or numHops is None:
+        print('ERROR: --n-tx and --num-hops are required without --flood')
+        sys.exit(1)
+
+    startTime = time.time()
+    floodRxRatioMatrix, hopDistanceMatrix, hopDistanceStdMatrix = predictFloods(p2p['prrMatrix'], nTx, numHops, args.num_floods, numJobs=numJobs, seed=args.seed)
+    duration = time.time() - startTime
+    numNodes = len(p2p['nodeList'])
+    print('simulated {} floods ({} initiators, nTx={}, numHops={}) in {:.1f}s ({:.0f} floods/s)'.format(
+        numNodes*args.num_floods, numNodes, nTx, numHops, duration, numNodes*args.num_floods/duration))
+
+    pred = {
+        'nodeList': p2p['nodeList'],
+        'floodConfig': {'nTx': nTx, 'numHops': numHops, 'delayTx': 0, 'numFloods': args.num_floods, 'p2pResult': os.path.basename(os.path.normpath(args.p2pResult))},
+        'floodRxRatioMatrix': floodRxRatioMatrix,
+        'hopDistanceMatrix': hopDistanceMatrix,
+        'hopDistanceStdMatrix': hopDistanceStdMatrix,
+    }
+    print('mean flood reception ratio: {:.3f}, mean hop distance: {:.2f}'.format(np.nanmean(floodRxRatioMatrix[~np.eye(numNodes, dtype=bool)]), np.nanmean(hopDistanceMatrix)))
+
+    if flood is not None:
+        # numFloodsRxMatrix of a flood test counts the floods received out of numTx floods per round
+        numTx = flood['testConfig']['numTx']
+        pred['numFloodsRxMatrix'] = floodRxRatioMatrix*numTx
+        meas = {
+            'nodeList': flood['nodeList'],
+            'floodRxRatioMatrix': np.asarray(flood['numFloodsRxMatrix'])/numTx,
+            'hopDistanceMatrix': np.asarray(flood['hopDistanceMatrix']),
+        }
+        missing = sorted(set(flood['nodeList']) - set(p2p['nodeList']))
+        if missing:
+            print('WARNING: nodes of the flood test without P2P data are ignored: {}'.format(missing))
+        stats, pred['floodRxRatioErrorMatrix'], pred['hopDistanceErrorMatrix'] = getPredictionError(pred, meas)
+        print('prediction error (prediction - measurement) over {} links:'.format(stats['numLinks']))
+        print('  flood reception ratio: MAE {:.3f}, RMSE {:.3f}, bias {:+.3f}'.format(stats['ratioMae'], stats['ratioRmse'], stats['ratioBias']))
+        print('  hop distance ({} links): MAE {:.2f}, bias {:+.2f}, within 0.5 hops: {:.1%}'.format(stats['numHopLinks'], stats['hopMae'], stats['hopBias'], stats['hopWithin0.5']))
+        pred['predictionError'] = stats
+
+    if args.output:
+        linktest_data.saveData(pred, args.output)
+        print('prediction saved to {}'.format(args.output))
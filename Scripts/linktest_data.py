@@ -0,0 +1,161 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Copyright (c) 2019 - 2021, ETH Zurich, Computer Engineering Group (TEC)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+
+@author: romantrueb
+@brief:  Columnar on-disk format for extracted linktest data
+
+A result is stored as a directory containing
+  * header.json: format version, configs (testConfig, radioConfig/floodConfig), nodeList and an index of the arrays
+  * <name>.npy:  one numpy array per matrix (e.g. prrMatrix.npy)
+Arrays are loaded with allow_pickle=False and can be memory-mapped, i.e. only the accessed parts of the requested
+matrices are read from disk. In contrast to pickle, loading results from untrusted sources does not execute code.
+"""
+
+import sys
+import os
+import re
+import json
+import shutil
+import pickle
+import numpy as np
+
+################################################################################
+
+FORMAT_NAME = 'linktest-data'
+FORMAT_VERSION = 1
+HEADER_FILE = 'header.json'
+
+arrayNameRegex = re.compile(r'^[A-Za-z][A-Za-z0-9_]*$')
+
+################################################################################
+
+def toJson(obj):
+    '''Converts numpy scalars (e.g. node IDs obtained from pandas) to native python types.
+    '''
+    if isinstance(obj, np.generic):
+        return obj.item()
+    raise TypeError('object of type {} is not JSON serializable'.format(type(obj).__name__))
+
+
+def saveData(d, path):
+    '''Saves extracted data (dict containing numpy arrays and json serializable entries) to the directory path.
+    The directory is written to a temporary location first and renamed afterwards (safe for concurrent writers).
+    '''
+    header = {
+        'format': FORMAT_NAME,
+        'version': FORMAT_VERSION,
+        'arrays': {},
+    }
+    tmpPath = '{}.{}.tmp'.format(path.rstrip(os.sep), os.getpid())
+    shutil.rmtree(tmpPath, ignore_errors=True)
+    os.makedirs(tmpPath)
+    for key, value in d.items():
+        if isinstance(value, np.ndarray):
+            assert arrayNameRegex.match(key), 'invalid array name: {}'.format(key)
+            np.save(os.path.join(tmpPath, key + '.npy'), value, allow_pickle=False)
+            header['arrays'][key] = {'dtype': value.dtype.str, 'shape': list(value.shape)}
+        else:
+            assert key not in ('format', 'version', 'arrays'), 'reserved key: {}'.format(key)
+            header[key] = value
+    with open(os.path.join(tmpPath, HEADER_FILE), 'w') as f:
+        json.dump(header, f, default=toJson, indent=1)
+
+    shutil.rmtree(path, ignore_errors=True)
+    try:
+        os.rename(tmpPath, path)
+    except OSError:
+        # another writer has been faster
+        shutil.rmtree(tmpPath, ignore_errors=True)
+
+
+def loadHeader(path):
+    '''Loads and checks the header (configs, nodeList, array index) of a result without reading any array.
+    '''
+    with open(os.path.join(path, HEADER_FILE), 'r') as f:
+        header = json.load(f)
+    if header.get('format') != FORMAT_NAME:
+        raise ValueError('{} is not a linktest result'.format(path))
+    if header.get('version') != FORMAT_VERSION:
+        raise ValueError('unsupported format version {} (expected {})'.format(header.get('version'), FORMAT_VERSION))
+    for name in header['arrays']:
+        if not arrayNameRegex.match(name):
+            raise ValueError('invalid array name: {}'.format(name))
+    return header
+
+
+def loadArray(path, name, header=None, mmapMode='r'):
+    '''Loads a single array of a result (memory-mapped by default).
+    '''
+    if header is None:
+        header = loadHeader(path)
+    if name not in header['arrays']:
+        raise KeyError(name)
+    arr = np.load(os.path.join(path, name + '.npy'), mmap_mode=mmapMode, allow_pickle=False)
+    info = header['arrays'][name]
+    if (arr.dtype.str != info['dtype']) or (list(arr.shape) != info['shape']):
+        raise ValueError('array {} does not match the header'.format(name))
+    return arr
+
+
+def loadData(path, arrays=None, mmapMode='r'):
+    '''Loads a result into a dict with the same layout as the results returned by eval_linktest.extractData().
+    Args:
+        path: result directory
+        arrays: names of the arrays to load (None: all arrays)
+        mmapMode: mmap_mode passed to np.load() (None: read arrays into memory)
+    '''
+    header = loadHeader(path)
+    d = {key: value for key, value in header.items() if key not in ('format', 'version', 'arrays')}
+    for name in (header['arrays'] if arrays is None else arrays):
+        d[name] = loadArray(path, name, header, mmapMode)
+    return d
+
+
+def convertPickle(pklPath, path):
+    '''Converts a legacy pickle result (linktest_data_<testNo>.pkl). Only use for trusted files!
+    '''
+    with open(pklPath, 'rb') as f:
+        d = pickle.load(f)
+    saveData(d, path)
+
+################################################################################
+
+if __name__ == "__main__":
+    # convert legacy pickle results
+    if len(sys.argv) < 2:
+        print("usage: {} linktest_data_<testNo>.pkl [...]".format(sys.argv[0]))
+        sys.exit(1)
+    for pklPath in sys.argv[1:]:
+        path = os.path.splitext(pklPath)[0]
+        convertPickle(pklPath, path)
+        print('{} -> {}'.format(pklPath, path))
@@ -0,0 +1,317 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Copyright (c) 2019 - 2021, ETH Zurich, Computer Engineering Group (TEC)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+
+
+@author: romantrueb
+@brief:  Graph analytics of the link matrices (ETX, shortest paths, hop counts, asymmetry, components) and export to graph formats
+
+All matrices use the layout of the P2P results of eval_linktest.py: rows: tx node, columns: rx node, NaN: no measurement. Links with a
+PRR below prrMin are treated as non-existent. All algorithms operate on whole numpy matrices (one vectorized step per
+intermediate node or per hop), i.e. networks with several hundred nodes are processed within seconds.
+
+Usage:
+  ./linktest_graph.py data/linktest_data_<testNo> -f graphml,routes   (writes data/linktest_data_<testNo>_graph.graphml, ..._routes.csv)
+"""
+
+import sys
+import os
+import argparse
+import json
+from xml.sax.saxutils import quoteattr
+import numpy as np
+
+import linktest_data
+
+################################################################################
+
+PRR_MIN = 0.1             # default min. PRR of a usable link
+EXPORT_FORMATS = ('graphml', 'dot', 'json', 'csv', 'routes', 'flocklab')
+
+################################################################################
+# Analysis
+################################################################################
+
+def getLinkMatrix(prrMatrix, prrMin=PRR_MIN):
+    '''Returns the PRR matrix with NaN (no measurement) and the diagonal replaced by 0 and the adjacency matrix (bool, prr >= prrMin)
+    '''
+    prr = np.nan_to_num(np.asarray(prrMatrix, dtype=np.float64), nan=0.0)
+    np.fill_diagonal(prr, 0.0)
+    return prr, (prr >= prrMin) & (prr > 0)
+
+
+def getEtxMatrix(prrMatrix, prrMin=PRR_MIN, bidirectional=True):
+    '''Expected transmission count per link: 1/(prr forward * prr reverse) (bidirectional, i.e. incl. the acknowledgement)
+    or 1/prr forward, inf for links which are not usable (in both directions if bidirectional), 0 on the diagonal.
+    '''
+    prr, adj = getLinkMatrix(prrMatrix, prrMin)
+    if bidirectional:
+        prr = prr * prr.T
+        adj = adj & adj.T
+    etx = np.full(prr.shape, np.inf)
+    etx[adj] = 1/prr[adj]
+    np.fill_diagonal(etx, 0.0)
+    return etx
+
+
+def getShortestPaths(etxMatrix):
+    '''All-pairs shortest paths w.r.t. the ETX (Floyd-Warshall, one vectorized relaxation over all pairs per intermediate node).
+    Returns:
+        pathEtxMatrix (ETX of the best path, inf: not reachable), nextHopMatrix (index of the first hop from row to column node, -1: not reachable)
+        and pathHopsMatrix (number of hops of the best path, inf: not reachable)
+    '''
+    dist = np.array(etxMatrix, dtype=np.float64)
+    numNodes = dist.shape[0]
+    reachable = np.isfinite(dist)
+    nextHop = np.where(reachable, np.arange(numNodes)[np.newaxis, :], -1)
+    hops = np.where(reachable, 1.0, np.inf)
+    np.fill_diagonal(hops, 0.0)
+    cand = np.empty_like(dist)
+    better = np.empty(dist.shape, dtype=bool)
+    for k in range(numNodes):
+        np.add(dist[:, k, np.newaxis], dist[np.newaxis, k, :], out=cand)
+        np.less(cand, dist, out=better)
+        if not better.any():
+            continue
+        np.copyto(dist, cand, where=better)
+        np.copyto(nextHop, np.broadcast_to(nextHop[:, k, np.newaxis], nextHop.shape), where=better)
+        np.copyto(hops, hops[:, k, np.newaxis] + hops[np.newaxis, k, :], where=better)
+    return dist, nextHop, hops
+
+
+def getHopCountMatrix(adjacency):
+    '''Min. number of hops between all pairs of nodes (breadth-first search of all sources at once, one boolean matrix
+    product per hop), inf: not reachable
+    '''
+    adj = np.asarray(adjacency, dtype=bool)
+    numNodes = adj.shape[0]
+    hopCount = np.full(adj.shape, np.inf)
+    np.fill_diagonal(hopCount, 0)
+    reached = np.eye(numNodes, dtype=bool)
+    frontier = reached.copy()
+    adjF = adj.astype(np.float32)
+    for hop in range(1, numNodes):
+        frontier = ((frontier.astype(np.float32) @ adjF) > 0) & ~reached
+        if not frontier.any():
+            break
+        hopCount[frontier] = hop
+        reached |= frontier
+    return hopCount
+
+
+def getAsymmetry(prrMatrix, prrMin=PRR_MIN):
+    '''Link asymmetry: asymmetryMatrix (prr[tx][rx] - prr[rx][tx], NaN if none of the directions is usable), the asymmetry
+    score of every node (mean abs. asymmetry of its links) and the list of unidirectional links (tx idx, rx idx), i.e. usable in one direction only
+    '''
+    prr, adj = getLinkMatrix(prrMatrix, prrMin)
+    asymmetryMatrix = np.where(adj | adj.T, prr - prr.T, np.nan)
+    absAsym = np.abs(asymmetryMatrix)
+    numLinks = np.sum(~np.isnan(absAsym), axis=1)
+    with np.errstate(invalid='ignore', divide='ignore'):
+        nodeScore = np.where(numLinks > 0, np.nansum(absAsym, axis=1)/numLinks, np.nan)
+    unidirectional = np.argwhere(adj & ~adj.T)
+    return asymmetryMatrix, nodeScore, unidirectional
+
+
+def getComponents(adjacency):
+    '''Strongly and weakly connected components of the directed link graph.
+    Returns the component label of every node (smallest node index of the component) for both, based on the transitive closure
+    '''
+    adj = np.asarray(adjacency, dtype=bool)
+    reach = np.isfinite(getHopCountMatrix(adj))
+    mutual = reach & reach.T
+    strong = np.argmax(mutual, axis=1)
+    weakReach = np.isfinite(getHopCountMatrix(adj | adj.T))
+    weak = np.argmax(weakReach, axis=1)
+    return strong, weak
+
+
+def analyzeGraph(prrMatrix, prrMin=PRR_MIN, bidirectional=True):
+    '''Runs all analyses and returns a dict of result matrices / vectors (node indices refer to the nodeList of the input).
+    '''
+    prr, adj = getLinkMatrix(prrMatrix, prrMin)
+    etxMatrix = getEtxMatrix(prrMatrix, prrMin, bidirectional)
+    pathEtxMatrix, nextHopMatrix, pathHopsMatrix = getShortestPaths(etxMatrix)
+    asymmetryMatrix, asymmetryScore, unidirectional = getAsymmetry(prrMatrix, prrMin)
+    strongComponent, weakComponent = getComponents(adj)
+    return {
+        'prr': prr,
+        'adjacency': adj,
+        'etxMatrix': etxMatrix,
+        'pathEtxMatrix': pathEtxMatrix,
+        'nextHopMatrix': nextHopMatrix,
+        'pathHopsMatrix': pathHopsMatrix,
+        'hopCountMatrix': getHopCountMatrix(etxMatrix < np.inf) if bidirectional else getHopCountMatrix(adj),
+        'asymmetryMatrix': asymmetryMatrix,
+        'asymmetryScore': asymmetryScore,
+        'unidirectionalLinks': unidirectional,
+        'strongComponent': strongComponent,
+        'weakComponent': weakComponent,
+    }
+
+
+################################################################################
+# Export
+################################################################################
+
+def getLinks(g):
+    '''Returns (tx idx, rx idx) of all usable links
+    '''
+    return np.argwhere(g['adjacency'])
+
+
+def writeGraphml(path, nodeList, g):
+    with open(path, 'w') as f:
+        f.write('<?xml version="1.0" encoding="UTF-8"?>\n')
+        f.write('<graphml xmlns="http://graphml.graphdrawing.org/xmlns">\n')
+        for key, target, attrType in (('strongComponent', 'node', 'int'), ('weakComponent', 'node', 'int'), ('asymmetryScore', 'node', 'double'),
+                                      ('prr', 'edge', 'double'), ('etx', 'edge', 'double'), ('asymmetry', 'edge', 'double')):
+            f.write('  <key id="{0}" for="{1}" attr.name="{0}" attr.type="{2}"/>\n'.format(key, target, attrType))
+        f.write('  <graph id="linktest" edgedefault="directed">\n')
+        for idx, node in enumerate(nodeList):
+            f.write('    <node id="{}"><data key="strongComponent">{}</data><data key="weakComponent">{}</data><data key="asymmetryScore">{:.4f}</data></node>\n'.format(
+                node, nodeList[g['strongComponent'][idx]], nodeList[g['weakComponent'][idx]], g['asymmetryScore'][idx]))
+        for txIdx, rxIdx in getLinks(g):
+            f.write('    <edge source="{}" target="{}"><data key="prr">{:.4f}</data><data key="etx">{:.4f}</data><data key="asymmetry">{:.4f}</data></edge>\n'.format(
+                nodeList[txIdx], nodeList[rxIdx], g['prr'][txIdx][rxIdx], g['etxMatrix'][txIdx][rxIdx], g['asymmetryMatrix'][txIdx][rxIdx]))
+        f.write('  </graph>\n</graphml>\n')
+
+
+def writeDot(path, nodeList, g):
+    with open(path, 'w') as f:
+        f.write('digraph linktest {\n')
+        for idx, node in enumerate(nodeList):
+            f.write('  "{}" [component={}];\n'.format(node, nodeList[g['strongComponent'][idx]]))
+        for txIdx, rxIdx in getLinks(g):
+            f.write('  "{}" -> "{}" [prr={:.3f}, etx={:.3f}, label="{:.2f}"];\n'.format(
+                nodeList[txIdx], nodeList[rxIdx], g['prr'][txIdx][rxIdx], g['etxMatrix'][txIdx][rxIdx], g['prr'][txIdx][rxIdx]))
+        f.write('}\n')
+
+
+def writeJson(path, nodeList, g):
+    '''node-link format (compatible with networkx.node_link_graph())
+    '''
+    data = {
+        'directed': True,
+        'multigraph': False,
+        'graph': {},
+        'nodes': [{'id': int(node), 'strongComponent': int(nodeList[g['strongComponent'][idx]]), 'weakComponent': int(nodeList[g['weakComponent'][idx]]),
+                   'asymmetryScore': None if np.isnan(g['asymmetryScore'][idx]) else float(g['asymmetryScore'][idx])} for idx, node in enumerate(nodeList)],
+        'links': [{'source': int(nodeList[txIdx]), 'target': int(nodeList[rxIdx]), 'prr': float(g['prr'][txIdx][rxIdx]),
+                   'etx': None if np.isinf(g['etxMatrix'][txIdx][rxIdx]) else float(g['etxMatrix'][txIdx][rxIdx])} for txIdx, rxIdx in getLinks(g)],
+    }
+    with open(path, 'w') as f:
+        json.dump(data, f, indent=1)
+
+
+def writeCsv(path, nodeList, g):
+    '''edge list
+    '''
+    with open(path, 'w') as f:
+        f.write('tx,rx,prr,prr_reverse,etx\n')
+        for txIdx, rxIdx in getLinks(g):
+            f.write('{},{},{:.4f},{:.4f},{:.4f}\n'.format(nodeList[txIdx], nodeList[rxIdx], g['prr'][txIdx][rxIdx], g['prr'][rxIdx][txIdx], g['etxMatrix'][txIdx][rxIdx]))
+
+
+def writeRoutes(path, nodeList, g):
+    '''routing table: next hop, ETX and number of hops of the min. ETX path for all reachable pairs of nodes
+    '''
+    src, dst = np.nonzero((g['nextHopMatrix'] >= 0) & ~np.eye(len(nodeList), dtype=bool))
+    nodes = np.asarray(nodeList)
+    with open(path, 'w') as f:
+        f.write('src,dst,next_hop,etx,hops,min_hops\n')
+        for s, d, n, e, h, m in zip(nodes[src], nodes[dst], nodes[g['nextHopMatrix'][src, dst]], g['pathEtxMatrix'][src, dst], g['pathHopsMatrix'][src, dst], g['hopCountMatrix'][src, dst]):
+            f.write('{},{},{},{:.4f},{:.0f},{:.0f}\n'.format(s, d, n, e, h, m))
+
+
+def writeFlocklabConnectivity(path, nodeList, prrMatrix, numPackets):
+    '''FlockLab connectivity list (all measured links incl. PRR 0)
+    '''
+    prrMatrix = np.asarray(prrMatrix)
+    with open(path, 'w') as f:
+        f.write('<?xml version="1.0" encoding="UTF-8" ?>\n<network platform="DPP2LoRa">\n')
+        for txIdx, rxIdx in np.argwhere(~np.isnan(prrMatrix)):
+            f.write('<link src={txNode} dest={rxNode} prr="{prr:.3f}" numpackets="{numPackets}" />\n'.format(
+                    txNode=quoteattr(str(nodeList[txIdx])),
+                    rxNode=quoteattr(str(nodeList[rxIdx])),
+                    prr=prrMatrix[txIdx][rxIdx],
+                    numPackets=numPackets,
+            ))
+        f.write('</network>')
+
+
+################################################################################
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description='Graph analytics of a linktest result (ETX, shortest paths, hop counts, asymmetry, components).')
+    parser.add_argument('result', help='result directory of a P2P test (linktest_data_<testNo>, see linktest_data.py)')
+    parser.add_argument('--prr-min', type=float, default=PRR_MIN, help='min. PRR of a usable link (default: {})'.format(PRR_MIN))
+    parser.add_argument('--unidirectional', action='store_true', help='ETX of the forward direction only (default: 1/(prr forward * prr reverse))')
+    parser.add_argument('-f', '--formats', default='graphml,routes', help='comma separated list of export formats ({})'.format(','.join(EXPORT_FORMATS)))
+    parser.add_argument('-o', '--output', help='prefix of the output files (default: <result>_graph)')
+    args = parser.parse_args()
+    formats = [fmt for fmt in args.formats.split(',') if fmt]
+    for fmt in formats:
+        if fmt not in EXPORT_FORMATS:
+            print('ERROR: unknown format {} (supported: {})'.format(fmt, ','.join(EXPORT_FORMATS)))
+            sys.exit(1)
+
+    d = linktest_data.loadData(args.result, arrays=['prrMatrix'], mmapMode=None)
+    nodeList = d['nodeList']
+    g = analyzeGraph(d['prrMatrix'], args.prr_min, not args.unidirectional)
+
+    numNodes = len(nodeList)
+    offDiag = ~np.eye(numNodes, dtype=bool)
+    reachable = np.isfinite(g['pathEtxMatrix']) & offDiag
+    print('nodes: {}, usable links: {} (unidirectional: {})'.format(numNodes, int(np.sum(g['adjacency'])), len(g['unidirectionalLinks'])))
+    print('strongly connected components: {}, weakly connected components: {}'.format(len(set(g['strongComponent'])), len(set(g['weakComponent']))))
+    if reachable.any():
+        print('reachable pairs: {:.1%}, diameter: {:.0f} hops, mean hops: {:.2f} (min. ETX path: {:.2f}), mean path ETX: {:.2f}'.format(
+            np.mean(reachable[offDiag]), np.max(g['hopCountMatrix'][reachable]), np.mean(g['hopCountMatrix'][reachable]),
+            np.mean(g['pathHopsMatrix'][reachable]), np.mean(g['pathEtxMatrix'][reachable])))
+    worst = np.argsort(np.nan_to_num(g['asymmetryScore'], nan=-1))[::-1][:5]
+    print('most asymmetric nodes: {}'.format(', '.join('{} ({:.2f})'.format(nodeList[idx], g['asymmetryScore'][idx]) for idx in worst if not np.isnan(g['asymmetryScore'][idx]))))
+
+    prefix = args.output if args.output else os.path.normpath(args.result) + '_graph'
+    writers = {
+        'graphml':  lambda path: writeGraphml(path, nodeList, g),
+        'dot':      lambda path: writeDot(path, nodeList, g),
+        'json':     lambda path: writeJson(path, nodeList, g),
+        'csv':      lambda path: writeCsv(path, nodeList, g),
+        'routes':   lambda path: writeRoutes(path, nodeList, g),
+        'flocklab': lambda path: writeFlocklabConnectivity(path, nodeList, d['prrMatrix'], d['testConfig']['numTx']),
+    }
+    extensions = {'graphml': '.graphml', 'dot': '.dot', 'json': '.json', 'csv': '_links.csv', 'routes': '_routes.csv', 'flocklab': '_flocklab.xml'}
+    for fmt in formats:
+        path = prefix + extensions[fmt]
+        writers[fmt](path)
+        print('{} -> {}'.format(fmt, path))
@@ -0,0 +1,161 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Copyright (c) 2019 - 2021, ETH Zurich, Computer Engineering Group (TEC)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+
+@author: romantrueb
+@brief:  Schedule of the frequency-division parallel rounds (TESTCONFIG_NUM_CHANNELS > 1)
+
+The nodes are split into groups of (at most) numChannels transmitters, i.e. one round per group. Within a round, every
+transmitter uses a fixed channel (its position in the group) and the receivers hop between the channels from slot to
+slot such that every (tx, rx) pair is covered by numSamples slots, including the pairs within a group (members of a
+group listen to the other members in some slots). The slots of a round are assigned greedily: in each slot, the set
+of transmitters and the channel of every receiver are chosen to maximize the number of outstanding samples covered.
+
+Since a node cannot transmit and receive at the same time (and receives a single channel only), every node needs at
+least numSamples*numNodes slots in total, i.e. the number of slots is the same as with serial rounds. The test time
+is reduced by the per-round overhead (setup time, start and stop delay) of the rounds which are merged.
+
+The schedule is written to Inc/linktest_schedule.h (see run_linktest.py --schedule) and is regenerated by the
+evaluation to assign the received packets to the transmitters (the CRC of the schedule is printed in the TestConfig).
+"""
+
+import itertools
+import zlib
+import numpy as np
+
+################################################################################
+
+SCHEDULE_TX   = 0x80      # entry: SCHEDULE_TX | channel (transmit), channel (receive) or SCHEDULE_IDLE
+SCHEDULE_IDLE = 0xFF
+MAX_CHANNELS  = 8
+
+################################################################################
+
+def getGroups(numNodes, numChannels):
+    '''Returns the node indices (in TESTCONFIG_NODE_IDS) of each group, group sizes differ by at most one
+    '''
+    numGroups = (numNodes + numChannels - 1) // numChannels
+    return [list(g) for g in np.array_split(np.arange(numNodes), numGroups)]
+
+
+def generateGroupSlots(members, numNodes, numSamples):
+    '''Greedy slot assignment of a single round
+    Returns:
+        list of slots, each slot is a list of schedule entries (one per node)
+    '''
+    numCh = len(members)
+    needs = np.full((numCh, numNodes), numSamples, dtype=np.int64)   # outstanding samples per (channel of tx, rx node)
+    for ch, m in enumerate(members):
+        needs[ch][m] = 0
+    subsets = np.array(list(itertools.product([False, True], repeat=numCh)), dtype=bool)[1:]   # all non-empty sets of transmitters
+    isTx = np.zeros((len(subsets), numNodes), dtype=bool)
+    isTx[:, members] = subsets
+    slots = []
+    while needs.sum() > 0:
+        # every node which is not transmitting listens to the transmitter with the most outstanding samples
+        best = np.where(subsets[:, :, np.newaxis], needs[np.newaxis], 0).max(axis=1)
+        score = np.where(isTx, 0, best).sum(axis=1)
+        txSet = subsets[np.argmax(score)]
+        slot = [SCHEDULE_IDLE]*numNodes
+        for ch, m in enumerate(members):
+            if txSet[ch]:
+                slot[m] = SCHEDULE_TX | ch
+        for rx in range(numNodes):
+            if slot[rx] != SCHEDULE_IDLE:
+                continue
+            # ties are rotated to spread the receivers over the channels
+            cand = [(needs[ch][rx], -((ch + rx + len(slots)) % numCh), ch) for ch in range(numCh) if txSet[ch] and needs[ch][rx] > 0]
+            if cand:
+                ch = max(cand)[2]
+                slot[rx] = ch
+                needs[ch][rx] -= 1
+        slots.append(slot)
+    return slots
+
+
+def generateSchedule(numNodes, numChannels, numSamples):
+    '''Returns the schedule as array (dimensions: round, slot, node index), all rounds have the same number of slots (padded with idle slots)
+    '''
+    if not (1 < numChannels <= MAX_CHANNELS):
+        raise Exception('numChannels must be within 2 and {}!'.format(MAX_CHANNELS))
+    roundSlots = [generateGroupSlots(members, numNodes, numSamples) for members in getGroups(numNodes, numChannels)]
+    numSlots = max([len(slots) for slots in roundSlots])
+    schedule = np.full((len(roundSlots), numSlots, numNodes), SCHEDULE_IDLE, dtype=np.uint8)
+    for roundIdx, slots in enumerate(roundSlots):
+        schedule[roundIdx, :len(slots)] = slots
+    return schedule
+
+
+def getScheduleCrc(schedule):
+    return zlib.crc32(schedule.tobytes())
+
+
+def getTxNode(schedule, roundIdx, slotIdx, rxNodeIdx):
+    '''Returns the index of the node transmitting on the channel of node rxNodeIdx in the given slot (None if rxNodeIdx is not receiving)
+    '''
+    entry = schedule[roundIdx][slotIdx][rxNodeIdx]
+    if entry & SCHEDULE_TX:
+        return None
+    txNodeIdx = np.nonzero(schedule[roundIdx][slotIdx] == (SCHEDULE_TX | entry))[0]
+    return txNodeIdx[0] if len(txNodeIdx) else None
+
+
+def writeScheduleHeader(schedule, numChannels, numSamples, path):
+    numRounds, numSlots, numNodes = schedule.shape
+    lines = [
+        '/* generated by Scripts/run_linktest.py --schedule, do not edit */',
+        '',
+        '#ifndef LINKTEST_SCHEDULE_H_',
+        '#define LINKTEST_SCHEDULE_H_',
+        '',
+        '#define LINKTEST_SCHEDULE_NUM_NODES     {}'.format(numNodes),
+        '#define LINKTEST_SCHEDULE_NUM_CHANNELS  {}'.format(numChannels),
+        '#define LINKTEST_SCHEDULE_NUM_SAMPLES   {}'.format(numSamples),
+        '#define LINKTEST_SCHEDULE_NUM_ROUNDS    {}'.format(numRounds),
+        '#define LINKTEST_SCHEDULE_NUM_SLOTS     {}'.format(numSlots),
+        '#define LINKTEST_SCHEDULE_CRC           0x{:08x}'.format(getScheduleCrc(schedule)),
+        '',
+        '/* [round][slot][node index]: 0x80 | channel: transmit, channel: receive, 0xff: idle */',
+        '#define LINKTEST_SCHEDULE_LIST \\',
+    ]
+    for roundIdx in range(numRounds):
+        lines.append('  { /* round ' + str(roundIdx) + ' */ \\')
+        for slotIdx in range(numSlots):
+            lines.append('    { ' + ', '.join(['0x{:02x}'.format(e) for e in schedule[roundIdx][slotIdx]]) + ' }, \\')
+        lines.append('  }, \\')
+    lines += [
+        '',
+        '#endif /* LINKTEST_SCHEDULE_H_ */',
+        '',
+    ]
+    with open(path, 'w') as f:
+        f.write('\n'.join(lines))
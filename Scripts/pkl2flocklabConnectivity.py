@@ -34,28 +34,18 @@ POSSIBILITY OF SUCH DAMAGE.
 @author: romantrueb
 """
 
-import pickle
-import numpy as np
-
-with open('linktest_data_75056.pkl', 'rb' ) as f:
-    d = pickle.load(f)
-    
-
-nodeList = d['nodeList']
-prrMatrix = d['prrMatrix']
-testInfo = d['testInfo']
-
-with open('connectivity_output.txt', 'w') as f:
-    f.write('<?xml version="1.0" encoding="UTF-8" ?>\n<network platform="DPP2LoRa">\n')
-    for txNode in nodeList:
-        for rxNode in nodeList:
-            rxIdx = nodeList.index(rxNode)
-            txIdx = nodeList.index(txNode)
-            if not np.isnan(prrMatrix[rxIdx][txIdx]):
-                f.write('<link src="{txNode}" dest="{rxNode}" prr="{prr:.3f}" numpackets="{numPackets}" />\n'.format(
-                        txNode=txNode, 
-                        rxNode=rxNode, 
-                        prr=prrMatrix[rxIdx][txIdx],
-                        numPackets=testInfo['numTx'],
-                ))
-    f.write('</network>')
+import sys
+import linktest_data
+import linktest_graph
+
+if len(sys.argv) < 2:
+    print('Usage: {} <result directory> [output file]'.format(sys.argv[0]))
+    sys.exit(1)
+
+# result directory generated by eval_linktest.py (use linktest_data.py to convert legacy .pkl files)
+path = sys.argv[1]
+outputFile = sys.argv[2] if len(sys.argv) > 2 else 'connectivity_output.txt'
+d = linktest_data.loadData(path, arrays=['prrMatrix'])
+
+# prrMatrix: rows: tx node, columns: rx node
+linktest_graph.writeFlocklabConnectivity(outputFile, d['nodeList'], d['prrMatrix'], d['testConfig']['numTx'])
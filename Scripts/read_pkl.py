@@ -34,12 +34,14 @@ POSSIBILITY OF SUCH DAMAGE.
 @author: romantrueb
 """
 
-import pickle
+import sys
 import numpy as np
+import linktest_data
+
+# result directory generated by eval_linktest.py (use linktest_data.py to convert legacy .pkl files)
+path = sys.argv[1] if len(sys.argv) > 1 else 'linktest_data_75108'
+d = linktest_data.loadData(path)
 
-with open('linktest_data_75108.pkl', 'rb' ) as f:
-    d = pickle.load(f)
-    
 print(d)
 
 nodeList = d['nodeList']
@@ -37,6 +37,7 @@ POSSIBILITY OF SUCH DAMAGE.
 
 import re
 import os
+import math
 import datetime
 import sys
 import json
@@ -50,6 +51,8 @@ fl = Flocklab()
 # Requires sx1262 library (https://gitlab.ethz.ch/tec/public/flora/sx1262)
 from sx1262.sx1262 import LoraConfig, FskConfig, getGloriaFloodDuration
 
+import linktest_schedule
+
 ###############################################################################
 obsNormal = []   # will be read from config if empty
 obsHg     = []   # (not used)
@@ -60,14 +63,19 @@ print(xmlPath)
 imageNormalId = 'imageNormal'
 imageHgId = 'imageHg'
 imagePath = os.path.join(cwd, '../Debug/comboard_linktest.elf')
+schedulePath = os.path.join(cwd, '../Inc/linktest_schedule.h')
 obsList = obsNormal + obsHg
 
 ###############################################################################
 # CONFIGURATION (for calculation of linktest duration)
 
-FREERTOS_STARTUP = 1.3
-SYNC_DELAY       = 10.0
+FREERTOS_BOOT    = 0.3    # boot until vTask_linktest is running (excl. LINKTEST_STARTUP_DELAY) [s]
+INIT_TIME        = 1.0    # upper bound for printing the config and initializing the linktest (excl. slot calibration) [s]
+SYNC_MARGIN      = 0.5    # all nodes need to wait for the edge of the sync signal (FLOCKLAB_SIG1) [s]
+SYNC_PULSE       = 1.0    # length of the sync pulse [s]
 SLACK            = 10.0
+PONG_HEADER_LEN  = 7      # min. payload length of a reply (linktest_pong_t) [bytes]
+FLASH_ERASE_TIME = 0.025  # upper bound for erasing a flash page (log arena) [s]
 
 ################################################################################
 
@@ -94,6 +102,36 @@ def readConfig(symbol, configFile='../Inc/app_config.h', idx=0):
     return ret
 
 
+def readConfigList(symbol, configFile='../Inc/app_config.h'):
+    """Reads a multi-line list macro (one '{ ... }' initializer per entry) and returns a list of lists of values."""
+    with open(os.path.join(cwd, configFile), 'r') as f:
+        text = f.read()
+
+    ret = re.search(r'^\s*#define\s+{}\s*\\\s*\n((?:.*\\\s*\n)*.*)'.format(symbol), text, re.MULTILINE)
+    if ret is None:
+        raise Exception('ERROR: readConfigList: element "{}" not found'.format(symbol))
+    body = re.sub(r'/\*.*?\*/', '', ret.group(1))
+    entries = []
+    for entry in re.findall(r'\{([^}]*)\}', body):
+        values = [e.strip() for e in entry.split(',')]
+        entries.append([int(v) if v.lstrip('-').isdigit() else v for v in values])
+    return entries
+
+
+def normalizeRadioConfig(radioConfig):
+    radioConfig['RADIOCONFIG_MODULATION'] = radioConfig['RADIOCONFIG_MODULATION'].lower()
+    if 'lora' in radioConfig['RADIOCONFIG_MODULATION']:
+        if radioConfig['RADIOCONFIG_BANDWIDTH'] == 0:
+            radioConfig['RADIOCONFIG_BANDWIDTH'] = 125000
+        elif radioConfig['RADIOCONFIG_BANDWIDTH'] == 1:
+            radioConfig['RADIOCONFIG_BANDWIDTH'] = 250000
+        elif radioConfig['RADIOCONFIG_BANDWIDTH'] == 2:
+            radioConfig['RADIOCONFIG_BANDWIDTH'] = 500000
+        else:
+            raise Exception('LoRa Bandwidth other than 125k, 250k, or 500k are not (yet) implemented!')
+    return radioConfig
+
+
 def readAllConfig():
     config = OrderedDict()
     config['TESTCONFIG_P2P_MODE'] = readConfig('TESTCONFIG_P2P_MODE')
@@ -107,26 +145,50 @@ def readAllConfig():
     config['TESTCONFIG_START_DELAY'] = readConfig('TESTCONFIG_START_DELAY')       # StartDelay [ms]
     config['TESTCONFIG_STOP_DELAY'] = readConfig('TESTCONFIG_STOP_DELAY')         # StopDelay [ms]
     config['TESTCONFIG_SLOT_GAP'] = readConfig('TESTCONFIG_SLOT_GAP')             # TxSlack [ms]
+    config['TESTCONFIG_SLOT_CALIBRATION'] = readConfig('TESTCONFIG_SLOT_CALIBRATION')
+    config['TESTCONFIG_SLOT_LATENCY_MAX'] = readConfig('TESTCONFIG_SLOT_LATENCY_MAX') # [us]
+    config['TESTCONFIG_SLOT_MARGIN'] = readConfig('TESTCONFIG_SLOT_MARGIN')           # [us]
+    config['TESTCONFIG_SLOT_HS_TIMER'] = readConfig('TESTCONFIG_SLOT_HS_TIMER')
+    config['TESTCONFIG_NUM_CONFIGS'] = readConfig('TESTCONFIG_NUM_CONFIGS')
+    config['TESTCONFIG_BER_MODE'] = readConfig('TESTCONFIG_BER_MODE')
+    config['TESTCONFIG_BER_PAYLOAD_LEN'] = readConfig('TESTCONFIG_BER_PAYLOAD_LEN')
+    config['TESTCONFIG_NUM_PAYLOAD_LENS'] = readConfig('TESTCONFIG_NUM_PAYLOAD_LENS')
+    config['TESTCONFIG_PING_PONG'] = readConfig('TESTCONFIG_PING_PONG')
+    config['TESTCONFIG_PONG_DELAY'] = readConfig('TESTCONFIG_PONG_DELAY')       # [us]
+    config['TESTCONFIG_PONG_GUARD'] = readConfig('TESTCONFIG_PONG_GUARD')       # [us]
+    config['TESTCONFIG_NUM_CHANNELS'] = readConfig('TESTCONFIG_NUM_CHANNELS')
+    config['TESTCONFIG_CHANNEL_SPACING'] = readConfig('TESTCONFIG_CHANNEL_SPACING') # [Hz]
+    config['TESTCONFIG_CAPTURE_MODE'] = readConfig('TESTCONFIG_CAPTURE_MODE')
+    config['TESTCONFIG_CAPTURE_OFFSET_LIST'] = [int(v) for v in str(readConfig('TESTCONFIG_CAPTURE_OFFSET_LIST')).split(',')]   # [us]
+    config['TESTCONFIG_LOG_ARENA'] = readConfig('TESTCONFIG_LOG_ARENA')
+    config['TESTCONFIG_LOG_ARENA_SIZE'] = readConfig('TESTCONFIG_LOG_ARENA_SIZE')     # [bytes]
+    config['TESTCONFIG_LOG_ARENA_PAGES'] = readConfig('TESTCONFIG_LOG_ARENA_PAGES')
+    if config['TESTCONFIG_NUM_PAYLOAD_LENS'] > 1:
+        config['TESTCONFIG_PAYLOAD_LEN_LIST'] = [max(2, int(v)) for v in str(readConfig('TESTCONFIG_PAYLOAD_LEN_LIST')).split(',')]
+        if len(config['TESTCONFIG_PAYLOAD_LEN_LIST']) != config['TESTCONFIG_NUM_PAYLOAD_LENS']:
+            raise Exception('TESTCONFIG_PAYLOAD_LEN_LIST contains {} entries, TESTCONFIG_NUM_PAYLOAD_LENS is {}!'.format(len(config['TESTCONFIG_PAYLOAD_LEN_LIST']), config['TESTCONFIG_NUM_PAYLOAD_LENS']))
 
     if config['TESTCONFIG_P2P_MODE']:
         config['RADIOCONFIG_TX_POWER'] = readConfig('RADIOCONFIG_TX_POWER')
         config['RADIOCONFIG_FREQUENCY'] = readConfig('RADIOCONFIG_FREQUENCY')
-        config['RADIOCONFIG_MODULATION'] = readConfig('RADIOCONFIG_MODULATION').lower()
+        config['RADIOCONFIG_MODULATION'] = readConfig('RADIOCONFIG_MODULATION')
         config['RADIOCONFIG_BANDWIDTH'] = readConfig('RADIOCONFIG_BANDWIDTH')
-        if 'lora' in config['RADIOCONFIG_MODULATION']:
-            if config['RADIOCONFIG_BANDWIDTH'] == 0:
-                config['RADIOCONFIG_BANDWIDTH'] = 125000
-            elif config['RADIOCONFIG_BANDWIDTH'] == 1:
-                config['RADIOCONFIG_BANDWIDTH'] = 250000
-            elif config['RADIOCONFIG_BANDWIDTH'] == 2:
-                config['RADIOCONFIG_BANDWIDTH'] = 500000
-            else:
-                raise Exception('LoRa Bandwidth other than 125k, 250k, or 500k are not (yet) implemented!')
         config['RADIOCONFIG_DATARATE'] = readConfig('RADIOCONFIG_DATARATE')
         config['RADIOCONFIG_CODERATE'] = readConfig('RADIOCONFIG_CODERATE')
         config['RADIOCONFIG_IMPLICIT_HEADER'] = readConfig('RADIOCONFIG_IMPLICIT_HEADER')
         config['RADIOCONFIG_CRC_ON'] = readConfig('RADIOCONFIG_CRC_ON')
         config['RADIOCONFIG_PREAMBLE_LEN'] = readConfig('RADIOCONFIG_PREAMBLE_LEN')
+        normalizeRadioConfig(config)
+        # radio configs of the sweep (same order as the fields of linktest_radio_config_t)
+        if config['TESTCONFIG_NUM_CONFIGS'] > 1:
+            keys = ['RADIOCONFIG_TX_POWER', 'RADIOCONFIG_FREQUENCY', 'RADIOCONFIG_MODULATION', 'RADIOCONFIG_DATARATE', 'RADIOCONFIG_BANDWIDTH',
+                    'RADIOCONFIG_CODERATE', 'RADIOCONFIG_PREAMBLE_LEN', 'RADIOCONFIG_IMPLICIT_HEADER', 'RADIOCONFIG_CRC_ON']
+            entries = readConfigList('RADIOCONFIG_LIST')
+            if len(entries) != config['TESTCONFIG_NUM_CONFIGS']:
+                raise Exception('RADIOCONFIG_LIST contains {} entries, TESTCONFIG_NUM_CONFIGS is {}!'.format(len(entries), config['TESTCONFIG_NUM_CONFIGS']))
+            config['RADIOCONFIG_LIST'] = [normalizeRadioConfig(OrderedDict(zip(keys, entry))) for entry in entries]
+        else:
+            config['RADIOCONFIG_LIST'] = [OrderedDict([(k, v) for k, v in config.items() if k.startswith('RADIOCONFIG_')])]
     elif config['TESTCONFIG_FLOOD_MODE']:
         config['FLOODCONFIG_RF_BAND'] = readConfig('FLOODCONFIG_RF_BAND')
         config['FLOODCONFIG_TX_POWER'] = readConfig('FLOODCONFIG_TX_POWER')
@@ -136,6 +198,9 @@ def readAllConfig():
         config['FLOODCONFIG_FLOOD_GAP'] = readConfig('FLOODCONFIG_FLOOD_GAP')
         config['FLOODCONFIG_DELAY_TX'] = readConfig('FLOODCONFIG_DELAY_TX')
         config['FLOODCONFIG_INITIATOR'] = readConfig('FLOODCONFIG_INITIATOR')
+        config['FLOODCONFIG_ADAPTIVE'] = readConfig('FLOODCONFIG_ADAPTIVE')
+        config['FLOODCONFIG_ADAPTIVE_MAX_HOPS'] = readConfig('FLOODCONFIG_ADAPTIVE_MAX_HOPS')
+        config['FLOODCONFIG_ADAPTIVE_GAP'] = readConfig('FLOODCONFIG_ADAPTIVE_GAP')   # [ms]
     else:
         raise Exception('No valid linktest mode selected!')
 
@@ -146,37 +211,95 @@ def readAllConfig():
     return config
 
 
+def getTimeOnAir(radioConfig, payloadLen):
+    if 'lora' in radioConfig['RADIOCONFIG_MODULATION']:
+        loraconfig = LoraConfig()
+        loraconfig.bw = radioConfig['RADIOCONFIG_BANDWIDTH']
+        loraconfig.sf = radioConfig['RADIOCONFIG_DATARATE']
+        loraconfig.phyPl = payloadLen
+        loraconfig.cr = radioConfig['RADIOCONFIG_CODERATE']
+        loraconfig.ih = radioConfig['RADIOCONFIG_IMPLICIT_HEADER']
+        loraconfig.lowDataRate = True if (radioConfig['RADIOCONFIG_DATARATE'] in (11,12)) else False  # sx126x radio driver in flora code automatically enables low data rate optimization for SF11 and SF12 if bandwidth is 125kHz
+        loraconfig.crc = radioConfig['RADIOCONFIG_CRC_ON']
+        loraconfig.nPreambleSyms = radioConfig['RADIOCONFIG_PREAMBLE_LEN']
+        return loraconfig.timeOnAir
+    elif 'fsk' in radioConfig['RADIOCONFIG_MODULATION']:
+        fskconfig = FskConfig()
+        fskconfig.bitrate = radioConfig['RADIOCONFIG_DATARATE']
+        fskconfig.nPreambleBits = radioConfig['RADIOCONFIG_PREAMBLE_LEN']*8 # fsk preamble config is in bytes, sx126x lib expects bits
+        fskconfig.nSyncwordBytes = 2
+        fskconfig.nLengthBytes = 1
+        fskconfig.nAddressBytes = 1
+        fskconfig.phyPl = payloadLen
+        fskconfig.nCrcBytes = 1
+        return fskconfig.timeOnAir
+    else:
+        raise Exception('Unknown modulation!')
+
+
+def getPongWindow(config, radioConfig, payloadLen):
+    '''Returns the duration of the reply sub-slots after each packet (TESTCONFIG_PING_PONG, same as linktest_get_pong_window() in the firmware) [us]
+    '''
+    if not (config['TESTCONFIG_P2P_MODE'] and config['TESTCONFIG_PING_PONG']):
+        return 0
+    pongTimeOnAir = getTimeOnAir(radioConfig, max(payloadLen, PONG_HEADER_LEN))*1e6
+    return config['TESTCONFIG_PONG_DELAY'] + (config['TESTCONFIG_NUM_NODES'] - 1)*(pongTimeOnAir + config['TESTCONFIG_PONG_GUARD'])
+
+
+def getCaptureWindow(config):
+    '''Returns the additional time per slot for the offsets of the concurrent transmissions (TESTCONFIG_CAPTURE_MODE, same as linktest_get_capture_window() in the firmware) [us]
+    '''
+    if not (config['TESTCONFIG_P2P_MODE'] and config['TESTCONFIG_CAPTURE_MODE']):
+        return 0
+    offsets = config['TESTCONFIG_CAPTURE_OFFSET_LIST'] + [0]
+    return readConfig('LINKTEST_CAPTURE_START_DELAY', '../Inc/linktest.h') + max(offsets) - min(offsets)
+
+
+def getLogDumpTime(config):
+    '''Returns an upper bound for the time [s] required to dump the log arena after the last round (same pacing as linktest_arena_dump() in the firmware).
+    '''
+    blockSize = readConfig('LINKTEST_LOG_ARENA_BLOCK_SIZE', '../Inc/linktest_arena.h')
+    dumpRate = readConfig('LINKTEST_LOG_ARENA_DUMP_RATE', '../Inc/linktest_arena.h')
+    numBlocks = config['TESTCONFIG_LOG_ARENA_SIZE']//blockSize + config['TESTCONFIG_LOG_ARENA_PAGES']
+    # all entries are binary records in the worst case (base64 encoded, one line per entry)
+    dumpTime = numBlocks*(math.ceil(blockSize*4/3)/dumpRate + 0.002)
+    print('Log dump: {} blocks, {:.1f} s'.format(numBlocks, dumpTime))
+    return dumpTime
+
+
+def getSyncOffset(config):
+    '''Returns the time [s] after the start of the test at which the sync signal is asserted (startup budget of the nodes).
+    '''
+    startupTime = FREERTOS_BOOT + readConfig('LINKTEST_STARTUP_DELAY', '../Inc/linktest.h')/1e3 + INIT_TIME
+    if config['TESTCONFIG_P2P_MODE'] and config['TESTCONFIG_SLOT_CALIBRATION']:
+        # slot calibration: transmissions with the first payload length (same as linktest_calibrate_slot() in the firmware)
+        payloadLen = len(config['TESTCONFIG_KEY']) + 2
+        if config['TESTCONFIG_BER_MODE']:
+            payloadLen = config['TESTCONFIG_BER_PAYLOAD_LEN'] + 2
+        if config['TESTCONFIG_NUM_PAYLOAD_LENS'] > 1:
+            payloadLen = config['TESTCONFIG_PAYLOAD_LEN_LIST'][0]
+        numTx = readConfig('LINKTEST_CALIBRATION_NUM_TX', configFile='../Inc/linktest.h')
+        startupTime += numTx*(getTimeOnAir(config['RADIOCONFIG_LIST'][0], payloadLen) + config['TESTCONFIG_SLOT_LATENCY_MAX']/1e6)
+    if config['TESTCONFIG_P2P_MODE'] and config['TESTCONFIG_LOG_ARENA']:
+        # flash pages of the log arena are erased before the test (linktest_arena_init())
+        startupTime += config['TESTCONFIG_LOG_ARENA_PAGES']*FLASH_ERASE_TIME
+    syncOffset = math.ceil((startupTime + SYNC_MARGIN)*10)/10
+    print('syncOffset: {:.1f} s'.format(syncOffset))
+    return syncOffset
+
+
 def calculateLinktestDuration(config):
     testDuration = None
+    calibrationTime = 0
     payloadLen = len(config['TESTCONFIG_KEY']) + 2   # +2 for uint16_t counter
+    if config['TESTCONFIG_P2P_MODE'] and config['TESTCONFIG_BER_MODE']:
+        payloadLen = config['TESTCONFIG_BER_PAYLOAD_LEN'] + 2   # PRBS instead of key
     if config['TESTCONFIG_P2P_MODE']:
-        if 'lora' in config['RADIOCONFIG_MODULATION']:
-            loraconfig = LoraConfig()
-            loraconfig.bw = config['RADIOCONFIG_BANDWIDTH']
-            loraconfig.sf = config['RADIOCONFIG_DATARATE']
-            loraconfig.phyPl = payloadLen
-            loraconfig.cr = config['RADIOCONFIG_CODERATE']
-            loraconfig.ih = config['RADIOCONFIG_IMPLICIT_HEADER']
-            loraconfig.lowDataRate = True if (config['RADIOCONFIG_DATARATE'] in (11,12)) else False  # sx126x radio driver in flora code automatically enables low data rate optimization for SF11 and SF12 if bandwidth is 125kHz
-            loraconfig.crc = config['RADIOCONFIG_CRC_ON']
-            loraconfig.nPreambleSyms = config['RADIOCONFIG_PREAMBLE_LEN']
-            timeOnAir = loraconfig.timeOnAir
-        elif 'fsk' in config['RADIOCONFIG_MODULATION']:
-            fskconfig = FskConfig()
-            fskconfig.bitrate = config['RADIOCONFIG_DATARATE']
-            fskconfig.nPreambleBits = config['RADIOCONFIG_PREAMBLE_LEN']*8 # fsk preamble config is in bytes, sx126x lib expects bits
-            fskconfig.nSyncwordBytes = 2
-            fskconfig.nLengthBytes = 1
-            fskconfig.nAddressBytes = 1
-            fskconfig.phyPl = payloadLen
-            fskconfig.nCrcBytes = 1
-            timeOnAir = fskconfig.timeOnAir
-        else:
-            raise Exception('Unknown modulation!')
-
-        slotTime = timeOnAir
-        print('Time-on-air single Tx: {:.6f} s'.format(timeOnAir))
-        print('Tx time per node: {:.6f} s'.format(timeOnAir * config['TESTCONFIG_NUM_SLOTS']))
+        # one slot time per radio config (all rounds are repeated for each config)
+        slotTimes = [getTimeOnAir(radioConfig, payloadLen) for radioConfig in config['RADIOCONFIG_LIST']]
+        for cfgIdx, timeOnAir in enumerate(slotTimes):
+            print('Config {}: Time-on-air single Tx: {:.6f} s'.format(cfgIdx, timeOnAir))
+            print('Config {}: Tx time per node: {:.6f} s'.format(cfgIdx, timeOnAir * config['TESTCONFIG_NUM_SLOTS']))
     elif config['TESTCONFIG_FLOOD_MODE']:
         floodTime = getGloriaFloodDuration(
             modIdx=config['FLOODCONFIG_MODULATION'],
@@ -184,18 +307,70 @@ def calculateLinktestDuration(config):
             nTx=config['FLOODCONFIG_N_TX'],
             numHops=config['FLOODCONFIG_NUM_HOPS'],
         )
-        slotTime = 2*config['FLOODCONFIG_FLOOD_GAP']/1e3 + floodTime
+        slotTimes = [2*config['FLOODCONFIG_FLOOD_GAP']/1e3 + floodTime]
         print('Time for a single flood: {:.6f} s'.format(floodTime))
-        print('slotTime: {:.6f} s'.format(slotTime))
+        print('slotTime: {:.6f} s'.format(slotTimes[0]))
+        if config['FLOODCONFIG_ADAPTIVE']:
+            # calibration and feedback floods with the full budget (same as linktest_flood_calibrate() in the firmware)
+            numFeedback = readConfig('LINKTEST_FLOOD_REPEAT', '../Inc/linktest.h')
+            calibrationTime = (config['TESTCONFIG_NUM_NODES'] + numFeedback)*(slotTimes[0] + config['TESTCONFIG_SLOT_GAP']/1e3)
+            # the rounds use the reduced budget (upper bound)
+            floodTime = getGloriaFloodDuration(
+                modIdx=config['FLOODCONFIG_MODULATION'],
+                phyPlLen=payloadLen,
+                nTx=config['FLOODCONFIG_N_TX'],
+                numHops=config['FLOODCONFIG_ADAPTIVE_MAX_HOPS'],
+            )
+            slotTimes = [2*config['FLOODCONFIG_ADAPTIVE_GAP']/1e3 + floodTime]
+            print('Calibration: {:.6f} s'.format(calibrationTime))
+            print('slotTime (adaptive, max. {} hops): {:.6f} s'.format(config['FLOODCONFIG_ADAPTIVE_MAX_HOPS'], slotTimes[0]))
     else:
         raise Exception('No valid linktest mode selected!')
 
-    slotPeriod = slotTime + config['TESTCONFIG_SLOT_GAP']/1e3
-    roundPeriod = config['TESTCONFIG_SETUP_TIME']/1e3 + config['TESTCONFIG_START_DELAY']/1e3 + (config['TESTCONFIG_NUM_SLOTS']-1)*slotPeriod + slotTime + config['TESTCONFIG_STOP_DELAY']/1e3
+    slotGap = config['TESTCONFIG_SLOT_GAP']/1e3
+    if config['TESTCONFIG_P2P_MODE'] and config['TESTCONFIG_SLOT_CALIBRATION']:
+        # upper bound for calibrated slots (same as linktest_get_slot_gap() in the firmware)
+        slotGap = (math.ceil((config['TESTCONFIG_SLOT_LATENCY_MAX'] + config['TESTCONFIG_SLOT_MARGIN'])/1e3) + 1)/1e3
+        print('slotGap (calibrated slots): {:.6f} s'.format(slotGap))
+    numSlots = config['TESTCONFIG_NUM_SLOTS']
     numRounds = config['TESTCONFIG_NUM_NODES']
-    testDuration = FREERTOS_STARTUP + SYNC_DELAY + numRounds*roundPeriod + SLACK
-    print('numRounds: {}'.format(numRounds))
-    print('RoundPeriod: {:.6f} s'.format(roundPeriod))
+    switchTime = 0   # [us]
+    if config['TESTCONFIG_P2P_MODE'] and config['TESTCONFIG_NUM_CHANNELS'] > 1:
+        # transmissions start after the channel switch of the receivers (same as in linktest_get_slot_budget() in the firmware)
+        switchTime = readConfig('LINKTEST_CHANNEL_SWITCH_TIME', '../Inc/linktest.h')*1e3
+        slotGap += switchTime/1e6
+        # frequency-division parallel rounds (same schedule as Inc/linktest_schedule.h)
+        schedule = linktest_schedule.generateSchedule(config['TESTCONFIG_NUM_NODES'], config['TESTCONFIG_NUM_CHANNELS'], config['TESTCONFIG_NUM_SLOTS'])
+        numRounds, numSlots, _ = schedule.shape
+        print('Schedule: {} rounds with {} slots ({} rounds with {} slots without parallel rounds)'.format(numRounds, numSlots, config['TESTCONFIG_NUM_NODES'], config['TESTCONFIG_NUM_SLOTS']))
+    testDuration = getSyncOffset(config) + SLACK + calibrationTime
+    for cfgIdx, slotTime in enumerate(slotTimes):
+        slotPeriod = slotTime + slotGap
+        slotsTime = (numSlots-1)*slotPeriod + slotTime
+        if config['TESTCONFIG_P2P_MODE'] and config['TESTCONFIG_SLOT_HS_TIMER']:
+            # slots scheduled with the hs_timer (same as linktest_get_slot_budget() in the firmware)
+            if config['TESTCONFIG_SLOT_CALIBRATION']:
+                slotBudget = slotTime*1e6 + config['TESTCONFIG_SLOT_LATENCY_MAX'] + config['TESTCONFIG_SLOT_MARGIN']
+            else:
+                slotBudget = slotTime*1e6 + config['TESTCONFIG_SLOT_GAP']*1e3
+            slotBudget += getPongWindow(config, config['RADIOCONFIG_LIST'][cfgIdx], payloadLen) + switchTime + getCaptureWindow(config)
+            slotsTime = math.ceil(numSlots*slotBudget/1e3)/1e3
+            print('slotBudget (hs_timer): {:.6f} s'.format(slotBudget/1e6))
+        if config['TESTCONFIG_P2P_MODE'] and config['TESTCONFIG_NUM_PAYLOAD_LENS'] > 1:
+            # slots cycle through the payload lengths (same as linktest_get_slots_time() in the firmware)
+            payloadLens = config['TESTCONFIG_PAYLOAD_LEN_LIST']
+            slotGapUs = (config['TESTCONFIG_SLOT_LATENCY_MAX'] + config['TESTCONFIG_SLOT_MARGIN']) if config['TESTCONFIG_SLOT_CALIBRATION'] else config['TESTCONFIG_SLOT_GAP']*1e3
+            lenTimes = [getTimeOnAir(config['RADIOCONFIG_LIST'][cfgIdx], l) for l in payloadLens]
+            for l, timeOnAir in zip(payloadLens, lenTimes):
+                print('Payload length {} B: Time-on-air single Tx: {:.6f} s'.format(l, timeOnAir))
+            slotBudgetSum = sum([lenTimes[s % len(payloadLens)]*1e6 + slotGapUs + switchTime + getCaptureWindow(config) + getPongWindow(config, config['RADIOCONFIG_LIST'][cfgIdx], payloadLens[s % len(payloadLens)]) for s in range(numSlots)])
+            slotsTime = (math.ceil(slotBudgetSum/1e3) + (0 if config['TESTCONFIG_SLOT_HS_TIMER'] else 1))/1e3
+        roundPeriod = config['TESTCONFIG_SETUP_TIME']/1e3 + config['TESTCONFIG_START_DELAY']/1e3 + slotsTime + config['TESTCONFIG_STOP_DELAY']/1e3
+        testDuration += numRounds*roundPeriod
+        print('numRounds: {}'.format(numRounds))
+        print('RoundPeriod: {:.6f} s'.format(roundPeriod))
+    if config['TESTCONFIG_P2P_MODE'] and config['TESTCONFIG_LOG_ARENA']:
+        testDuration += getLogDumpTime(config)
     print('TestDuration: {:.6f} s'.format(testDuration))
 
     return testDuration
@@ -204,12 +379,15 @@ def calculateLinktestDuration(config):
 def getDescription(config):
     ret = ''
     if config['TESTCONFIG_P2P_MODE']:
-        modulation = ""
-        if "lora" in config['RADIOCONFIG_MODULATION']:
-            modulation = "LoRa SF{}".format(config['RADIOCONFIG_DATARATE'])
-        else:
-            modulation = "FSK {:.0f}kbps".format(config['RADIOCONFIG_DATARATE'] / 1e3)
-        ret = "P2P: {}  {:.3f}MHz  {}dBm".format(modulation, config['RADIOCONFIG_FREQUENCY'] / 1e6, config['RADIOCONFIG_TX_POWER'])
+        descs = []
+        for radioConfig in config['RADIOCONFIG_LIST']:
+            modulation = ""
+            if "lora" in radioConfig['RADIOCONFIG_MODULATION']:
+                modulation = "LoRa SF{}".format(radioConfig['RADIOCONFIG_DATARATE'])
+            else:
+                modulation = "FSK {:.0f}kbps".format(radioConfig['RADIOCONFIG_DATARATE'] / 1e3)
+            descs.append("{}  {:.3f}MHz  {}dBm".format(modulation, radioConfig['RADIOCONFIG_FREQUENCY'] / 1e6, radioConfig['RADIOCONFIG_TX_POWER']))
+        ret = "P2P: {}".format(' | '.join(descs))
     elif config['TESTCONFIG_FLOOD_MODE']:
         ret = "FLOOD: modIdx={}, delayTx={}".format(config['FLOODCONFIG_MODULATION'], config['FLOODCONFIG_DELAY_TX'])
     else:
@@ -246,6 +424,10 @@ def create_test():
         raise Exception('FLOCKLAB not set to 1 in "app_config.h"!')
     if imageConfig['TESTCONFIG_NUM_NODES'] != len(obsList):
         raise Exception('TESTCONFIG_NUM_NODES != len(obsList); ({}!={})'.format(imageConfig['TESTCONFIG_NUM_NODES'], len(obsList)))
+    if imageConfig['TESTCONFIG_P2P_MODE'] and imageConfig['TESTCONFIG_NUM_CHANNELS'] > 1:
+        schedule = linktest_schedule.generateSchedule(imageConfig['TESTCONFIG_NUM_NODES'], imageConfig['TESTCONFIG_NUM_CHANNELS'], imageConfig['TESTCONFIG_NUM_SLOTS'])
+        if int(readConfig('LINKTEST_SCHEDULE_CRC', schedulePath), 16) != linktest_schedule.getScheduleCrc(schedule):
+            raise Exception('"linktest_schedule.h" does not match the config, run "run_linktest.py --schedule" and rebuild the image!')
 
     duration = max(int(calculateLinktestDuration(imageConfig))+1, 40) # min FlockLab test duration is 40s
 
@@ -288,8 +470,9 @@ def create_test():
     gpioActuation = GpioActuationConf()
     gpioActuation.obsIds = obsNormal + obsHg
     pinConfList = []
-    pinConfList += [{'pin': 'SIG1', 'level': 1, 'offset': 10.0}]
-    pinConfList += [{'pin': 'SIG1', 'level': 0, 'offset': 11.0}]
+    syncOffset = getSyncOffset(imageConfig)
+    pinConfList += [{'pin': 'SIG1', 'level': 1, 'offset': syncOffset}]
+    pinConfList += [{'pin': 'SIG1', 'level': 0, 'offset': syncOffset + SYNC_PULSE}]
     gpioActuation.pinConfList = pinConfList
     fc.configList.append(gpioActuation)
 
@@ -341,6 +524,18 @@ def run_test():
         print('Test NOT submitted!')
 
 
+def write_schedule():
+    config = readAllConfig()
+    if not (config['TESTCONFIG_P2P_MODE'] and config['TESTCONFIG_NUM_CHANNELS'] > 1):
+        raise Exception('Schedule is only used in P2P mode with TESTCONFIG_NUM_CHANNELS > 1!')
+    schedule = linktest_schedule.generateSchedule(config['TESTCONFIG_NUM_NODES'], config['TESTCONFIG_NUM_CHANNELS'], config['TESTCONFIG_NUM_SLOTS'])
+    linktest_schedule.writeScheduleHeader(schedule, config['TESTCONFIG_NUM_CHANNELS'], config['TESTCONFIG_NUM_SLOTS'], schedulePath)
+    print('Schedule written to {} ({} rounds with {} slots)'.format(schedulePath, schedule.shape[0], schedule.shape[1]))
+
+
 if __name__ == "__main__":
+    if '--schedule' in sys.argv[1:]:
+        write_schedule()
+        sys.exit(0)
     create_test()
     run_test()
@@ -0,0 +1,320 @@
+/*
+ * Copyright (c) 2019 - 2021, ETH Zurich, Computer Engineering Group (TEC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Host simulation of the linktest firmware
+ *
+ * Replaces the parts of the flora lib, the HAL and FreeRTOS used by the
+ * linktest code with a discrete-event simulation. Every simulated node runs
+ * vTask_linktest() in its own process; only one process runs at a time and
+ * the coordinator (sim_main.c) always resumes the node with the earliest
+ * pending event (timeout or radio event) in virtual time.
+ */
+
+#ifndef SIM_H_
+#define SIM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef SIM_MAX_EVENTS
+#define SIM_MAX_EVENTS                32        // max. number of pending radio events per node
+#endif /* SIM_MAX_EVENTS */
+#ifndef SIM_SYNC_TIME_MS
+#define SIM_SYNC_TIME_MS              2000      // virtual time at which FLOCKLAB_SIG1 is asserted
+#endif /* SIM_SYNC_TIME_MS */
+#define SIM_END_PULSE_MS              500       // FLOCKLAB_INT1 high for at least this long marks the end of the test
+#define SIM_MAX_PAYLOAD_LEN           256
+
+
+/* FreeRTOS shim **************************************************************/
+typedef uint32_t TickType_t;
+typedef int32_t  BaseType_t;
+typedef void*    TaskHandle_t;
+#define configTICK_RATE_HZ            1000
+#define pdMS_TO_TICKS(ms)             ((TickType_t)(ms))
+#define portMAX_DELAY                 0xffffffffUL
+#define pdFALSE                       0
+#define pdTRUE                        1
+#define portYIELD_FROM_ISR(x)         (void)(x)
+#define taskENTER_CRITICAL()
+#define taskEXIT_CRITICAL()
+#define taskENTER_CRITICAL_FROM_ISR() 0
+#define taskEXIT_CRITICAL_FROM_ISR(x) (void)(x)
+#define __get_IPSR()                  0         // simulated radio callbacks do not run in an exception handler
+
+void         vTaskDelay(TickType_t ticks);
+void         vTaskDelayUntil(TickType_t* prev_wake_time, TickType_t increment);
+TickType_t   xTaskGetTickCount(void);
+TickType_t   xTaskGetTickCountFromISR(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+uint32_t     ulTaskNotifyTake(BaseType_t clear_count_on_exit, TickType_t ticks_to_wait);
+void         vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higher_priority_task_woken);
+BaseType_t   xTaskNotifyGive(TaskHandle_t task);
+
+
+/* logging ********************************************************************/
+#define LOG_INFO(...)                 sim_log_printf(__VA_ARGS__)
+#define LOG_INFO_CONST(str)           sim_log_printf("%s", str)
+#define LOG_WARNING(...)              sim_log_printf(__VA_ARGS__)
+#define LOG_ERROR(...)                sim_log_printf(__VA_ARGS__)
+#define log_flush()
+
+void sim_log_printf(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+
+
+/* GPIO ***********************************************************************/
+typedef enum {
+  FLOCKLAB_SIG1 = 0,
+  FLOCKLAB_SIG2,
+  FLOCKLAB_INT1,
+  FLOCKLAB_INT2,
+  FLOCKLAB_LED1,
+  FLOCKLAB_LED2,
+  FLOCKLAB_LED3,
+  SIM_NUM_PINS,
+} sim_pin_t;
+
+#define FLOCKLAB_PIN_SET(pin)         sim_pin_set(pin, true)
+#define FLOCKLAB_PIN_CLR(pin)         sim_pin_set(pin, false)
+#define FLOCKLAB_PIN_GET(pin)         sim_pin_get(pin)
+#define RADIO_READ_DIO1_PIN()         0
+
+void sim_pin_set(sim_pin_t pin, bool level);
+bool sim_pin_get(sim_pin_t pin);
+
+/* radio state indication (the radio driver pins FLOCKLAB_LED2/3 are not simulated) */
+#undef  RADIO_TX_START_IND
+#undef  RADIO_TX_STOP_IND
+#undef  RADIO_RX_START_IND
+#undef  RADIO_RX_STOP_IND
+#define RADIO_TX_START_IND()          RADIO_STATE_IND(1)
+#define RADIO_TX_STOP_IND()           RADIO_STATE_IND(0)
+#define RADIO_RX_START_IND()          RADIO_STATE_IND(2)
+#define RADIO_RX_STOP_IND()           RADIO_STATE_IND(0)
+
+/* HAL GPIO and NVIC shims (only the EXTI interrupt of FLOCKLAB_SIG1 is simulated, see ulTaskNotifyTake()) */
+typedef struct {
+  uint32_t Pin;
+  uint32_t Mode;
+  uint32_t Pull;
+  uint32_t Speed;
+} GPIO_InitTypeDef;
+
+#define GPIO_MODE_IT_RISING           0x10110000u
+#define GPIO_NOPULL                   0
+#define COM_TREQ_Pin                  0x0008u
+#define COM_TREQ_GPIO_Port            ((void*)0)
+#define EXTI3_IRQn                    9
+
+void HAL_GPIO_Init(void* port, GPIO_InitTypeDef* init);
+void HAL_NVIC_SetPriority(int irqn, uint32_t preempt_priority, uint32_t sub_priority);
+void HAL_NVIC_EnableIRQ(int irqn);
+void HAL_NVIC_DisableIRQ(int irqn);
+
+/* HAL flash shims (TESTCONFIG_LOG_ARENA_PAGES, the flash is an array of the node process) */
+typedef enum {
+  HAL_OK = 0,
+  HAL_ERROR,
+} HAL_StatusTypeDef;
+
+typedef struct {
+  uint32_t TypeErase;
+  uint32_t Banks;
+  uint32_t Page;
+  uint32_t NbPages;
+} FLASH_EraseInitTypeDef;
+
+#define SIM_FLASH_SIZE                (256 * 1024)
+#define FLASH_BASE                    ((uintptr_t)sim_flash)
+#define FLASH_SIZE                    SIM_FLASH_SIZE
+#define FLASH_PAGE_SIZE               2048
+#define FLASH_BANK_1                  1
+#define FLASH_TYPEERASE_PAGES         0
+#define FLASH_TYPEPROGRAM_DOUBLEWORD  0
+#define FLASH_FLAG_ALL_ERRORS         0
+#define __HAL_FLASH_CLEAR_FLAG(flag)
+#define LINKTEST_LOG_ARENA_IMAGE_END  FLASH_BASE   // no firmware image in the simulated flash
+
+extern uint8_t sim_flash[SIM_FLASH_SIZE];
+
+HAL_StatusTypeDef HAL_FLASH_Unlock(void);
+HAL_StatusTypeDef HAL_FLASH_Lock(void);
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef* erase, uint32_t* page_error);
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t type, uintptr_t address, uint64_t data);
+
+
+/* timers *********************************************************************/
+#define HS_TIMER_FREQUENCY            1000000   // virtual time has a resolution of 1us
+#define LPTIMER_SECOND                32768
+
+uint64_t lptimer_now(void);
+uint64_t RTOS_getActiveTime(void);            // the CPU time is not simulated, always 0
+
+void     hs_timer_capture(void (*callback)(void));
+uint64_t hs_timer_get_current_timestamp(void);
+uint64_t hs_timer_get_capture_timestamp(void);
+void     hs_timer_schedule(uint64_t timestamp, void (*callback)(void));
+bool     sim_hs_timer_pending(uint64_t* timestamp);
+void     sim_hs_timer_fire(void);
+
+
+/* radio **********************************************************************/
+typedef enum {
+  MODEM_FSK = 0,
+  MODEM_LORA,
+} RadioModems_t;
+
+#define IRQ_TX_DONE                   0x0001
+#define IRQ_RX_DONE                   0x0002
+#define IRQ_PREAMBLE_DETECTED         0x0004
+#define IRQ_SYNCWORD_VALID            0x0008
+#define IRQ_HEADER_VALID              0x0010
+#define IRQ_HEADER_ERROR              0x0020
+#define IRQ_CRC_ERROR                 0x0040
+#define IRQ_CAD_DONE                  0x0080
+#define IRQ_CAD_ACTIVITY_DETECTED     0x0100
+#define IRQ_RX_TX_TIMEOUT             0x0200
+
+#define RADIO_DEFAULT_BAND            0
+
+typedef struct {
+  void (*TxDone)(void);
+  void (*TxTimeout)(void);
+  void (*RxDone)(uint8_t* payload, uint16_t size, int16_t rssi, int8_t snr, bool crc_error);
+  void (*RxTimeout)(void);
+  void (*RxError)(void);
+  void (*RxSync)(void);
+  void (*CadDone)(bool detected);
+} RadioEvents_t;
+
+struct Radio_s {
+  void     (*Init)(RadioEvents_t* events);
+  void     (*SetChannel)(uint32_t freq);
+  void     (*SetTxConfig)(RadioModems_t modem, int8_t power, uint32_t fdev, uint32_t bandwidth, uint32_t datarate,
+                          uint8_t coderate, uint16_t preambleLen, bool fixLen, bool crcOn, bool freqHopOn,
+                          uint8_t hopPeriod, bool iqInverted, uint32_t timeout);
+  void     (*SetRxConfig)(RadioModems_t modem, uint32_t bandwidth, uint32_t datarate, uint8_t coderate,
+                          uint32_t bandwidthAfc, uint16_t preambleLen, uint16_t symbTimeout, bool fixLen,
+                          uint8_t payloadLen, bool crcOn, bool freqHopOn, uint8_t hopPeriod, bool iqInverted);
+  uint32_t (*TimeOnAir)(RadioModems_t modem, uint32_t bandwidth, uint32_t datarate, uint8_t coderate,
+                        uint16_t preambleLen, bool fixLen, uint8_t payloadLen, bool crcOn);
+  void     (*SendPayload)(uint8_t* buffer, uint8_t size);
+  void     (*RxBoostedMask)(uint32_t mask, uint32_t timeout, bool rx_continuous, bool preamble_irq);
+  void     (*Standby)(void);
+  void     (*IrqProcess)(void);
+};
+
+typedef struct {
+  uint32_t centerFrequency;
+} radio_band_t;
+
+extern const radio_band_t radio_bands[];
+extern void (*RadioOnDioIrqCallback)(void);
+
+int32_t radio_get_rx_bandwidth(uint32_t frequency, uint32_t bandwidth);
+
+
+/* simulation core ************************************************************/
+typedef enum {
+  SIM_EVT_TX_DONE = 0,
+  SIM_EVT_RX_SYNC,
+  SIM_EVT_RX_DONE,
+} sim_event_type_t;
+
+typedef struct {
+  uint64_t time;                                // virtual time [us] at which the event fires
+  uint8_t  type;                                // sim_event_type_t
+  uint8_t  size;
+  int16_t  rssi;
+  int8_t   snr;
+  bool     crc_error;
+  uint8_t  payload[SIM_MAX_PAYLOAD_LEN];
+} sim_event_t;
+
+typedef struct {
+  RadioModems_t modem;
+  uint32_t frequency;
+  uint32_t bandwidth;
+  uint32_t datarate;
+  uint8_t  coderate;
+  uint16_t preamble_len;
+  bool     implicit_header;
+  bool     crc_on;
+  int8_t   tx_power;
+} sim_radio_config_t;
+
+typedef enum {
+  SIM_RADIO_STANDBY = 0,
+  SIM_RADIO_RX,
+  SIM_RADIO_TX,
+} sim_radio_state_t;
+
+typedef struct {
+  uint64_t           deadline;                  // virtual time [us] until which the node is blocked
+  bool               done;
+  bool               pins[SIM_NUM_PINS];
+  uint64_t           int1_set_time;
+  sim_radio_state_t  radio_state;
+  sim_radio_config_t tx_config;
+  sim_radio_config_t rx_config;
+  uint64_t           rx_busy_until;             // end of the packet which is currently being received
+  uint64_t           rx_start;                  // start of the packet which is currently being received
+  uint64_t           rx_sync;                   // end of the preamble of the packet which is currently being received
+  double             rx_rssi;                   // RSSI of the packet which is currently being received [dBm]
+  int64_t            clock_offset;              // offset of the local hs_timer [us]
+  double             clock_drift;               // relative drift of the local hs_timer (local = global * (1 + drift) + offset)
+  uint32_t           num_events;
+  sim_event_t        events[SIM_MAX_EVENTS];    // pending events (sorted by time)
+} sim_node_t;
+
+typedef struct {
+  uint64_t   now;                               // current virtual time [us]
+  uint64_t   rng_state;
+  float      pathloss[TESTCONFIG_NUM_NODES][TESTCONFIG_NUM_NODES];  // [tx][rx] in dB (NAN: no link)
+  sim_node_t node[TESTCONFIG_NUM_NODES];
+} sim_shared_t;
+
+extern sim_shared_t* sim;
+extern int           sim_node_idx;             // index of the node running in this process
+
+void     sim_yield(void);
+void     sim_block_until(uint64_t t);
+void     sim_node_exit(void);
+void     sim_event_push(int node_idx, const sim_event_t* evt);
+uint64_t sim_next_event_time(int node_idx);
+double   sim_rand(void);
+void     sim_radio_process_events(void);
+void     sim_log_open(const char* path);
+
+#endif /* SIM_H_ */
@@ -0,0 +1,330 @@
+/*
+ * Copyright (c) 2019 - 2021, ETH Zurich, Computer Engineering Group (TEC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * @brief  Host simulation of the linktest: coordinator and path loss model
+ */
+
+#include "main.h"
+#include <math.h>
+#include <unistd.h>
+#include <signal.h>
+#include <getopt.h>
+#include <time.h>
+#include <semaphore.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+extern const uint16_t TESTCONFIG_NODE_LIST[];
+
+/* path loss model for the generated topology */
+#define SIM_PL_D0                     40.0f     // path loss at 1m [dB]
+#define SIM_PL_EXPONENT               3.5f
+#define SIM_PL_SHADOWING              4.0f      // stddev of the log-normal shadowing [dB]
+
+typedef struct {
+  sem_t coord;
+  sem_t node[TESTCONFIG_NUM_NODES];
+} sim_sync_t;
+
+/* Global variables */
+sim_shared_t* sim          = 0;
+int           sim_node_idx = -1;
+uint16_t      FLOCKLAB_NODE_ID;
+
+/* Private variables */
+static sim_sync_t* sync_ctx = 0;
+static uint64_t    num_switches = 0;
+
+
+/******************************************************************************
+ * Scheduling
+ ******************************************************************************/
+
+/* hand control back to the coordinator and wait until resumed */
+void sim_yield(void) {
+  sem_post(&sync_ctx->coord);
+  while (sem_wait(&sync_ctx->node[sim_node_idx]) != 0);
+}
+
+void sim_block_until(uint64_t t) {
+  sim_node_t* n = &sim->node[sim_node_idx];
+  n->deadline = t;
+  for (;;) {
+    sim_radio_process_events();
+    if (sim->now >= t) {
+      break;
+    }
+    sim_yield();
+  }
+}
+
+void sim_node_exit(void) {
+  sim->node[sim_node_idx].done = true;
+  sem_post(&sync_ctx->coord);
+  _exit(0);
+}
+
+static int sim_next_node(uint64_t* t_next) {
+  int      next = -1;
+  uint64_t t_min = UINT64_MAX;
+  int      i;
+  for (i = 0; i < TESTCONFIG_NUM_NODES; i++) {
+    if (sim->node[i].done) {
+      continue;
+    }
+    uint64_t t = sim->node[i].deadline;
+    uint64_t t_evt = sim_next_event_time(i);
+    if (t_evt < t) {
+      t = t_evt;
+    }
+    if (t < t_min) {
+      t_min = t;
+      next  = i;
+    }
+  }
+  *t_next = t_min;
+  return next;
+}
+
+static void sim_run_node(int idx) {
+  sim_node_idx     = idx;
+  FLOCKLAB_NODE_ID = TESTCONFIG_NODE_LIST[idx];
+  while (sem_wait(&sync_ctx->node[idx]) != 0);
+  vTask_linktest(NULL);
+  sim_node_exit();
+}
+
+
+/******************************************************************************
+ * Topology
+ ******************************************************************************/
+double sim_rand(void) {
+  /* xorshift64* (state is shared, runs are deterministic since only one process is active at a time) */
+  uint64_t x = sim->rng_state;
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  sim->rng_state = x;
+  return (double)((x * 2685821657736338717ULL) >> 11) / (double)(1ULL << 53);
+}
+
+static double sim_rand_normal(void) {
+  double u1 = sim_rand();
+  double u2 = sim_rand();
+  if (u1 < 1e-12) {
+    u1 = 1e-12;
+  }
+  return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+static void sim_generate_pathloss(float area) {
+  float x[TESTCONFIG_NUM_NODES];
+  float y[TESTCONFIG_NUM_NODES];
+  int   i, j;
+  for (i = 0; i < TESTCONFIG_NUM_NODES; i++) {
+    x[i] = sim_rand() * area;
+    y[i] = sim_rand() * area;
+  }
+  for (i = 0; i < TESTCONFIG_NUM_NODES; i++) {
+    sim->pathloss[i][i] = NAN;
+    for (j = i + 1; j < TESTCONFIG_NUM_NODES; j++) {
+      float d = hypotf(x[i] - x[j], y[i] - y[j]);
+      if (d < 1.0f) {
+        d = 1.0f;
+      }
+      float pl = SIM_PL_D0 + 10.0f * SIM_PL_EXPONENT * log10f(d);
+      // shadowing is the same in both directions, fading is added per packet
+      pl += SIM_PL_SHADOWING * sim_rand_normal();
+      sim->pathloss[i][j] = pl;
+      sim->pathloss[j][i] = pl;
+    }
+  }
+}
+
+/* CSV file with TESTCONFIG_NUM_NODES rows and columns, entry [tx][rx] in dB, 'nan' or empty for no link */
+static bool sim_load_pathloss(const char* path) {
+  FILE* f = fopen(path, "r");
+  char  line[16 * TESTCONFIG_NUM_NODES + 64];
+  int   row = 0;
+  if (!f) {
+    return false;
+  }
+  while (row < TESTCONFIG_NUM_NODES && fgets(line, sizeof(line), f)) {
+    if (line[0] == '#' || line[0] == '\n') {
+      continue;
+    }
+    char* p = line;
+    int   col;
+    for (col = 0; col < TESTCONFIG_NUM_NODES; col++) {
+      char* end;
+      float v = strtof(p, &end);
+      sim->pathloss[row][col] = (end == p) ? NAN : v;
+      p = strchr(end, ',');
+      if (!p) {
+        break;
+      }
+      p++;
+    }
+    if (col < TESTCONFIG_NUM_NODES - 1) {
+      fclose(f);
+      return false;
+    }
+    row++;
+  }
+  fclose(f);
+  return (row == TESTCONFIG_NUM_NODES);
+}
+
+
+/******************************************************************************
+ * Clocks
+ ******************************************************************************/
+/* random hs_timer offset (within 1s) and drift (within +-ppm) per node */
+static void sim_generate_clocks(double ppm) {
+  int i;
+  for (i = 0; i < TESTCONFIG_NUM_NODES; i++) {
+    sim->node[i].clock_offset = (int64_t)(sim_rand() * 1e6);
+    sim->node[i].clock_drift  = (2.0 * sim_rand() - 1.0) * ppm * 1e-6;
+    printf("node %u: clock offset %lldus, drift %.3fppm\n", (unsigned)TESTCONFIG_NODE_LIST[i], (long long)sim->node[i].clock_offset, sim->node[i].clock_drift * 1e6);
+  }
+}
+
+
+/******************************************************************************
+ * Main
+ ******************************************************************************/
+static void sim_usage(const char* name) {
+  printf("usage: %s [-o serial.csv] [-p pathloss.csv] [-a area] [-s seed] [-t max_time] [-c ppm]\n"
+         "  -o  output file in FlockLab serial format (default: serial.csv)\n"
+         "  -p  path loss matrix [dB] (CSV, %d x %d, row: tx, column: rx)\n"
+         "  -a  side length [m] of the square area with random node positions if no path loss matrix is given (default: 1000)\n"
+         "  -s  random seed (default: 1)\n"
+         "  -t  max. virtual time [s] (default: 86400)\n"
+         "  -c  max. clock drift [ppm] of the hs_timer, enables random clock offsets and drifts per node (default: ideal clocks)\n",
+         name, TESTCONFIG_NUM_NODES, TESTCONFIG_NUM_NODES);
+}
+
+int main(int argc, char** argv) {
+  const char* out_path = "serial.csv";
+  const char* pl_path  = 0;
+  float       area     = 1000.0f;
+  uint64_t    seed     = 1;
+  double      max_time = 86400.0;
+  double      ppm      = 0.0;
+  bool        clocks   = false;
+  pid_t       pids[TESTCONFIG_NUM_NODES];
+  int         opt, i;
+
+  while ((opt = getopt(argc, argv, "o:p:a:s:t:c:h")) != -1) {
+    switch (opt) {
+      case 'o': out_path = optarg; break;
+      case 'p': pl_path  = optarg; break;
+      case 'a': area     = strtof(optarg, 0); break;
+      case 's': seed     = strtoull(optarg, 0, 0); break;
+      case 't': max_time = strtod(optarg, 0); break;
+      case 'c': ppm      = strtod(optarg, 0); clocks = true; break;
+      default:
+        sim_usage(argv[0]);
+        return (opt == 'h') ? 0 : 1;
+    }
+  }
+
+  sim      = mmap(0, sizeof(sim_shared_t), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  sync_ctx = mmap(0, sizeof(sim_sync_t), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (sim == MAP_FAILED || sync_ctx == MAP_FAILED) {
+    perror("mmap");
+    return 1;
+  }
+  memset(sim, 0, sizeof(sim_shared_t));
+  sim->rng_state = seed ? seed : 1;
+
+  if (pl_path) {
+    if (!sim_load_pathloss(pl_path)) {
+      fprintf(stderr, "failed to load path loss matrix from '%s'\n", pl_path);
+      return 1;
+    }
+  } else {
+    sim_generate_pathloss(area);
+  }
+  if (clocks) {
+    sim_generate_clocks(ppm);
+  }
+  sim_log_open(out_path);
+
+  sem_init(&sync_ctx->coord, 1, 0);
+  for (i = 0; i < TESTCONFIG_NUM_NODES; i++) {
+    sem_init(&sync_ctx->node[i], 1, 0);
+  }
+  fflush(stdout);
+  for (i = 0; i < TESTCONFIG_NUM_NODES; i++) {
+    pids[i] = fork();
+    if (pids[i] < 0) {
+      perror("fork");
+      return 1;
+    }
+    if (pids[i] == 0) {
+      sim_run_node(i);
+    }
+  }
+
+  /* discrete-event loop: resume the node with the earliest pending event */
+  struct timespec ts_start, ts_end;
+  clock_gettime(CLOCK_MONOTONIC, &ts_start);
+  const uint64_t t_max = (uint64_t)(max_time * 1e6);
+  for (;;) {
+    uint64_t t_next;
+    int      next = sim_next_node(&t_next);
+    if (next < 0 || t_next > t_max) {
+      break;
+    }
+    if (t_next > sim->now) {
+      sim->now = t_next;
+    }
+    num_switches++;
+    sem_post(&sync_ctx->node[next]);
+    while (sem_wait(&sync_ctx->coord) != 0);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &ts_end);
+
+  for (i = 0; i < TESTCONFIG_NUM_NODES; i++) {
+    if (!sim->node[i].done) {
+      kill(pids[i], SIGKILL);
+    }
+    waitpid(pids[i], 0, 0);
+  }
+
+  printf("simulated %d nodes, virtual time %.3fs, wall time %.3fs, %llu context switches\n",
+         TESTCONFIG_NUM_NODES,
+         sim->now / 1e6,
+         (ts_end.tv_sec - ts_start.tv_sec) + (ts_end.tv_nsec - ts_start.tv_nsec) / 1e9,
+         (unsigned long long)num_switches);
+  return 0;
+}
@@ -0,0 +1,439 @@
+/*
+ * Copyright (c) 2019 - 2021, ETH Zurich, Computer Engineering Group (TEC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * @brief  Host simulation: SX126x radio driver stub and shared radio medium
+ */
+
+#include "main.h"
+
+/* reception model */
+#define SIM_NOISE_FIGURE              6.0       // receiver noise figure [dB]
+#define SIM_FADING_STDDEV             1.0       // per packet fading [dB]
+#define SIM_FSK_SNR_MIN               10.0      // min. SNR [dB] required for FSK reception
+#define SIM_CRC_ERROR_RATIO           0.5       // ratio of failed receptions which result in a RxDone with CRC error (others are not detected at all)
+#define SIM_CAPTURE_THRESHOLD         6.0       // min. power difference [dB] for the stronger of two overlapping packets to be received
+#define SIM_CT_TOLERANCE              3         // max. offset [us] of identical packets which are combined non-destructively (concurrent transmissions)
+
+/* Global variables */
+const radio_band_t radio_bands[] = {
+  { .centerFrequency = 868000000 },
+};
+static void sim_radio_on_dio_irq(void) { }
+void (*RadioOnDioIrqCallback)(void) = sim_radio_on_dio_irq;
+
+/* Private variables */
+static RadioEvents_t* radio_events     = 0;
+static void         (*capture_callback)(void) = 0;
+static uint64_t       capture_timestamp = 0;
+static void         (*schedule_callback)(void) = 0;
+static uint64_t       schedule_timestamp = 0;
+static sim_event_t    current_event;
+static bool           rx_continuous     = false;
+
+
+/******************************************************************************
+ * Event queue
+ ******************************************************************************/
+void sim_event_push(int node_idx, const sim_event_t* evt) {
+  sim_node_t* n = &sim->node[node_idx];
+  uint32_t    i;
+  if (n->num_events >= SIM_MAX_EVENTS) {
+    return;
+  }
+  // insert sorted by time (stable)
+  i = n->num_events;
+  while (i > 0 && n->events[i - 1].time > evt->time) {
+    n->events[i] = n->events[i - 1];
+    i--;
+  }
+  n->events[i] = *evt;
+  n->num_events++;
+}
+
+/* returns the pending event of the given type and time or NULL */
+static sim_event_t* sim_event_find(int node_idx, uint8_t type, uint64_t time) {
+  sim_node_t* n = &sim->node[node_idx];
+  uint32_t    i;
+  for (i = 0; i < n->num_events; i++) {
+    if (n->events[i].type == type && n->events[i].time == time) {
+      return &n->events[i];
+    }
+  }
+  return 0;
+}
+
+static void sim_event_remove(int node_idx, sim_event_t* evt) {
+  sim_node_t* n = &sim->node[node_idx];
+  if (evt) {
+    n->num_events--;
+    memmove(evt, evt + 1, (uint32_t)(&n->events[n->num_events] - evt) * sizeof(sim_event_t));
+  }
+}
+
+uint64_t sim_next_event_time(int node_idx) {
+  sim_node_t* n = &sim->node[node_idx];
+  return n->num_events ? n->events[0].time : UINT64_MAX;
+}
+
+/* executes the "interrupts" of all radio events which are due */
+void sim_radio_process_events(void) {
+  sim_node_t* n = &sim->node[sim_node_idx];
+  while (n->num_events && n->events[0].time <= sim->now) {
+    current_event = n->events[0];
+    n->num_events--;
+    memmove(&n->events[0], &n->events[1], n->num_events * sizeof(sim_event_t));
+
+    capture_timestamp = current_event.time;
+    if (capture_callback) {
+      capture_callback();
+    } else {
+      Radio.IrqProcess();
+    }
+  }
+}
+
+
+/******************************************************************************
+ * Timers
+ ******************************************************************************/
+/* the hs_timer of each node runs on its local clock, virtual time is global */
+static uint64_t sim_local_time(uint64_t t) {
+  const sim_node_t* n = &sim->node[sim_node_idx];
+  return (uint64_t)((int64_t)t + n->clock_offset + (int64_t)((double)t * n->clock_drift));
+}
+
+static uint64_t sim_global_time(uint64_t t) {
+  const sim_node_t* n = &sim->node[sim_node_idx];
+  return (uint64_t)((double)((int64_t)t - n->clock_offset) / (1.0 + n->clock_drift) + 0.5);
+}
+
+void hs_timer_capture(void (*callback)(void)) {
+  capture_callback = callback;
+}
+
+uint64_t hs_timer_get_current_timestamp(void) {
+  return sim_local_time(sim->now);
+}
+
+uint64_t hs_timer_get_capture_timestamp(void) {
+  return sim_local_time(capture_timestamp);
+}
+
+void hs_timer_schedule(uint64_t timestamp, void (*callback)(void)) {
+  schedule_timestamp = sim_global_time(timestamp);
+  schedule_callback  = callback;
+}
+
+bool sim_hs_timer_pending(uint64_t* timestamp) {
+  if (schedule_callback) {
+    *timestamp = schedule_timestamp;
+    return true;
+  }
+  return false;
+}
+
+void sim_hs_timer_fire(void) {
+  /* one-shot compare, the callback may schedule the next compare */
+  void (*callback)(void) = schedule_callback;
+  schedule_callback = 0;
+  if (callback) {
+    callback();
+  }
+}
+
+
+/******************************************************************************
+ * Helper Functions
+ ******************************************************************************/
+static uint32_t sim_bandwidth_hz(RadioModems_t modem, uint32_t bandwidth) {
+  if (modem == MODEM_LORA) {
+    return 125000 << ((bandwidth <= 2) ? bandwidth : 0);
+  }
+  return bandwidth;
+}
+
+static double sim_snr_min(const sim_radio_config_t* cfg) {
+  if (cfg->modem == MODEM_LORA) {
+    return -20.0 + 2.5 * (12 - (int32_t)cfg->datarate);
+  }
+  return SIM_FSK_SNR_MIN;
+}
+
+static double sim_preamble_time(const sim_radio_config_t* cfg) {
+  if (cfg->modem == MODEM_LORA) {
+    double t_sym = (double)(1 << cfg->datarate) * 1e6 / sim_bandwidth_hz(MODEM_LORA, cfg->bandwidth);
+    return (cfg->preamble_len + ((cfg->datarate <= 6) ? 6.25 : 4.25)) * t_sym;
+  }
+  return (cfg->preamble_len + 2) * 8 * 1e6 / cfg->datarate;
+}
+
+static bool sim_config_match(const sim_radio_config_t* tx, const sim_radio_config_t* rx) {
+  return (tx->modem == rx->modem) && (tx->frequency == rx->frequency) && (tx->datarate == rx->datarate) &&
+         ((tx->modem == MODEM_FSK) || (tx->bandwidth == rx->bandwidth));
+}
+
+static double sim_rand_normal(void) {
+  double u1 = sim_rand();
+  double u2 = sim_rand();
+  if (u1 < 1e-12) {
+    u1 = 1e-12;
+  }
+  return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+/* determines whether and how node rx_idx receives a packet transmitted by the current node */
+static void sim_transmit_to(int rx_idx, const uint8_t* buffer, uint8_t size, uint64_t t_end) {
+  sim_node_t*               tx  = &sim->node[sim_node_idx];
+  sim_node_t*               rx  = &sim->node[rx_idx];
+  const sim_radio_config_t* cfg = &tx->tx_config;
+  float                     pl  = sim->pathloss[sim_node_idx][rx_idx];
+
+  if (isnan(pl) || rx->radio_state != SIM_RADIO_RX || !sim_config_match(cfg, &rx->rx_config)) {
+    return;
+  }
+  double rssi   = cfg->tx_power - pl + SIM_FADING_STDDEV * sim_rand_normal();
+  double noise  = -174.0 + 10.0 * log10(sim_bandwidth_hz(cfg->modem, cfg->bandwidth)) + SIM_NOISE_FIGURE;
+  double margin = (rssi - noise) - sim_snr_min(cfg);
+  if (margin < -3.0) {
+    return;   // preamble not detected
+  }
+
+  sim_event_t evt;
+  memset(&evt, 0, sizeof(evt));
+  evt.rssi = (int16_t)lround(rssi);
+  evt.snr  = (int8_t)fmax(-128.0, fmin(127.0, lround(rssi - noise)));
+  evt.size = size;
+  memcpy(evt.payload, buffer, size);
+
+  if (rx->rx_busy_until > sim->now) {
+    /* overlapping packets: capture effect based on the power difference */
+    sim_event_t* done = sim_event_find(rx_idx, SIM_EVT_RX_DONE, rx->rx_busy_until);
+    if (done && !done->crc_error && done->size == size && memcmp(done->payload, buffer, size) == 0 &&
+        (sim->now - rx->rx_start) <= SIM_CT_TOLERANCE) {
+      // identical packet, (almost) synchronous: no interference
+      return;
+    }
+    if ((sim->now < rx->rx_sync) && (rssi - rx->rx_rssi >= SIM_CAPTURE_THRESHOLD)) {
+      // stronger packet during the preamble: the receiver re-synchronizes to the new packet
+      sim_event_remove(rx_idx, sim_event_find(rx_idx, SIM_EVT_RX_SYNC, rx->rx_sync));
+      sim_event_remove(rx_idx, sim_event_find(rx_idx, SIM_EVT_RX_DONE, rx->rx_busy_until));
+    } else {
+      if ((rx->rx_rssi - rssi < SIM_CAPTURE_THRESHOLD) && done && !done->crc_error) {
+        // interference: the current packet is corrupted
+        done->crc_error = true;
+        if (done->size) {
+          done->payload[(uint32_t)(sim_rand() * done->size) % done->size] ^= (uint8_t)(1 + sim_rand() * 254);
+        }
+      }
+      return;
+    }
+  }
+
+  bool success = (sim_rand() < 1.0 / (1.0 + exp(-1.5 * margin)));
+  if (!success) {
+    if (sim_rand() >= SIM_CRC_ERROR_RATIO) {
+      return;
+    }
+    // corrupt a random byte of the payload
+    evt.crc_error = true;
+    if (size) {
+      evt.payload[(uint32_t)(sim_rand() * size) % size] ^= (uint8_t)(1 + sim_rand() * 254);
+    }
+  }
+  rx->rx_busy_until = t_end;
+  rx->rx_start      = sim->now;
+  rx->rx_sync       = sim->now + (uint64_t)sim_preamble_time(cfg);
+  rx->rx_rssi       = rssi;
+
+  evt.type = SIM_EVT_RX_SYNC;
+  evt.time = sim->now + (uint64_t)sim_preamble_time(cfg);
+  sim_event_push(rx_idx, &evt);
+  evt.type = SIM_EVT_RX_DONE;
+  evt.time = t_end;
+  sim_event_push(rx_idx, &evt);
+}
+
+
+/******************************************************************************
+ * Radio driver
+ ******************************************************************************/
+static void sim_radio_init(RadioEvents_t* events) {
+  radio_events = events;
+  sim->node[sim_node_idx].radio_state = SIM_RADIO_STANDBY;
+}
+
+static void sim_radio_set_channel(uint32_t freq) {
+  sim->node[sim_node_idx].tx_config.frequency = freq;
+  sim->node[sim_node_idx].rx_config.frequency = freq;
+}
+
+static void sim_radio_set_tx_config(RadioModems_t modem, int8_t power, uint32_t fdev, uint32_t bandwidth, uint32_t datarate,
+                                    uint8_t coderate, uint16_t preambleLen, bool fixLen, bool crcOn, bool freqHopOn,
+                                    uint8_t hopPeriod, bool iqInverted, uint32_t timeout) {
+  sim_radio_config_t* cfg = &sim->node[sim_node_idx].tx_config;
+  cfg->modem           = modem;
+  cfg->tx_power        = power;
+  cfg->bandwidth       = bandwidth;
+  cfg->datarate        = datarate;
+  cfg->coderate        = coderate;
+  cfg->preamble_len    = preambleLen;
+  cfg->implicit_header = fixLen;
+  cfg->crc_on          = crcOn;
+}
+
+static void sim_radio_set_rx_config(RadioModems_t modem, uint32_t bandwidth, uint32_t datarate, uint8_t coderate,
+                                    uint32_t bandwidthAfc, uint16_t preambleLen, uint16_t symbTimeout, bool fixLen,
+                                    uint8_t payloadLen, bool crcOn, bool freqHopOn, uint8_t hopPeriod, bool iqInverted) {
+  sim_radio_config_t* cfg = &sim->node[sim_node_idx].rx_config;
+  cfg->modem           = modem;
+  cfg->bandwidth       = bandwidth;
+  cfg->datarate        = datarate;
+  cfg->coderate        = coderate;
+  cfg->preamble_len    = preambleLen;
+  cfg->implicit_header = fixLen;
+  cfg->crc_on          = crcOn;
+}
+
+/* returns the time-on-air in us (SX126x datasheet, chapter 6.1.4 and 6.2.3) */
+static uint32_t sim_radio_time_on_air(RadioModems_t modem, uint32_t bandwidth, uint32_t datarate, uint8_t coderate,
+                                      uint16_t preambleLen, bool fixLen, uint8_t payloadLen, bool crcOn) {
+  if (modem == MODEM_LORA) {
+    uint32_t sf     = datarate;
+    uint32_t bw     = sim_bandwidth_hz(MODEM_LORA, bandwidth);
+    bool     ldro   = (sf >= 11) && (bw == 125000);
+    double   t_sym  = (double)(1 << sf) * 1e6 / bw;
+    double   n_pre  = preambleLen + ((sf <= 6) ? 6.25 : 4.25);
+    int32_t  bits   = 8 * payloadLen + (crcOn ? 16 : 0) - 4 * sf + (fixLen ? 0 : 20) + ((sf <= 6) ? 0 : 8);
+    int32_t  div    = 4 * (sf - (ldro ? 2 : 0));
+    int32_t  n_pl   = 8 + ((bits > 0) ? ((bits + div - 1) / div) : 0) * (coderate + 4);
+    return (uint32_t)((n_pre + n_pl) * t_sym);
+  }
+  // FSK: preamble, 2 byte sync word, length and address byte, payload, CRC
+  uint32_t bits = 8 * (preambleLen + 2 + 2 + payloadLen + (crcOn ? 2 : 0));
+  return (uint32_t)((uint64_t)bits * 1000000 / datarate);
+}
+
+/* radio state transition, marked with the radio driver indication macros */
+static void sim_radio_set_state(sim_node_t* n, sim_radio_state_t state) {
+  if (n->radio_state == state) {
+    return;
+  }
+  if (n->radio_state == SIM_RADIO_TX) {
+    RADIO_TX_STOP_IND();
+  } else if (n->radio_state == SIM_RADIO_RX) {
+    RADIO_RX_STOP_IND();
+  }
+  n->radio_state = state;
+  if (state == SIM_RADIO_TX) {
+    RADIO_TX_START_IND();
+  } else if (state == SIM_RADIO_RX) {
+    RADIO_RX_START_IND();
+  }
+}
+
+static void sim_radio_send_payload(uint8_t* buffer, uint8_t size) {
+  sim_node_t* n = &sim->node[sim_node_idx];
+  const sim_radio_config_t* cfg = &n->tx_config;
+  uint64_t t_end = sim->now + sim_radio_time_on_air(cfg->modem, cfg->bandwidth, cfg->datarate, cfg->coderate,
+                                                    cfg->preamble_len, cfg->implicit_header, size, cfg->crc_on);
+  int i;
+
+  sim_radio_set_state(n, SIM_RADIO_TX);
+  for (i = 0; i < TESTCONFIG_NUM_NODES; i++) {
+    if (i != sim_node_idx) {
+      sim_transmit_to(i, buffer, size, t_end);
+    }
+  }
+  sim_event_t evt;
+  memset(&evt, 0, sizeof(evt));
+  evt.type = SIM_EVT_TX_DONE;
+  evt.time = t_end;
+  sim_event_push(sim_node_idx, &evt);
+}
+
+static void sim_radio_rx_boosted_mask(uint32_t mask, uint32_t timeout, bool continuous, bool preamble_irq) {
+  sim_radio_set_state(&sim->node[sim_node_idx], SIM_RADIO_RX);
+  rx_continuous = continuous;
+}
+
+static void sim_radio_standby(void) {
+  sim_radio_set_state(&sim->node[sim_node_idx], SIM_RADIO_STANDBY);
+}
+
+static void sim_radio_irq_process(void) {
+  sim_node_t* n = &sim->node[sim_node_idx];
+  if (!radio_events) {
+    return;
+  }
+  switch (current_event.type) {
+    case SIM_EVT_TX_DONE:
+      if (n->radio_state == SIM_RADIO_TX) {
+        sim_radio_set_state(n, SIM_RADIO_STANDBY);
+        if (radio_events->TxDone) {
+          radio_events->TxDone();
+        }
+      }
+      break;
+    case SIM_EVT_RX_SYNC:
+      if (n->radio_state == SIM_RADIO_RX && radio_events->RxSync) {
+        radio_events->RxSync();
+      }
+      break;
+    case SIM_EVT_RX_DONE:
+      if (n->radio_state == SIM_RADIO_RX) {
+        if (!rx_continuous) {
+          sim_radio_set_state(n, SIM_RADIO_STANDBY);
+        }
+        if (radio_events->RxDone) {
+          radio_events->RxDone(current_event.payload, current_event.size, current_event.rssi, current_event.snr, current_event.crc_error);
+        }
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+int32_t radio_get_rx_bandwidth(uint32_t frequency, uint32_t bandwidth) {
+  return (int32_t)bandwidth;
+}
+
+const struct Radio_s Radio = {
+  .Init          = sim_radio_init,
+  .SetChannel    = sim_radio_set_channel,
+  .SetTxConfig   = sim_radio_set_tx_config,
+  .SetRxConfig   = sim_radio_set_rx_config,
+  .TimeOnAir     = sim_radio_time_on_air,
+  .SendPayload   = sim_radio_send_payload,
+  .RxBoostedMask = sim_radio_rx_boosted_mask,
+  .Standby       = sim_radio_standby,
+  .IrqProcess    = sim_radio_irq_process,
+};
@@ -0,0 +1,242 @@
+/*
+ * Copyright (c) 2019 - 2021, ETH Zurich, Computer Engineering Group (TEC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * @brief  Host simulation: FreeRTOS, GPIO and timer shims based on virtual time
+ */
+
+#include "main.h"
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdarg.h>
+
+/* Private variables */
+static int               log_fd = -1;
+static volatile uint32_t notify_value = 0;
+static bool              sync_irq_enabled = false;
+
+
+/******************************************************************************
+ * FreeRTOS
+ ******************************************************************************/
+uint64_t lptimer_now(void) {
+  return sim->now * LPTIMER_SECOND / 1000000;
+}
+
+uint64_t RTOS_getActiveTime(void) {
+  return 0;
+}
+
+TickType_t xTaskGetTickCount(void) {
+  return (TickType_t)(sim->now / (1000000 / configTICK_RATE_HZ));
+}
+
+TickType_t xTaskGetTickCountFromISR(void) {
+  return xTaskGetTickCount();
+}
+
+void vTaskDelay(TickType_t ticks) {
+  /* a long pulse on INT1 marks the end of the test (see vTask_linktest) */
+  if (sim_pin_get(FLOCKLAB_INT1) && ticks >= pdMS_TO_TICKS(SIM_END_PULSE_MS)) {
+    sim_node_exit();
+  }
+  sim_block_until(sim->now + (uint64_t)ticks * (1000000 / configTICK_RATE_HZ));
+}
+
+void vTaskDelayUntil(TickType_t* prev_wake_time, TickType_t increment) {
+  *prev_wake_time += increment;
+  uint64_t t = (uint64_t)(*prev_wake_time) * (1000000 / configTICK_RATE_HZ);
+  if (t > sim->now) {
+    sim_block_until(t);
+  }
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+  /* each node runs a single task */
+  return (TaskHandle_t)&notify_value;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_count_on_exit, TickType_t ticks_to_wait) {
+  uint64_t t_timeout = sim->now + (uint64_t)ticks_to_wait * (1000000 / configTICK_RATE_HZ);
+  uint64_t t_sync    = (uint64_t)SIM_SYNC_TIME_MS * 1000;
+  uint64_t t_compare;
+  uint32_t ret;
+
+  /* block until notified by a (simulated) interrupt or until the timeout expires */
+  while (!notify_value && sim->now < t_timeout) {
+    uint64_t t = t_timeout;
+    bool     compare = sim_hs_timer_pending(&t_compare) && (t_compare < t_timeout);
+    bool     sync    = sync_irq_enabled && (sim->now < t_sync) && (t_sync < t_timeout);
+    if (compare) {
+      t = t_compare;
+    }
+    if (sync && t_sync <= t) {
+      t       = t_sync;
+      compare = false;
+    } else {
+      sync = false;
+    }
+    sim_block_until(t);
+    if (compare) {
+      sim_hs_timer_fire();
+    }
+#if TESTCONFIG_SYNC_EXTI
+    if (sync) {
+      // rising edge of FLOCKLAB_SIG1 (EXTI3_IRQHandler)
+      linktest_sync_isr();
+    }
+#endif /* TESTCONFIG_SYNC_EXTI */
+  }
+  ret = notify_value;
+  if (ret) {
+    notify_value = clear_count_on_exit ? 0 : (ret - 1);
+  }
+  return ret;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higher_priority_task_woken) {
+  notify_value++;
+  if (higher_priority_task_woken) {
+    *higher_priority_task_woken = pdTRUE;
+  }
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+  notify_value++;
+  return pdTRUE;
+}
+
+
+/******************************************************************************
+ * GPIO
+ ******************************************************************************/
+void sim_pin_set(sim_pin_t pin, bool level) {
+  sim->node[sim_node_idx].pins[pin] = level;
+}
+
+void HAL_GPIO_Init(void* port, GPIO_InitTypeDef* init) {
+  /* nothing to do */
+}
+
+void HAL_NVIC_SetPriority(int irqn, uint32_t preempt_priority, uint32_t sub_priority) {
+  /* nothing to do */
+}
+
+void HAL_NVIC_EnableIRQ(int irqn) {
+  if (irqn == EXTI3_IRQn) {
+    sync_irq_enabled = true;
+  }
+}
+
+void HAL_NVIC_DisableIRQ(int irqn) {
+  if (irqn == EXTI3_IRQn) {
+    sync_irq_enabled = false;
+  }
+}
+
+uint8_t sim_flash[SIM_FLASH_SIZE] __attribute__((aligned(8)));
+
+HAL_StatusTypeDef HAL_FLASH_Unlock(void) {
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Lock(void) {
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef* erase, uint32_t* page_error) {
+  if ((erase->Page + erase->NbPages) * FLASH_PAGE_SIZE > SIM_FLASH_SIZE) {
+    *page_error = erase->Page;
+    return HAL_ERROR;
+  }
+  memset(&sim_flash[erase->Page * FLASH_PAGE_SIZE], 0xff, erase->NbPages * FLASH_PAGE_SIZE);
+  *page_error = 0xffffffff;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t type, uintptr_t address, uint64_t data) {
+  uint64_t dword;
+  if ((address < FLASH_BASE) || (address + sizeof(dword) > FLASH_BASE + SIM_FLASH_SIZE) || (address % sizeof(dword))) {
+    return HAL_ERROR;
+  }
+  /* programming can only clear bits */
+  memcpy(&dword, (void*)address, sizeof(dword));
+  dword &= data;
+  memcpy((void*)address, &dword, sizeof(dword));
+  return HAL_OK;
+}
+
+bool sim_pin_get(sim_pin_t pin) {
+  if (pin == FLOCKLAB_SIG1) {
+    // sync signal from the testbed
+    return sim->now >= (uint64_t)SIM_SYNC_TIME_MS * 1000;
+  }
+  return sim->node[sim_node_idx].pins[pin];
+}
+
+
+/******************************************************************************
+ * Logging (FlockLab serial.csv format)
+ ******************************************************************************/
+void sim_log_open(const char* path) {
+  static const char header[] = "# timestamp,observer_id,node_id,direction,output\n";
+  log_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+  if (log_fd < 0) {
+    perror(path);
+    exit(1);
+  }
+  if (write(log_fd, header, sizeof(header) - 1) < 0) {
+    perror(path);
+  }
+}
+
+void sim_log_printf(const char* fmt, ...) {
+  char    msg[512];
+  char    line[600];
+  va_list args;
+  int     len;
+
+  va_start(args, fmt);
+  vsnprintf(msg, sizeof(msg), fmt, args);
+  va_end(args);
+  len = snprintf(line, sizeof(line), "%llu.%06llu,%u,%u,r,%s\n",
+                 (unsigned long long)(sim->now / 1000000),
+                 (unsigned long long)(sim->now % 1000000),
+                 FLOCKLAB_NODE_ID,
+                 FLOCKLAB_NODE_ID,
+                 msg);
+  if (len > (int)sizeof(line)) {
+    len = sizeof(line);
+    line[len - 1] = '\n';
+  }
+  if (write(log_fd, line, len) < 0) {
+    perror("write");
+  }
+}
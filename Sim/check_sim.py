@@ -0,0 +1,104 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Copyright (c) 2019 - 2021, ETH Zurich, Computer Engineering Group (TEC)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+
+
+@author: romantrueb
+@brief:  Checks the extraction of simulated linktest logs (see 'make check')
+
+Every log (<dir>/serial.csv) is extracted twice, with the streaming extractor (records in the order of the file) and with
+the dataframe path (records sorted by timestamp). Both results and the results of the reference log (first argument) must
+contain the same arrays, i.e. config variants which only change the logging (e.g. binary records or the log arena) must not
+change the results.
+
+Usage:
+  ./check_sim.py data_sim/0 data_sim/arena
+"""
+
+import sys
+import os
+import numpy as np
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'Scripts'))
+import eval_linktest
+
+################################################################################
+
+def getArrays(d):
+    return {key: value for key, value in d.items() if isinstance(value, np.ndarray)}
+
+
+def compareResults(dRef, d, name):
+    '''Returns the list of differences between the arrays of two extracted results
+    '''
+    errors = []
+    ref, arr = getArrays(dRef), getArrays(d)
+    if dRef['nodeList'] != d['nodeList']:
+        errors.append('{}: nodeList differs'.format(name))
+    for key in sorted(set(ref) ^ set(arr)):
+        errors.append('{}: {} missing in {}'.format(name, key, 'result' if key in ref else 'reference'))
+    for key in sorted(set(ref) & set(arr)):
+        if ref[key].shape != arr[key].shape or not np.allclose(ref[key], arr[key], equal_nan=True):
+            errors.append('{}: {} differs'.format(name, key))
+    return errors
+
+
+################################################################################
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        print('Usage: {} <reference dir> [<dir> ...]'.format(sys.argv[0]))
+        sys.exit(1)
+
+    errors = []
+    dListRef = None
+    for path in sys.argv[1:]:
+        serialPath = os.path.join(path, 'serial.csv')
+        dListStreaming = eval_linktest.extractDataStreaming(serialPath)
+        dListPandas = eval_linktest.extractDataPandas(serialPath)
+        if dListRef is None:
+            dListRef = dListStreaming
+        if len(dListStreaming) != len(dListRef) or len(dListPandas) != len(dListRef):
+            errors.append('{}: number of configs differs'.format(path))
+            continue
+        for configIdx, (dRef, dStreaming, dPandas) in enumerate(zip(dListRef, dListStreaming, dListPandas)):
+            name = '{} (config {})'.format(path, configIdx)
+            errors += compareResults(dStreaming, dPandas, name + ' streaming vs. dataframe')
+            errors += compareResults(dRef, dStreaming, name + ' vs. reference')
+            numClockLinks = np.sum(~np.isnan(dStreaming['clockOffsetMatrix'])) if 'clockOffsetMatrix' in dStreaming else 0
+            print('{}: {} links, {} with clock fit'.format(name, np.sum(~np.isnan(dStreaming['prrMatrix'])), numClockLinks))
+
+    for error in errors:
+        print('ERROR: ' + error)
+    if errors:
+        sys.exit(1)
+    print('OK')
@@ -54,6 +54,7 @@
 /* USER CODE BEGIN Variables */
 /* RTOS Task Handles ---------------------------------------------------------*/
 TaskHandle_t xTaskHandle_linktest = NULL;
+TaskHandle_t xTaskHandle_linktest_log = NULL;
 /* RTOS Queue Handles --------------------------------------------------------*/
 /* Variables */
 bool     round_finished   = false;
@@ -168,10 +169,18 @@ void RTOS_Init(void)
 {
   if(xTaskCreate(vTask_linktest,
           "linktestTask",
-          configMINIMAL_STACK_SIZE + 128,
+          configMINIMAL_STACK_SIZE + 128 + LINKTEST_LOG_STACK_SIZE + LINKTEST_FLOOD_TRACE_STACK_SIZE,
           NULL,
-          tskIDLE_PRIORITY + 1,
+          LINKTEST_TASK_PRIORITY,
           &xTaskHandle_linktest) != pdPASS)  { Error_Handler(); }
+#if TESTCONFIG_LOG_DEFERRED
+  if(xTaskCreate(vTask_linktest_log,
+          "linktestLogTask",
+          configMINIMAL_STACK_SIZE + 128 + LINKTEST_LOG_STACK_SIZE,
+          NULL,
+          tskIDLE_PRIORITY + 1,
+          &xTaskHandle_linktest_log) != pdPASS)  { Error_Handler(); }
+#endif /* TESTCONFIG_LOG_DEFERRED */
 }
 
 uint32_t RTOS_getDutyCycle(void)
@@ -179,6 +188,12 @@ uint32_t RTOS_getDutyCycle(void)
   return (uint32_t)((active_time * 10000) / lptimer_now());
 }
 
+/* total CPU active time since startup [lptimer ticks], must be called while the CPU is active */
+uint64_t RTOS_getActiveTime(void)
+{
+  return active_time + (lptimer_now() - wakeup_timestamp);
+}
+
 /* USER CODE END Application */
 
 /************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -56,46 +56,683 @@ void linktest_sanitize_string(char *payload, uint8_t size) {
   }
 }
 
+char* linktest_u64_to_str(uint64_t value, char* buf) {
+  /* decimal representation of a 64-bit value (no 64-bit printf support required), buf must hold LINKTEST_U64_STR_LEN chars */
+  char     tmp[LINKTEST_U64_STR_LEN];
+  uint32_t n = 0;
+  uint32_t i;
+  do {
+    tmp[n++] = '0' + (value % 10);
+    value /= 10;
+  } while (value);
+  for (i = 0; i < n; i++) {
+    buf[i] = tmp[n - 1 - i];
+  }
+  buf[n] = 0;
+  return buf;
+}
+
+/******************************************************************************
+ * Sync Signal
+ ******************************************************************************/
+#if TESTCONFIG_SYNC_EXTI
+
+static TaskHandle_t        sync_task     = NULL;
+static volatile bool       sync_captured = false;
+static volatile uint64_t   sync_ts       = 0;       // hs_timer timestamp of the rising edge of FLOCKLAB_SIG1
+static volatile TickType_t sync_tick     = 0;       // tick count at the rising edge of FLOCKLAB_SIG1
+
+void linktest_sync_isr(void) {
+  /* rising edge of FLOCKLAB_SIG1 (EXTI interrupt, the pending flag is cleared by the HAL handler) */
+  uint64_t   ts = hs_timer_get_current_timestamp();
+  BaseType_t higher_prio_task_woken = pdFALSE;
+
+  if (sync_captured) {
+    return;
+  }
+  sync_ts       = ts;
+  sync_tick     = xTaskGetTickCountFromISR();
+  sync_captured = true;
+  if (sync_task) {
+    vTaskNotifyGiveFromISR(sync_task, &higher_prio_task_woken);
+  }
+  portYIELD_FROM_ISR(higher_prio_task_woken);
+}
+
+#endif /* TESTCONFIG_SYNC_EXTI */
+
+uint64_t linktest_wait_for_sync(TickType_t* syncTick) {
+  /* blocks until the rising edge of FLOCKLAB_SIG1, returns its hs_timer timestamp and the tick count at the edge */
+#if TESTCONFIG_SYNC_EXTI
+  GPIO_InitTypeDef gpio_init = {0};
+
+  sync_task = xTaskGetCurrentTaskHandle();
+  ulTaskNotifyTake(pdTRUE, 0);    // clear pending notifications
+  gpio_init.Pin  = LINKTEST_SYNC_PIN;
+  gpio_init.Mode = GPIO_MODE_IT_RISING;
+  gpio_init.Pull = GPIO_NOPULL;
+  HAL_GPIO_Init(LINKTEST_SYNC_GPIO_PORT, &gpio_init);
+  HAL_NVIC_SetPriority(LINKTEST_SYNC_IRQN, LINKTEST_SYNC_IRQ_PRIO, 0);
+  HAL_NVIC_EnableIRQ(LINKTEST_SYNC_IRQN);
+
+  taskENTER_CRITICAL();
+  if (!sync_captured && FLOCKLAB_PIN_GET(FLOCKLAB_SIG1)) {
+    /* signal has been asserted before the interrupt was enabled (edge missed) */
+    sync_ts       = hs_timer_get_current_timestamp();
+    sync_tick     = xTaskGetTickCount();
+    sync_captured = true;
+    taskEXIT_CRITICAL();
+    LOG_WARNING("sync edge missed (FLOCKLAB_SIG1 already high)");
+  } else {
+    taskEXIT_CRITICAL();
+  }
+  while (!sync_captured) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  }
+  HAL_NVIC_DisableIRQ(LINKTEST_SYNC_IRQN);
+  sync_task = NULL;
+
+  *syncTick = sync_tick;
+  return sync_ts;
+#else
+  while (FLOCKLAB_PIN_GET(FLOCKLAB_SIG1) == 0) {
+    vTaskDelay(pdMS_TO_TICKS(1));
+  }
+  *syncTick = xTaskGetTickCount();
+  return hs_timer_get_current_timestamp();
+#endif /* TESTCONFIG_SYNC_EXTI */
+}
+
+
 /******************************************************************************
  * Linktest with point-to-point (P2P) transmissions
  ******************************************************************************/
 #if TESTCONFIG_P2P_MODE
 
-void linktest_init(uint32_t *slotTime) {
-  linktest_radio_init();
-
-  // /* Calculate SlotTime */
-  linktest_message_t msg = {
-    .counter=0,
-    .key=TESTCONFIG_KEY,
-  };
-  uint16_t key_length = 0;
-  key_length = strlen(msg.key);
-  key_length = (key_length > 254) ? 254 : key_length;
-  *slotTime = Radio.TimeOnAir(
+#if TESTCONFIG_NUM_CONFIGS > 1
+static const linktest_radio_config_t radio_configs[] = {
+  RADIOCONFIG_LIST
+};
+_Static_assert(sizeof(radio_configs) / sizeof(radio_configs[0]) == TESTCONFIG_NUM_CONFIGS, "RADIOCONFIG_LIST must contain TESTCONFIG_NUM_CONFIGS entries");
+#else
+static const linktest_radio_config_t radio_configs[] = {
+  {
+    RADIOCONFIG_TX_POWER,
+    RADIOCONFIG_FREQUENCY,
     RADIOCONFIG_MODULATION,
-    RADIOCONFIG_BANDWIDTH,
     RADIOCONFIG_DATARATE,
+    RADIOCONFIG_BANDWIDTH,
     RADIOCONFIG_CODERATE,
     RADIOCONFIG_PREAMBLE_LEN,
-    0,  // fixLen
-    sizeof(msg.counter) + key_length,
+    RADIOCONFIG_IMPLICIT_HEADER,
     RADIOCONFIG_CRC_ON
-  )/1000; // TimeOnAir returns us, we need ms
+  },
+};
+#endif /* TESTCONFIG_NUM_CONFIGS */
+static const linktest_radio_config_t* radio_cfg = &radio_configs[0];   // config of the current round
+static uint8_t                        radio_cfg_idx = 0;
+static volatile uint16_t              slot_idx = 0;                     // slot of the current round (updated on all nodes)
 
-  // workaround for no successful rx in FSK mode if no Tx happened before
-  // simple Radio.Send alone with 0 size payload does not work
-  if (RADIOCONFIG_MODULATION == MODEM_FSK) {
+#if TESTCONFIG_NUM_PAYLOAD_LENS > 1
+static const uint8_t payload_lens[] = {
+  TESTCONFIG_PAYLOAD_LEN_LIST
+};
+_Static_assert(sizeof(payload_lens) / sizeof(payload_lens[0]) == TESTCONFIG_NUM_PAYLOAD_LENS, "TESTCONFIG_PAYLOAD_LEN_LIST must contain TESTCONFIG_NUM_PAYLOAD_LENS entries");
+#endif /* TESTCONFIG_NUM_PAYLOAD_LENS */
+static uint32_t           time_on_air[TESTCONFIG_NUM_CONFIGS][TESTCONFIG_NUM_PAYLOAD_LENS];   // per radio config and payload length [us] (calculated in linktest_init())
+static linktest_message_t tx_msg = {
+  .counter=0,
+  .key=TESTCONFIG_KEY,
+};
+
+uint16_t linktest_get_payload_len(uint8_t lenIdx) {
+#if TESTCONFIG_BER_MODE
+  return LINKTEST_BER_MSG_LEN;
+#elif TESTCONFIG_NUM_PAYLOAD_LENS > 1
+  // at least the counter, the key is repeated to fill longer payloads (see linktest_init())
+  return (payload_lens[lenIdx] < sizeof(tx_msg.counter)) ? sizeof(tx_msg.counter) : payload_lens[lenIdx];
+#else
+  uint16_t key_length = strlen(TESTCONFIG_KEY);
+  key_length = (key_length > 254) ? 254 : key_length;
+  return sizeof(tx_msg.counter) + key_length;
+#endif /* TESTCONFIG_BER_MODE */
+}
+
+const linktest_radio_config_t* linktest_get_radio_config(uint8_t cfgIdx) {
+  return (cfgIdx < TESTCONFIG_NUM_CONFIGS) ? &radio_configs[cfgIdx] : 0;
+}
+
+uint32_t linktest_get_time_on_air(uint8_t cfgIdx, uint8_t lenIdx) {
+  // time-on-air of a linktest packet [us]
+  return time_on_air[cfgIdx][lenIdx];
+}
+
+#if TESTCONFIG_SLOT_CALIBRATION
+static uint64_t          slot_latency    = 0;      // calibrated TxDone latency incl. margin [hs_timer ticks]
+static volatile bool     calib_active    = false;
+static volatile bool     calib_txdone    = false;
+static volatile uint64_t calib_txdone_ts = 0;
+
+static void linktest_calibrate_slot(uint32_t timeOnAir, linktest_message_t* msg, uint16_t msg_len) {
+  const uint64_t toa_ticks         = LINKTEST_US_TO_HS_TICKS(timeOnAir);
+  const uint64_t latency_max_ticks = LINKTEST_US_TO_HS_TICKS(TESTCONFIG_SLOT_LATENCY_MAX);
+  uint64_t latency = 0;
+  uint32_t i;
+
+  if (radio_cfg->modulation == MODEM_LORA) {
+    linktest_set_tx_config_lora();
+  }
+  else {
     linktest_set_tx_config_fsk();
+  }
+
+  calib_active = true;
+  for (i = 0; i < LINKTEST_CALIBRATION_NUM_TX; i++) {
+    uint32_t timeout = LINKTEST_CALIBRATION_TIMEOUT;
     Radio.Standby();
-    Radio.SendPayload((uint8_t*) &msg, sizeof(msg.counter) + key_length);
-    // Radio.Send((uint8_t*) &msg, 0);
+    calib_txdone = false;
+    uint64_t start_ts = hs_timer_get_current_timestamp();
+    Radio.SendPayload((uint8_t*) msg, msg_len);
+    while (!calib_txdone && timeout) {
+      vTaskDelay(pdMS_TO_TICKS(1));
+      timeout--;
+    }
+    if (!calib_txdone) {
+      LOG_WARNING("slot calibration failed (no TxDone)");
+      latency = latency_max_ticks;
+      break;
+    }
+    // latency between the start of the slot and the end of the TxDone processing, excluding the time-on-air
+    uint64_t elapsed = calib_txdone_ts - start_ts;
+    if (elapsed > toa_ticks && (elapsed - toa_ticks) > latency) {
+      latency = elapsed - toa_ticks;
+    }
+  }
+  calib_active = false;
+  Radio.Standby();
+
+  // the round period is based on TESTCONFIG_SLOT_LATENCY_MAX, slots must not exceed this budget
+  if (latency > latency_max_ticks) {
+    LOG_WARNING("TxDone latency exceeds TESTCONFIG_SLOT_LATENCY_MAX");
+    latency = latency_max_ticks;
+  }
+  slot_latency = latency + LINKTEST_US_TO_HS_TICKS(TESTCONFIG_SLOT_MARGIN);
+
+  LOG_INFO("{\"type\":\"SlotCalibration\","
+           "\"timeOnAir\":%lu,"
+           "\"latency\":%lu,"
+           "\"slotPeriod\":%lu}",
+    timeOnAir,
+    (uint32_t)(latency * 1000000 / HS_TIMER_FREQUENCY),
+    (uint32_t)((toa_ticks + slot_latency) * 1000000 / HS_TIMER_FREQUENCY)
+  );
+}
+
+uint32_t linktest_get_slot_gap(void) {
+  // upper bound of latency and margin (identical on all nodes), +1ms since the slot time is truncated to ms
+  return (TESTCONFIG_SLOT_LATENCY_MAX + TESTCONFIG_SLOT_MARGIN + 999) / 1000 + 1;
+}
+#endif /* TESTCONFIG_SLOT_CALIBRATION */
+
+#if TESTCONFIG_NUM_CHANNELS > 1
+static const uint8_t schedule[LINKTEST_SCHEDULE_NUM_ROUNDS][LINKTEST_SCHEDULE_NUM_SLOTS][LINKTEST_SCHEDULE_NUM_NODES] = {
+  LINKTEST_SCHEDULE_LIST
+};
+static uint8_t radio_channel = 0;         // channel index of the current radio config
+static bool    radio_rx_on   = false;
+
+static uint8_t linktest_schedule_prepare_slot(uint16_t roundIdx, uint16_t slotIdx) {
+  // switches the radio to the channel and mode of the own schedule entry of the slot and returns the entry
+  uint8_t nodeIdx;
+  for (nodeIdx = 0; nodeIdx < TESTCONFIG_NUM_NODES && TESTCONFIG_NODE_LIST[nodeIdx] != NODE_ID; nodeIdx++);
+  uint8_t entry   = (nodeIdx < TESTCONFIG_NUM_NODES) ? schedule[LINKTEST_ROUND_GROUP(roundIdx)][slotIdx][nodeIdx] : LINKTEST_SCHEDULE_IDLE;
+  uint8_t channel = entry & ~LINKTEST_SCHEDULE_TX;
+
+  if (entry == LINKTEST_SCHEDULE_IDLE || (entry & LINKTEST_SCHEDULE_TX) || channel != radio_channel) {
+    if (radio_rx_on) {
+      Radio.Standby();
+      radio_rx_on = false;
+    }
+    if (entry == LINKTEST_SCHEDULE_IDLE) {
+      return entry;
+    }
+  }
+  if (channel != radio_channel) {
+    Radio.SetChannel(radio_cfg->frequency + channel * TESTCONFIG_CHANNEL_SPACING);
+    radio_channel = channel;
+  }
+  if (!(entry & LINKTEST_SCHEDULE_TX) && !radio_rx_on) {
+    // start rx mode (with deactivated preamble IRQs)
+    Radio.RxBoostedMask(LINKTEST_IRQ_MASK, 0, true, false);
+    radio_rx_on = true;
+  }
+  return entry;
+}
+#endif /* TESTCONFIG_NUM_CHANNELS */
+
+#if TESTCONFIG_CAPTURE_MODE
+static const int32_t capture_offsets[] = {
+  TESTCONFIG_CAPTURE_OFFSET_LIST
+};
+_Static_assert(sizeof(capture_offsets) / sizeof(capture_offsets[0]) == TESTCONFIG_NUM_CAPTURE_OFFSETS, "TESTCONFIG_CAPTURE_OFFSET_LIST must contain TESTCONFIG_NUM_CAPTURE_OFFSETS entries");
+static uint64_t capture_slot_start = 0;   // hs_timer timestamp of the start of the current slot
+
+int32_t linktest_get_capture_offset(uint8_t offsetIdx) {
+  return capture_offsets[offsetIdx];
+}
+
+static void linktest_get_capture_range(int32_t* min, int32_t* max) {
+  // range of the offsets incl. 0 (reference slots) [us]
+  uint8_t i;
+  *min = 0;
+  *max = 0;
+  for (i = 0; i < TESTCONFIG_NUM_CAPTURE_OFFSETS; i++) {
+    *min = (capture_offsets[i] < *min) ? capture_offsets[i] : *min;
+    *max = (capture_offsets[i] > *max) ? capture_offsets[i] : *max;
+  }
+}
+
+static uint32_t linktest_get_capture_window(void) {
+  // time from the start of the slot to the start of the later transmission in the worst case [us]
+  int32_t min, max;
+  linktest_get_capture_range(&min, &max);
+  return LINKTEST_CAPTURE_START_DELAY + (uint32_t)(max - min);
+}
+
+void linktest_capture_set_slot_start(uint64_t timestamp) {
+  capture_slot_start = timestamp;
+}
+
+static bool linktest_capture_tx(uint16_t roundIdx, uint16_t slotIdx) {
+  // returns true if the node transmits in this slot (returns at the start of the transmission)
+  bool    first  = (TESTCONFIG_NODE_LIST[LINKTEST_ROUND_NODE_IDX(roundIdx)] == NODE_ID);
+  bool    second = (TESTCONFIG_NODE_LIST[LINKTEST_CAPTURE_NODE_IDX(roundIdx)] == NODE_ID);
+  uint8_t k      = slotIdx % LINKTEST_CAPTURE_CYCLE;
+  int32_t min, max;
+
+  if (!(first || second) || (first && k == 1) || (second && k == 0)) {
+    return false;
+  }
+  // the first transmitter starts LINKTEST_CAPTURE_START_DELAY after the earliest possible second transmission
+  linktest_get_capture_range(&min, &max);
+  int32_t delay = LINKTEST_CAPTURE_START_DELAY - min;
+  if (second && k >= 2) {
+    delay += capture_offsets[k - 2];
+  }
+  linktest_wait_until(capture_slot_start + LINKTEST_US_TO_HS_TICKS(delay));
+  return true;
+}
+#endif /* TESTCONFIG_CAPTURE_MODE */
+
+#if TESTCONFIG_PING_PONG
+static uint32_t pong_time_on_air[TESTCONFIG_NUM_CONFIGS][TESTCONFIG_NUM_PAYLOAD_LENS];   // time-on-air of a reply [us] (calculated in linktest_init())
+
+static uint16_t linktest_get_pong_len(uint8_t lenIdx) {
+  // replies have the same length as the packet (reverse link is measured with the same time-on-air), at least the reply header
+  uint16_t len = linktest_get_payload_len(lenIdx);
+  return (len < sizeof(linktest_pong_t)) ? sizeof(linktest_pong_t) : len;
+}
+
+static uint32_t linktest_get_pong_subslot(uint8_t cfgIdx, uint8_t lenIdx) {
+  // period of the reply sub-slots [us]
+  return pong_time_on_air[cfgIdx][lenIdx] + TESTCONFIG_PONG_GUARD;
+}
+
+static uint32_t linktest_get_pong_window(uint8_t cfgIdx, uint8_t lenIdx) {
+  // time between the end of the packet and the end of the last reply sub-slot [us], all nodes except the transmitter reply
+  return TESTCONFIG_PONG_DELAY + (TESTCONFIG_NUM_NODES - 1) * linktest_get_pong_subslot(cfgIdx, lenIdx);
+}
+#endif /* TESTCONFIG_PING_PONG */
+
+static uint32_t linktest_get_slot_budget(uint8_t cfgIdx, uint8_t lenIdx) {
+  // time per slot [us] used to calculate the round period (identical on all nodes)
+  uint32_t budget;
+#if TESTCONFIG_SLOT_CALIBRATION
+  budget = time_on_air[cfgIdx][lenIdx] + TESTCONFIG_SLOT_LATENCY_MAX + TESTCONFIG_SLOT_MARGIN;
+#else
+  budget = time_on_air[cfgIdx][lenIdx] + TESTCONFIG_SLOT_GAP * 1000;
+#endif /* TESTCONFIG_SLOT_CALIBRATION */
+#if TESTCONFIG_PING_PONG
+  budget += linktest_get_pong_window(cfgIdx, lenIdx);
+#endif /* TESTCONFIG_PING_PONG */
+#if TESTCONFIG_NUM_CHANNELS > 1
+  budget += LINKTEST_CHANNEL_SWITCH_TIME * 1000;
+#endif /* TESTCONFIG_NUM_CHANNELS */
+#if TESTCONFIG_CAPTURE_MODE
+  budget += linktest_get_capture_window();
+#endif /* TESTCONFIG_CAPTURE_MODE */
+  return budget;
+}
+
+static uint64_t linktest_get_slot_period(uint8_t lenIdx) {
+  // slot period of the current radio config [hs_timer ticks]
+#if TESTCONFIG_SLOT_CALIBRATION
+  // node specific, only the transmitter of the round follows the slot grid (receivers listen during the whole round)
+  return LINKTEST_US_TO_HS_TICKS(time_on_air[radio_cfg_idx][lenIdx]) + slot_latency;
+#else
+  return LINKTEST_US_TO_HS_TICKS(linktest_get_slot_budget(radio_cfg_idx, lenIdx));
+#endif /* TESTCONFIG_SLOT_CALIBRATION */
+}
+
+uint64_t linktest_get_slot_start(uint16_t slotIdx) {
+  // start of slot slotIdx relative to the start of the first slot of the round [hs_timer ticks]
+  uint64_t start = 0;
+  uint8_t  lenIdx;
+  for (lenIdx = 0; lenIdx < TESTCONFIG_NUM_PAYLOAD_LENS; lenIdx++) {
+    // number of preceding slots with payload length lenIdx
+    uint16_t numSlots = slotIdx / TESTCONFIG_NUM_PAYLOAD_LENS + (lenIdx < LINKTEST_SLOT_LEN_IDX(slotIdx));
+    start += numSlots * linktest_get_slot_period(lenIdx);
+  }
+  return start;
+}
+
+uint32_t linktest_get_slots_time(uint8_t cfgIdx) {
+  // duration of all slots of a round based on the slot budget [ms] (identical on all nodes)
+  uint64_t budget = 0;
+  uint16_t slotIdx;
+  for (slotIdx = 0; slotIdx < LINKTEST_NUM_SLOTS; slotIdx++) {
+    budget += linktest_get_slot_budget(cfgIdx, LINKTEST_SLOT_LEN_IDX(slotIdx));
+  }
+#if TESTCONFIG_SLOT_HS_TIMER
+  return (uint32_t)((budget + 999) / 1000);
+#else
+  // slot starts are rounded up to the next RTOS tick
+  return (uint32_t)((budget + 999) / 1000) + 1;
+#endif /* TESTCONFIG_SLOT_HS_TIMER */
+}
+
+#if TESTCONFIG_SLOT_CALIBRATION || (TESTCONFIG_NUM_PAYLOAD_LENS > 1)
+TickType_t linktest_get_slot_offset(uint16_t slotIdx) {
+  // start of slot slotIdx relative to the start of the first slot (rounded up to the next RTOS tick)
+  return (TickType_t)((linktest_get_slot_start(slotIdx) * configTICK_RATE_HZ + HS_TIMER_FREQUENCY - 1) / HS_TIMER_FREQUENCY);
+}
+#endif /* TESTCONFIG_SLOT_CALIBRATION || TESTCONFIG_NUM_PAYLOAD_LENS */
+
+#if TESTCONFIG_SLOT_HS_TIMER
+static TaskHandle_t slot_task = NULL;
+
+static void linktest_slot_timer_callback(void) {
+  /* hs_timer compare interrupt: wake up the linktest task */
+  BaseType_t higher_prio_task_woken = pdFALSE;
+  if (slot_task) {
+    vTaskNotifyGiveFromISR(slot_task, &higher_prio_task_woken);
+  }
+  portYIELD_FROM_ISR(higher_prio_task_woken);
+}
+
+void linktest_wait_until(uint64_t timestamp) {
+  uint64_t now = hs_timer_get_current_timestamp();
+  if (timestamp <= now + LINKTEST_US_TO_HS_TICKS(LINKTEST_HS_TIMER_MIN_DELAY)) {
+    return;
+  }
+  slot_task = xTaskGetCurrentTaskHandle();
+  ulTaskNotifyTake(pdTRUE, 0);    // clear pending notifications
+  hs_timer_schedule(timestamp, &linktest_slot_timer_callback);
+  // the timeout is only a fallback in case the compare interrupt is missed
+  ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS((timestamp - now) * 1000 / HS_TIMER_FREQUENCY + 2));
+}
+#endif /* TESTCONFIG_SLOT_HS_TIMER */
+
+#if TESTCONFIG_PING_PONG
+typedef struct {
+  uint64_t ts;                          // hs_timer timestamp of the RxDone event of the reply
+  int16_t  rssi;
+  int8_t   snr;
+  int16_t  ping_rssi;                   // RSSI / SNR of the packet at the replying node
+  int8_t   ping_snr;
+  bool     valid;
+} linktest_pong_rx_t;
+
+static TaskHandle_t                pong_task      = NULL;
+static volatile bool               ping_active    = false;   // transmitter: waiting for the TxDone of the packet
+static volatile bool               pong_wait      = false;   // receiver: waiting for the packet of the current slot
+static volatile bool               pong_tx_active = false;   // receiver: own reply is being transmitted
+static volatile uint64_t           ping_ts        = 0;       // TxDone (transmitter) or RxDone (receiver) of the packet of the current slot [hs_timer ticks]
+static volatile int16_t            ping_rssi      = 0;
+static volatile int8_t             ping_snr       = 0;
+static uint8_t                     pong_tx_node_idx = 0;     // index of the transmitter of the current round in TESTCONFIG_NODE_LIST
+static uint8_t                     pong_subslot     = 0;     // own reply sub-slot in the current round
+static volatile linktest_pong_rx_t pong_rx[TESTCONFIG_NUM_NODES - 1];   // replies received by the transmitter (indexed by sub-slot)
+static linktest_message_t          pong_msg;
+
+static uint8_t linktest_pong_get_subslot(uint8_t nodeIdx) {
+  // sub-slots are ordered by the index in TESTCONFIG_NODE_LIST, the transmitter is skipped
+  return (nodeIdx > pong_tx_node_idx) ? (nodeIdx - 1) : nodeIdx;
+}
+
+static void linktest_pong_round_pre(uint16_t roundIdx) {
+  uint8_t i;
+  pong_tx_node_idx = LINKTEST_ROUND_NODE_IDX(roundIdx);
+  for (i = 0; i < TESTCONFIG_NUM_NODES; i++) {
+    if (TESTCONFIG_NODE_LIST[i] == NODE_ID) {
+      pong_subslot = linktest_pong_get_subslot(i);
+    }
+  }
+  pong_task = xTaskGetCurrentTaskHandle();
+}
+
+static void linktest_pong_notify_from_isr(void) {
+  BaseType_t higher_prio_task_woken = pdFALSE;
+  if (pong_task) {
+    vTaskNotifyGiveFromISR(pong_task, &higher_prio_task_woken);
+  }
+  portYIELD_FROM_ISR(higher_prio_task_woken);
+}
+
+static void linktest_ping_start(void) {
+  // transmitter: called right before the packet is sent
+  uint8_t i;
+  for (i = 0; i < TESTCONFIG_NUM_NODES - 1; i++) {
+    pong_rx[i].valid = false;
   }
+  ulTaskNotifyTake(pdTRUE, 0);    // clear pending notifications
+  ping_active = true;
+}
+
+static void linktest_ping_collect(uint16_t slotIdx, uint8_t lenIdx) {
+  // transmitter: listen during the reply sub-slots of all other nodes and log the round-trip time of each reply
+  const uint32_t subslot = linktest_get_pong_subslot(radio_cfg_idx, lenIdx);
+  uint8_t i;
+
+  if (!ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(time_on_air[radio_cfg_idx][lenIdx] / 1000 + 2)) || ping_active) {
+    ping_active = false;
+    LOG_WARNING("no TxDone, replies are not collected");
+    return;
+  }
+  Radio.RxBoostedMask(LINKTEST_IRQ_MASK, 0, true, false);
+  linktest_wait_until(ping_ts + LINKTEST_US_TO_HS_TICKS(linktest_get_pong_window(radio_cfg_idx, lenIdx)));
+  Radio.Standby();
+
+  for (i = 0; i < TESTCONFIG_NUM_NODES - 1; i++) {
+    if (!pong_rx[i].valid) {
+      continue;
+    }
+    // turnaround: round-trip time minus the scheduled reply delay and the time-on-air of the reply
+    uint32_t rtt     = (uint32_t)((pong_rx[i].ts - ping_ts) * 1000000 / HS_TIMER_FREQUENCY);
+    uint32_t nominal = TESTCONFIG_PONG_DELAY + i * subslot + pong_time_on_air[radio_cfg_idx][lenIdx];
+    LINKTEST_LOG("{\"type\":\"Pong\","
+                 "\"slot\":%u,"
+                 "\"node\":%u,"
+                 "\"rtt\":%lu,"
+                 "\"turnaround\":%ld,"
+                 "\"rssi\":%d,"
+                 "\"snr\":%d,"
+                 "\"ping_rssi\":%d,"
+                 "\"ping_snr\":%d}",
+      slotIdx,
+      TESTCONFIG_NODE_LIST[(i >= pong_tx_node_idx) ? (i + 1) : i],
+      (unsigned long)rtt,
+      (long)rtt - (long)nominal,
+      pong_rx[i].rssi,
+      pong_rx[i].snr,
+      pong_rx[i].ping_rssi,
+      pong_rx[i].ping_snr
+    );
+  }
+}
+
+static void linktest_pong_reply(uint16_t slotIdx, uint8_t lenIdx) {
+  // receiver: wait for the packet of the slot and reply in the own sub-slot (relative to the end of the packet)
+  linktest_pong_t* pong = (linktest_pong_t*) &pong_msg;
+  bool received;
+
+  ulTaskNotifyTake(pdTRUE, 0);    // clear pending notifications
+  pong_wait = true;
+  ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS((time_on_air[radio_cfg_idx][lenIdx] + TESTCONFIG_PONG_DELAY) / 1000 + 1));
+  taskENTER_CRITICAL();
+  received  = !pong_wait;
+  pong_wait = false;
+  taskEXIT_CRITICAL();
+  if (!received) {
+    return;
+  }
+
+  pong->counter = slotIdx | LINKTEST_PONG_FLAG;
+  pong->node_id = NODE_ID;
+  pong->rssi    = ping_rssi;
+  pong->snr     = ping_snr;
+  linktest_wait_until(ping_ts + LINKTEST_US_TO_HS_TICKS(TESTCONFIG_PONG_DELAY + pong_subslot * linktest_get_pong_subslot(radio_cfg_idx, lenIdx)));
+  pong_tx_active = true;
+  Radio.SendPayload((uint8_t*) &pong_msg, linktest_get_pong_len(lenIdx));
+  ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(pong_time_on_air[radio_cfg_idx][lenIdx] / 1000 + 2));
+  pong_tx_active = false;
+
+  // continue listening for the next slot
+  Radio.RxBoostedMask(LINKTEST_IRQ_MASK, 0, true, false);
 }
 
-void linktest_round_pre(uint8_t roundIdx) {
+static bool linktest_pong_on_txdone(uint64_t ts) {
+  /* ISR context, returns true if the event must not be logged (own reply) */
+  if (pong_tx_active) {
+    linktest_pong_notify_from_isr();
+    return true;
+  }
+  if (ping_active) {
+    ping_ts     = ts;
+    ping_active = false;
+    linktest_pong_notify_from_isr();
+  }
+  return false;
+}
+
+static bool linktest_pong_on_rxdone(uint8_t* payload, uint16_t size, int16_t rssi, int8_t snr, bool crc_error, uint64_t ts) {
+  /* ISR context, returns true if the event must not be logged (replies are only reported by the transmitter, see linktest_ping_collect()) */
+  const linktest_pong_t* pong = (const linktest_pong_t*) payload;
+  uint8_t i;
+
+  if (!pong_wait) {
+    // outside of the packet reception (e.g. replies of other nodes or corrupted replies)
+    if (!crc_error && size >= sizeof(linktest_pong_t) && pong->counter == (slot_idx | LINKTEST_PONG_FLAG) && TESTCONFIG_NODE_LIST[pong_tx_node_idx] == NODE_ID) {
+      for (i = 0; i < TESTCONFIG_NUM_NODES; i++) {
+        if (TESTCONFIG_NODE_LIST[i] == pong->node_id && i != pong_tx_node_idx) {
+          volatile linktest_pong_rx_t* rx = &pong_rx[linktest_pong_get_subslot(i)];
+          rx->ts        = ts;
+          rx->rssi      = rssi;
+          rx->snr       = snr;
+          rx->ping_rssi = pong->rssi;
+          rx->ping_snr  = pong->snr;
+          rx->valid     = true;
+          break;
+        }
+      }
+    }
+    return true;
+  }
+  if (!crc_error && size >= sizeof(uint16_t) && ((linktest_message_t*) payload)->counter == slot_idx) {
+    ping_ts   = ts;
+    ping_rssi = rssi;
+    ping_snr  = snr;
+    pong_wait = false;
+    linktest_pong_notify_from_isr();
+  }
+  return false;
+}
+#endif /* TESTCONFIG_PING_PONG */
+
+void linktest_init(uint32_t *slotTime) {
+  linktest_radio_init();
+
+  /* Calculate the time-on-air of all radio configs and payload lengths */
+  uint8_t cfgIdx;
+  uint8_t lenIdx;
+  for (cfgIdx = 0; cfgIdx < TESTCONFIG_NUM_CONFIGS; cfgIdx++) {
+    const linktest_radio_config_t* cfg = &radio_configs[cfgIdx];
+    for (lenIdx = 0; lenIdx < TESTCONFIG_NUM_PAYLOAD_LENS; lenIdx++) {
+      time_on_air[cfgIdx][lenIdx] = Radio.TimeOnAir(
+        cfg->modulation,
+        cfg->bandwidth,
+        cfg->datarate,
+        cfg->coderate,
+        cfg->preamble_len,
+        0,  // fixLen
+        linktest_get_payload_len(lenIdx),
+        cfg->crc_on
+      );
+#if TESTCONFIG_PING_PONG
+      pong_time_on_air[cfgIdx][lenIdx] = Radio.TimeOnAir(
+        cfg->modulation,
+        cfg->bandwidth,
+        cfg->datarate,
+        cfg->coderate,
+        cfg->preamble_len,
+        0,  // fixLen
+        linktest_get_pong_len(lenIdx),
+        cfg->crc_on
+      );
+#endif /* TESTCONFIG_PING_PONG */
+    }
+  }
+#if TESTCONFIG_NUM_PAYLOAD_LENS > 1
+  // repeat the key to fill the longest payload
+  uint16_t key_length = strlen(TESTCONFIG_KEY);
+  uint16_t i;
+  for (i = key_length; key_length && i < sizeof(tx_msg.key); i++) {
+    tx_msg.key[i] = tx_msg.key[i - key_length];
+  }
+#endif /* TESTCONFIG_NUM_PAYLOAD_LENS */
+
+  // /* Calculate SlotTime (of the first radio config and payload length) */
+  uint16_t payload_len = linktest_get_payload_len(0);
+  uint32_t timeOnAir = linktest_get_time_on_air(0, 0);
+  *slotTime = timeOnAir / 1000; // TimeOnAir returns us, we need ms
+
+  // workaround for no successful rx in FSK mode if no Tx happened before
+  // simple Radio.Send alone with 0 size payload does not work
+  for (cfgIdx = 0; cfgIdx < TESTCONFIG_NUM_CONFIGS; cfgIdx++) {
+    if (radio_configs[cfgIdx].modulation == MODEM_FSK) {
+      radio_cfg = &radio_configs[cfgIdx];
+      linktest_set_tx_config_fsk();
+      Radio.Standby();
+      Radio.SendPayload((uint8_t*) &tx_msg, payload_len);
+      // Radio.Send((uint8_t*) &msg, 0);
+      break;
+    }
+  }
+  radio_cfg = &radio_configs[0];
+
+#if TESTCONFIG_SLOT_CALIBRATION
+  linktest_calibrate_slot(timeOnAir, &tx_msg, payload_len);
+#endif /* TESTCONFIG_SLOT_CALIBRATION */
+
+#if TESTCONFIG_LOG_DEFERRED
+  // TxDone events of the FSK workaround and the calibration must not end up in the first round
+  Radio.Standby();
+  linktest_events_flush();
+  linktest_events_reset_stats();
+#endif /* TESTCONFIG_LOG_DEFERRED */
+}
+
+void linktest_round_pre(uint16_t roundIdx) {
+#if TESTCONFIG_LOG_STATS
+  linktest_stats_start_round(roundIdx);
+#endif /* TESTCONFIG_LOG_STATS */
+
+  // select the radio config of the round (cycles through RADIOCONFIG_LIST)
+  radio_cfg_idx = LINKTEST_ROUND_CONFIG_IDX(roundIdx);
+  radio_cfg     = &radio_configs[radio_cfg_idx];
+
   // set radio config (fixed for entire round)
-  if (RADIOCONFIG_MODULATION == MODEM_LORA) {
+  if (radio_cfg->modulation == MODEM_LORA) {
     linktest_set_tx_config_lora();
     linktest_set_rx_config_lora();
   }
@@ -105,34 +742,85 @@ void linktest_round_pre(uint8_t roundIdx) {
   }
   Radio.Standby();
 
-  if (TESTCONFIG_NODE_LIST[roundIdx] != NODE_ID) {
+#if TESTCONFIG_PING_PONG
+  linktest_pong_round_pre(roundIdx);
+#endif /* TESTCONFIG_PING_PONG */
+
+#if TESTCONFIG_NUM_CHANNELS > 1
+  // assign the channel of the first slot (transmitters use a fixed channel per round, receivers hop between the channels)
+  radio_channel = 0;
+  radio_rx_on   = false;
+  linktest_schedule_prepare_slot(roundIdx, 0);
+#else
+  if (TESTCONFIG_NODE_LIST[LINKTEST_ROUND_NODE_IDX(roundIdx)] != NODE_ID
+#if TESTCONFIG_CAPTURE_MODE
+      && TESTCONFIG_NODE_LIST[LINKTEST_CAPTURE_NODE_IDX(roundIdx)] != NODE_ID
+#endif /* TESTCONFIG_CAPTURE_MODE */
+     ) {
     /* Node is receiving in this round */
 
     // start rx mode (with deactivated preamble IRQs)
     Radio.RxBoostedMask(LINKTEST_IRQ_MASK, 0, true, false);
   }
+#endif /* TESTCONFIG_NUM_CHANNELS */
 }
 
-void linktest_round_post(uint8_t roundIdx) {
+void linktest_round_post(uint16_t roundIdx) {
   Radio.Standby(); // required for Rx, no harm for Tx
+
+#if TESTCONFIG_LOG_DEFERRED
+  // all events of the round need to be printed before the end of the round
+  linktest_events_flush();
+  linktest_events_print_stats(roundIdx);
+#endif /* TESTCONFIG_LOG_DEFERRED */
+
+#if TESTCONFIG_LOG_STATS
+  linktest_stats_end_round(roundIdx);
+#endif /* TESTCONFIG_LOG_STATS */
+}
+
+uint16_t linktest_get_slot_idx(void) {
+  return slot_idx;
 }
 
-void linktest_slot(uint8_t roundIdx, uint16_t slotIdx, uint32_t slotStartTs) {
-  if (TESTCONFIG_NODE_LIST[roundIdx] == NODE_ID) {
+void linktest_slot(uint16_t roundIdx, uint16_t slotIdx, uint32_t slotStartTs) {
+  slot_idx = slotIdx;
+#if TESTCONFIG_CAPTURE_MODE
+  if (linktest_capture_tx(roundIdx, slotIdx)) {
+#elif TESTCONFIG_NUM_CHANNELS > 1
+  uint8_t entry = linktest_schedule_prepare_slot(roundIdx, slotIdx);
+  if (entry != LINKTEST_SCHEDULE_IDLE && (entry & LINKTEST_SCHEDULE_TX)) {
+#else
+  if (TESTCONFIG_NODE_LIST[LINKTEST_ROUND_NODE_IDX(roundIdx)] == NODE_ID) {
+#endif /* TESTCONFIG_NUM_CHANNELS */
     /* Node is transmitting in this round */
 
+#if TESTCONFIG_NUM_CHANNELS > 1
+    vTaskDelay(pdMS_TO_TICKS(LINKTEST_CHANNEL_SWITCH_TIME));
+#endif /* TESTCONFIG_NUM_CHANNELS */
     // send
-    static linktest_message_t msg = {
-      .counter=0,
-      .key=TESTCONFIG_KEY,
-    };
-    msg.counter = slotIdx;
-    uint16_t key_length = strlen(msg.key);
-    key_length  = (key_length > 254) ? 254 : key_length;
-    Radio.SendPayload((uint8_t*) &msg, sizeof(msg.counter) + key_length);
+    tx_msg.counter = slotIdx;
+#if TESTCONFIG_CAPTURE_MODE && !TESTCONFIG_CAPTURE_SAME_PAYLOAD
+    if (TESTCONFIG_NODE_LIST[LINKTEST_CAPTURE_NODE_IDX(roundIdx)] == NODE_ID) {
+      tx_msg.counter |= LINKTEST_CAPTURE_FLAG;
+    }
+#endif /* TESTCONFIG_CAPTURE_MODE && !TESTCONFIG_CAPTURE_SAME_PAYLOAD */
+#if TESTCONFIG_BER_MODE
+    // payload is the PRBS of the slot (see linktest_ber.h)
+    linktest_ber_fill((uint8_t*) tx_msg.key, slotIdx, TESTCONFIG_BER_PAYLOAD_LEN);
+#endif /* TESTCONFIG_BER_MODE */
+#if TESTCONFIG_PING_PONG
+    linktest_ping_start();
+#endif /* TESTCONFIG_PING_PONG */
+    Radio.SendPayload((uint8_t*) &tx_msg, linktest_get_payload_len(LINKTEST_SLOT_LEN_IDX(slotIdx)));
+#if TESTCONFIG_PING_PONG
+    linktest_ping_collect(slotIdx, LINKTEST_SLOT_LEN_IDX(slotIdx));
+#endif /* TESTCONFIG_PING_PONG */
   } else {
     /* Node is receiving in this round */
-    // nothing to do
+#if TESTCONFIG_PING_PONG
+    linktest_pong_reply(slotIdx, LINKTEST_SLOT_LEN_IDX(slotIdx));
+#endif /* TESTCONFIG_PING_PONG */
   }
 }
 
@@ -144,52 +832,231 @@ void linktest_slot(uint8_t roundIdx, uint16_t slotIdx, uint32_t slotStartTs) {
 #if TESTCONFIG_FLOOD_MODE
 
 static uint32_t flood_time = 0;
+static uint32_t flood_gap  = FLOODCONFIG_FLOOD_GAP;   // reduced to FLOODCONFIG_ADAPTIVE_GAP after the calibration [ms]
+static uint8_t  num_hops   = FLOODCONFIG_NUM_HOPS;    // hop budget of flood_time
+static uint32_t slot_time  = 0;                       // slot time used by vTask_linktest (same on all nodes) [ms]
+static uint8_t  flood_delay = 0;                      // delay of the delayed node in the current slot [hops] (0: no delayed node)
+#if FLOODCONFIG_NUM_DELAYS > 1
+static const uint8_t flood_delays[] = {
+  FLOODCONFIG_DELAY_LIST
+};
+_Static_assert(sizeof(flood_delays) / sizeof(flood_delays[0]) == FLOODCONFIG_NUM_DELAYS, "FLOODCONFIG_DELAY_LIST must contain FLOODCONFIG_NUM_DELAYS entries");
+#endif /* FLOODCONFIG_NUM_DELAYS */
 static linktest_message_t msg_tx = {
   .counter=0,
   .key=TESTCONFIG_KEY,
 };
 static uint16_t payload_len_tx;
 
+static uint8_t linktest_flood_get_delay(uint16_t slotIdx) {
+#if FLOODCONFIG_NUM_DELAYS > 1
+  return flood_delays[LINKTEST_SLOT_DELAY_IDX(slotIdx)];
+#else
+  return FLOODCONFIG_DELAY_TX;
+#endif /* FLOODCONFIG_NUM_DELAYS */
+}
+
+#if FLOODCONFIG_TRACE
+static volatile uint8_t        trace_cnt = 0;                            // number of packets received in the current flood
+static uint64_t                trace_ts[LINKTEST_LOG_FLOOD_MAX_SLOTS];   // hs_timer timestamp of the reception
+static linktest_log_flood_rx_t trace_rx[LINKTEST_LOG_FLOOD_MAX_SLOTS];
+
+/* packet filter of gloria, called in the radio interrupt for every packet received during a flood */
+static bool linktest_flood_trace_filter(uint8_t* payload, uint8_t size) {
+  if (trace_cnt < LINKTEST_LOG_FLOOD_MAX_SLOTS) {
+    PacketStatus_t status;
+    trace_ts[trace_cnt] = hs_timer_get_current_timestamp();
+    SX126xGetPacketStatus(&status);
+    if (status.packetType == PACKET_TYPE_LORA) {
+      trace_rx[trace_cnt].rssi = status.Params.LoRa.RssiPkt;
+      trace_rx[trace_cnt].snr  = status.Params.LoRa.SnrPkt;
+    }
+    else {
+      trace_rx[trace_cnt].rssi = status.Params.Gfsk.RssiAvg;
+      trace_rx[trace_cnt].snr  = 0;
+    }
+    trace_cnt++;
+  }
+  return true;    // do not drop any packets
+}
+
+/*
+ * Maps the received packets to the slots of the flood: relative to t_ref on the initiator (start of slot 0),
+ * relative to the first received packet (slot rx_idx) on all other nodes.
+ */
+static void linktest_flood_print_trace(bool is_initiator, uint16_t counter, uint8_t rx_cnt, uint8_t rx_idx, uint8_t rx_started) {
+  static linktest_log_flood_t rec;
+  uint64_t slot_len = (uint64_t)(gloria_get_flood_time(payload_len_tx, 2) - gloria_get_flood_time(payload_len_tx, 1)) * HS_TIMER_FREQUENCY / 1000000;
+  uint8_t  i;
+
+  memset(&rec, 0, sizeof(rec));
+  rec.t_ref        = (is_initiator || (rx_cnt && gloria_is_t_ref_updated())) ? gloria_get_t_ref() : 0;
+  rec.counter      = counter;
+  rec.is_initiator = is_initiator;
+  rec.rx_idx       = rx_idx;
+  rec.rx_started   = rx_started;
+  for (i = 0; (i < trace_cnt) && slot_len; i++) {
+    uint64_t slot;
+    if (is_initiator) {
+      if (!rec.t_ref || (trace_ts[i] < rec.t_ref)) {
+        continue;
+      }
+      slot = (trace_ts[i] - rec.t_ref) / slot_len;
+    }
+    else {
+      slot = rx_idx + (trace_ts[i] - trace_ts[0] + slot_len / 2) / slot_len;
+    }
+    if ((slot < LINKTEST_LOG_FLOOD_MAX_SLOTS) && !(rec.rx_bitmap & (1UL << slot))) {
+      rec.rx_bitmap |= (1UL << slot);
+      rec.rx[rec.num_rx++] = trace_rx[i];
+    }
+  }
+  linktest_log_flood(&rec);
+}
+#endif /* FLOODCONFIG_TRACE */
+
 void linktest_init(uint32_t *slotTime) {
   gloria_set_band(FLOODCONFIG_RF_BAND);
   gloria_set_tx_power(FLOODCONFIG_TX_POWER);
   gloria_set_modulation(FLOODCONFIG_MODULATION);
+#if FLOODCONFIG_TRACE
+  gloria_set_pkt_filter(linktest_flood_trace_filter);
+#endif /* FLOODCONFIG_TRACE */
 
   // calc flood and slot time
   uint16_t key_length = strlen(msg_tx.key);
   key_length = (key_length > 254) ? 254 : key_length;
   payload_len_tx = sizeof(msg_tx.counter) + key_length;
-  flood_time = gloria_get_flood_time(payload_len_tx, FLOODCONFIG_N_TX + FLOODCONFIG_NUM_HOPS - 1) / 1000; // gloria_get_flood_time returns us, we need ms
-  *slotTime = flood_time + 2*FLOODCONFIG_FLOOD_GAP;
+  flood_time = gloria_get_flood_time(payload_len_tx, FLOODCONFIG_N_TX + num_hops - 1) / 1000; // gloria_get_flood_time returns us, we need ms
+  slot_time  = flood_time + 2*flood_gap;
+  *slotTime  = slot_time;
 }
 
-void linktest_round_pre(uint8_t roundIdx) {
+#if FLOODCONFIG_ADAPTIVE
+static uint8_t linktest_flood_get_budget(uint8_t max_rx_idx) {
+  // hop distance is rx_idx + 1, a delayed node postpones the retransmissions by up to max_delay hops
+  uint8_t  max_delay = 0;
+  uint16_t i;
+  for (i = 0; i < FLOODCONFIG_NUM_DELAYS; i++) {
+    max_delay = (linktest_flood_get_delay(i) > max_delay) ? linktest_flood_get_delay(i) : max_delay;
+  }
+  uint32_t hops = (uint32_t)max_rx_idx + 1 + FLOODCONFIG_ADAPTIVE_MARGIN + max_delay;
+  return (hops > FLOODCONFIG_ADAPTIVE_MAX_HOPS) ? FLOODCONFIG_ADAPTIVE_MAX_HOPS : hops;
+}
+
+/*
+ * Calibration floods (one per node in the order of TESTCONFIG_NODE_IDS) followed by LINKTEST_FLOOD_REPEAT feedback floods
+ * of FLOODCONFIG_INITIATOR, all with the full budget (slotPeriod). Every calibration flood carries the max. rx_idx known
+ * to its initiator, the feedback floods carry the hop budget derived from it. After the last feedback flood, all nodes
+ * switch to FLOODCONFIG_ADAPTIVE_GAP and a slot time (slotTime) sized for FLOODCONFIG_ADAPTIVE_MAX_HOPS, i.e. the slot
+ * timing is the same on every node and matches run_linktest.py. Nodes which missed the feedback floods use
+ * FLOODCONFIG_ADAPTIVE_MAX_HOPS as hop budget.
+ */
+void linktest_flood_calibrate(TickType_t* startTs, uint32_t slotPeriod, uint32_t* slotTime) {
+  uint8_t              rx_buf[GLORIA_INTERFACE_MAX_PAYLOAD_LEN];
+  linktest_flood_cal_t msg;
+  uint8_t              max_rx_idx = 0;
+  uint8_t              budget     = 0;    // hop budget announced by FLOODCONFIG_INITIATOR (0: not received)
+  uint16_t             i;
+
+  for (i = 0; i < TESTCONFIG_NUM_NODES + LINKTEST_FLOOD_REPEAT; i++) {
+    TickType_t slotStartTs    = *startTs;
+    bool       is_calibration = (i < TESTCONFIG_NUM_NODES);
+    bool       is_initiator   = is_calibration ? (TESTCONFIG_NODE_LIST[i] == NODE_ID) : (FLOODCONFIG_INITIATOR == NODE_ID);
+
+    if (is_initiator) {
+      if (is_calibration) {
+        msg.type  = LINKTEST_FLOOD_CAL;
+        msg.value = max_rx_idx;
+      }
+      else {
+        budget    = linktest_flood_get_budget(max_rx_idx);
+        msg.type  = LINKTEST_FLOOD_BUDGET;
+        msg.value = budget;
+      }
+      vTaskDelayUntil(&slotStartTs, pdMS_TO_TICKS(FLOODCONFIG_FLOOD_GAP));
+      gloria_start(true, (uint8_t*) &msg, sizeof(msg), FLOODCONFIG_N_TX, true);
+      vTaskDelayUntil(&slotStartTs, pdMS_TO_TICKS(flood_time));
+      gloria_stop();
+    }
+    else {
+      memset(rx_buf, 0, GLORIA_INTERFACE_MAX_PAYLOAD_LEN);
+      gloria_start(false, rx_buf, GLORIA_INTERFACE_MAX_PAYLOAD_LEN, FLOODCONFIG_N_TX, true);
+      vTaskDelayUntil(&slotStartTs, pdMS_TO_TICKS(2*FLOODCONFIG_FLOOD_GAP + flood_time));
+      gloria_stop();
+      if ((gloria_get_rx_cnt() > 0) && (gloria_get_payload_len() == sizeof(msg))) {
+        memcpy(&msg, rx_buf, sizeof(msg));
+        if (msg.type == LINKTEST_FLOOD_CAL) {
+          uint8_t rx_idx = gloria_get_rx_index();
+          max_rx_idx = (rx_idx > max_rx_idx) ? rx_idx : max_rx_idx;
+          max_rx_idx = (msg.value > max_rx_idx) ? msg.value : max_rx_idx;
+        }
+        else if (msg.type == LINKTEST_FLOOD_BUDGET) {
+          budget = msg.value;
+        }
+      }
+    }
+    vTaskDelayUntil(startTs, pdMS_TO_TICKS(slotPeriod));
+  }
+
+  if (budget) {
+    num_hops = budget;
+  }
+  else {
+    num_hops = FLOODCONFIG_ADAPTIVE_MAX_HOPS;
+    LOG_WARNING("no feedback flood received, using the max. hop budget");
+  }
+  flood_gap  = FLOODCONFIG_ADAPTIVE_GAP;
+  flood_time = gloria_get_flood_time(payload_len_tx, FLOODCONFIG_N_TX + num_hops - 1) / 1000;
+  /* independent of the received budget (all nodes must keep the same slot period) */
+  slot_time  = gloria_get_flood_time(payload_len_tx, FLOODCONFIG_N_TX + FLOODCONFIG_ADAPTIVE_MAX_HOPS - 1) / 1000 + 2*flood_gap;
+  *slotTime  = slot_time;
+
+  LOG_INFO("{\"type\":\"FloodCalibration\","
+           "\"maxRxIdx\":%u,"
+           "\"numHops\":%u,"
+           "\"floodGap\":%lu,"
+           "\"slotTime\":%lu}",
+    max_rx_idx,
+    num_hops,
+    flood_gap,
+    *slotTime
+  );
+}
+#endif /* FLOODCONFIG_ADAPTIVE */
+
+void linktest_round_pre(uint16_t roundIdx) {
   // nothing to do here
 }
 
-void linktest_round_post(uint8_t roundIdx) {
+void linktest_round_post(uint16_t roundIdx) {
   // nothing to do here
 }
 
-void linktest_slot(uint8_t roundIdx, uint16_t slotIdx, uint32_t slotStartTs) {
+void linktest_slot(uint16_t roundIdx, uint16_t slotIdx, uint32_t slotStartTs) {
   bool is_initiator = false;
 #if FLOODCONFIG_DELAY_TX==0
   // no delayed retransmissions (every node is initiator in the corresponding round)
-  is_initiator = (TESTCONFIG_NODE_LIST[roundIdx] == NODE_ID);
+  is_initiator = (TESTCONFIG_NODE_LIST[LINKTEST_ROUND_NODE_IDX(roundIdx)] == NODE_ID);
 #else
   // delay retransmissions on a single node (the node which corresponds to the current round, except initiator)
-  if (TESTCONFIG_NODE_LIST[roundIdx] == NODE_ID && NODE_ID!=FLOODCONFIG_INITIATOR) {
-    gloria_set_tx_delay(FLOODCONFIG_DELAY_TX);
+  // the delay value is tagged in FloodDone on all nodes
+  flood_delay = linktest_flood_get_delay(slotIdx);
+  if (TESTCONFIG_NODE_LIST[LINKTEST_ROUND_NODE_IDX(roundIdx)] == NODE_ID && NODE_ID!=FLOODCONFIG_INITIATOR) {
+    gloria_set_tx_delay(flood_delay);
   }
   // fixed initiator
   is_initiator = (FLOODCONFIG_INITIATOR == NODE_ID);
 #endif /* FLOODCONFIG_DELAY_TX==0 */
+#if FLOODCONFIG_TRACE
+  trace_cnt = 0;
+#endif /* FLOODCONFIG_TRACE */
 
   if (is_initiator) {
     /* Node is sending in this round */
 
-    // wait FLOODCONFIG_FLOOD_GAP
-    vTaskDelayUntil(&slotStartTs, pdMS_TO_TICKS(FLOODCONFIG_FLOOD_GAP));
+    // wait flood_gap
+    vTaskDelayUntil(&slotStartTs, pdMS_TO_TICKS(flood_gap));
 
     msg_tx.counter = slotIdx;
     gloria_start(
@@ -218,7 +1085,7 @@ void linktest_slot(uint8_t roundIdx, uint16_t slotIdx, uint32_t slotStartTs) {
       true                               // sync_slot
     );
 
-    vTaskDelayUntil(&slotStartTs, pdMS_TO_TICKS(2*FLOODCONFIG_FLOOD_GAP + flood_time));
+    vTaskDelayUntil(&slotStartTs, pdMS_TO_TICKS(2*flood_gap + flood_time));
 
     gloria_stop();
     linktest_print_flood_stats(false, (linktest_message_t*) msg_rx);
@@ -234,7 +1101,8 @@ void linktest_print_flood_stats(bool is_initiator, linktest_message_t* msg)
     int16_t  rssi          = -99;
     uint8_t  payload_len   = 0;
     uint8_t  t_ref_updated = 0;
-    // uint64_t t_ref         = 0;
+    uint64_t t_ref         = 0;
+    char     t_ref_str[LINKTEST_U64_STR_LEN];
 
     if (rx_cnt > 0) {
       rx_idx         = gloria_get_rx_index();
@@ -242,7 +1110,7 @@ void linktest_print_flood_stats(bool is_initiator, linktest_message_t* msg)
       rssi           = gloria_get_rssi();
       payload_len    = gloria_get_payload_len();
       t_ref_updated  = gloria_is_t_ref_updated();
-      // t_ref          = gloria_get_t_ref();
+      t_ref          = gloria_get_t_ref();
     }
 
     if (payload_len > sizeof(msg->counter)) {
@@ -260,9 +1128,12 @@ void linktest_print_flood_stats(bool is_initiator, linktest_message_t* msg)
              "\"snr\":%d,"
              "\"payload_len\":%d,"
              "\"t_ref_updated\":%d,"
-             // "\"t_ref\":%llu," // requires 64bit printf support (needs to be enabled in IDE Project Properties -> C/C++ Build -> Settings)
+             "\"t_ref\":%s,"
              "\"msg_counter\":%u,"
-             "\"msg_key\":\"%s\""
+             "\"msg_key\":\"%s\","
+             "\"num_hops\":%u,"
+             "\"slot_time\":%lu,"
+             "\"delay_tx\":%u"
              "}",
       is_initiator,
       rx_cnt,
@@ -272,10 +1143,16 @@ void linktest_print_flood_stats(bool is_initiator, linktest_message_t* msg)
       snr,
       payload_len,
       t_ref_updated,
-      // t_ref,
+      linktest_u64_to_str(t_ref, t_ref_str),
       msg->counter,
-      payload_len > sizeof(msg->counter) ? msg->key : ""
+      payload_len > sizeof(msg->counter) ? msg->key : "",
+      num_hops,
+      slot_time,
+      flood_delay
     );
+#if FLOODCONFIG_TRACE
+    linktest_flood_print_trace(is_initiator, msg->counter, rx_cnt, rx_idx, rx_started);
+#endif /* FLOODCONFIG_TRACE */
 }
 
 #endif /* TESTCONFIG_FLOOD_MODE */
@@ -285,10 +1162,22 @@ void linktest_print_flood_stats(bool is_initiator, linktest_message_t* msg)
  ******************************************************************************/
 #if TESTCONFIG_P2P_MODE
 
+static volatile uint64_t irq_ts     = 0;   // hs_timer timestamp of the current radio interrupt (captured on the DIO1 edge)
+static volatile uint64_t rx_sync_ts = 0;   // hs_timer timestamp of the last sync word / header of the current packet (0: none)
+
 void linktest_radio_irq_capture_callback(void) {
+  irq_ts = hs_timer_get_capture_timestamp();
+#if TESTCONFIG_LOG_DEFERRED
+  uint64_t start_ts = hs_timer_get_current_timestamp();
+#endif /* TESTCONFIG_LOG_DEFERRED */
+
   // Execute Radio driver callback
   (*RadioOnDioIrqCallback)();
   Radio.IrqProcess();
+
+#if TESTCONFIG_LOG_DEFERRED
+  linktest_events_isr_time((uint32_t)(hs_timer_get_current_timestamp() - start_ts));
+#endif /* TESTCONFIG_LOG_DEFERRED */
 }
 
 void linktest_OnRadioCadDone(_Bool detected) {
@@ -300,35 +1189,103 @@ void linktest_Dummy(void) {
 }
 
 void linktest_OnRxSync(void) {
-  // LOG_INFO("RxSync");
+  /* sync word (FSK) or valid header (LoRa) detected, the timestamp is reported with the RxDone event */
+  rx_sync_ts = irq_ts;
 }
 
 void linktest_OnRadioTxDone(void) {
   /* TxDone callback from the radio */
-  LOG_INFO("{\"type\": \"TxDone\"}");
+#if TESTCONFIG_SLOT_CALIBRATION
+  if (calib_active) {
+    calib_txdone_ts = hs_timer_get_current_timestamp();
+    calib_txdone    = true;
+  }
+#endif /* TESTCONFIG_SLOT_CALIBRATION */
+
+#if TESTCONFIG_PING_PONG
+  if (linktest_pong_on_txdone(irq_ts)) {
+    return;
+  }
+#endif /* TESTCONFIG_PING_PONG */
+
+#if TESTCONFIG_LOG_DEFERRED
+  linktest_events_push_txdone(irq_ts, slot_idx);
+#else
+  linktest_process_txdone(irq_ts, slot_idx);
+#endif /* TESTCONFIG_LOG_DEFERRED */
 }
 
 void linktest_OnRadioRxDone(uint8_t* payload, uint16_t size, int16_t rssi, int8_t snr, bool crc_error) {
   /* RxDone callback from the radio */
+#if TESTCONFIG_PING_PONG
+  if (linktest_pong_on_rxdone(payload, size, rssi, snr, crc_error, irq_ts)) {
+    rx_sync_ts = 0;
+    return;
+  }
+#endif /* TESTCONFIG_PING_PONG */
+#if TESTCONFIG_LOG_DEFERRED
+  linktest_events_push_rxdone(payload, size, rssi, snr, crc_error, slot_idx, rx_sync_ts);
+#else
+  linktest_process_rxdone(payload, size, rssi, snr, crc_error, slot_idx, rx_sync_ts);
+#endif /* TESTCONFIG_LOG_DEFERRED */
+  rx_sync_ts = 0;
+}
+
+void linktest_process_txdone(uint64_t txDoneTs, uint16_t slotIdx) {
+  /* TxDone event (ISR context or logging task with TESTCONFIG_LOG_DEFERRED) */
+#if TESTCONFIG_LOG_STATS
+  linktest_stats_tx();
+#elif TESTCONFIG_LOG_BINARY
+  linktest_log_txdone(txDoneTs, slotIdx);
+#else
+  char ts_str[LINKTEST_U64_STR_LEN];
+  LINKTEST_LOG("{\"type\":\"TxDone\",\"slot\":%u,\"ts\":%s}", slotIdx, linktest_u64_to_str(txDoneTs, ts_str));
+#endif /* TESTCONFIG_LOG_BINARY */
+}
+
+void linktest_process_rxdone(uint8_t* payload, uint16_t size, int16_t rssi, int8_t snr, bool crc_error, uint16_t slotIdx, uint64_t syncTs) {
+  /* RxDone event (ISR context or logging task with TESTCONFIG_LOG_DEFERRED), syncTs: hs_timer timestamp of the sync word */
+#if TESTCONFIG_BER_MODE
+  /* compare with the expected PRBS, raw payload is never sanitized */
+  linktest_ber_rx(payload, size, rssi, snr, crc_error, slotIdx);
+#elif TESTCONFIG_LOG_STATS
+  /* only accumulate, summary is printed at the end of the round */
+  linktest_stats_rx(payload, size, rssi, snr, crc_error);
+#elif TESTCONFIG_LOG_BINARY
+  /* raw payload is logged, sanitizing is done by the decoder */
+  linktest_log_rxdone(payload, size, rssi, snr, crc_error, syncTs);
+#else
+  char ts_str[LINKTEST_U64_STR_LEN];
   linktest_message_t *msg = (linktest_message_t*) payload;
+#if TESTCONFIG_NUM_PAYLOAD_LENS > 1
+  /* only print the first repetition of the key (limits the line length) */
+  uint16_t key_len = (size > sizeof(msg->counter)) ? (size - sizeof(msg->counter)) : 0;
+  key_len = (key_len > LINKTEST_LOG_KEY_LEN) ? LINKTEST_LOG_KEY_LEN : key_len;
+  linktest_sanitize_string(msg->key, key_len);
+  msg->key[key_len] = 0;
+#else
   /* replace all invalid characters in the payload */
   linktest_sanitize_string(msg->key, size - sizeof(msg->counter));
   /* make sure the string is terminated by a zero at the end */
   payload[size] = 0;
-  LOG_INFO( "{\"type\":\"RxDone\","
-            "\"key\":\"%s\","
-            "\"size\":%d,"
-            "\"counter\":%d,"
-            "\"rssi\":%d,"
-            "\"snr\":%d,"
-            "\"crc_error\":%d}",
+#endif /* TESTCONFIG_NUM_PAYLOAD_LENS */
+  LINKTEST_LOG("{\"type\":\"RxDone\","
+               "\"key\":\"%s\","
+               "\"size\":%d,"
+               "\"counter\":%d,"
+               "\"rssi\":%d,"
+               "\"snr\":%d,"
+               "\"crc_error\":%d,"
+               "\"ts_sync\":%s}",
     msg->key,
     size,
     msg->counter,
     rssi,
     snr,
-    crc_error
+    crc_error,
+    linktest_u64_to_str(syncTs, ts_str)
   );
+#endif /* TESTCONFIG_LOG_BINARY */
 }
 
 #endif /* TESTCONFIG_P2P_MODE */
@@ -362,18 +1319,18 @@ void linktest_OnRadioRxDone(uint8_t* payload, uint16_t size, int16_t rssi, int8_
 
 void linktest_set_tx_config_lora(void) {
   Radio.Standby();
-  Radio.SetChannel(RADIOCONFIG_FREQUENCY); // center frequency [Hz]
+  Radio.SetChannel(radio_cfg->frequency); // center frequency [Hz]
 
   Radio.SetTxConfig(
     MODEM_LORA,                  // modem (options: MODEM_LORA, MODEM_FSK)
-    RADIOCONFIG_TX_POWER,        // power [dBm]
+    radio_cfg->tx_power,        // power [dBm]
     0,                           // frequency deviation (FSK only)
-    RADIOCONFIG_BANDWIDTH,       // bandwidth (0=125KHz) (LoRa only)
-    RADIOCONFIG_DATARATE,        // datarate (FSK: bits/s, LoRa: spreading-factor)
-    RADIOCONFIG_CODERATE,        // coderate (LoRa only)
-    RADIOCONFIG_PREAMBLE_LEN,    // preamble length (FSK: num bytes, LoRa: symbols (HW adds 4 symbols))
-    RADIOCONFIG_IMPLICIT_HEADER, // implicit, i.e. fixed length packets [0: variable, 1: fixed]
-    RADIOCONFIG_CRC_ON,          // CRC on
+    radio_cfg->bandwidth,       // bandwidth (0=125KHz) (LoRa only)
+    radio_cfg->datarate,        // datarate (FSK: bits/s, LoRa: spreading-factor)
+    radio_cfg->coderate,        // coderate (LoRa only)
+    radio_cfg->preamble_len,    // preamble length (FSK: num bytes, LoRa: symbols (HW adds 4 symbols))
+    radio_cfg->implicit_header, // implicit, i.e. fixed length packets [0: variable, 1: fixed]
+    radio_cfg->crc_on,          // CRC on
     false,                       // FreqHopOn (FHSS)
     0,                           // hop period (for frequency hopping (FHSS) only
     false,                       // iqInverted
@@ -383,19 +1340,19 @@ void linktest_set_tx_config_lora(void) {
 
 void linktest_set_rx_config_lora(void) {
   Radio.Standby();
-  Radio.SetChannel(RADIOCONFIG_FREQUENCY); // center frequency [Hz]
+  Radio.SetChannel(radio_cfg->frequency); // center frequency [Hz]
 
   Radio.SetRxConfig(
     MODEM_LORA,                  // modem
-    RADIOCONFIG_BANDWIDTH,       // bandwidth
-    RADIOCONFIG_DATARATE,        // datarate
-    RADIOCONFIG_CODERATE,        // coderate
+    radio_cfg->bandwidth,       // bandwidth
+    radio_cfg->datarate,        // datarate
+    radio_cfg->coderate,        // coderate
     0,                           // bandwidthAfc (not used with SX126x!)
-    RADIOCONFIG_PREAMBLE_LEN,    // preambleLen
+    radio_cfg->preamble_len,    // preambleLen
     0,                           // symbTimeout
-    RADIOCONFIG_IMPLICIT_HEADER, // fixLen
+    radio_cfg->implicit_header, // fixLen
     0,                           // payloadLen (only if implicit header is used)
-    RADIOCONFIG_CRC_ON,          // crcOn
+    radio_cfg->crc_on,          // crcOn
     false,                       // FreqHopOn
     0,                           // HopPeriod
     false                        // iqInverted
@@ -405,21 +1362,21 @@ void linktest_set_rx_config_lora(void) {
 void linktest_set_tx_config_fsk(void) {
   // determine fdev from bandwidth and datarate
   // NOTE: according to the datasheet afc_bandwidth (automated frequency control bandwidth) variable represents the frequency error (2x crystal frequency error)
-  uint32_t fdev = (RADIOCONFIG_BANDWIDTH - RADIOCONFIG_DATARATE) / 2;
+  uint32_t fdev = (radio_cfg->bandwidth - radio_cfg->datarate) / 2;
 
   Radio.Standby();
-  Radio.SetChannel(RADIOCONFIG_FREQUENCY);  // center frequency [Hz]
+  Radio.SetChannel(radio_cfg->frequency);  // center frequency [Hz]
 
   Radio.SetTxConfig(
     MODEM_FSK,                 // modem (options: MODEM_LORA, MODEM_FSK)
-    RADIOCONFIG_TX_POWER,      // power [dBm]
+    radio_cfg->tx_power,      // power [dBm]
     fdev,                      // frequency deviation (FSK only)
-    RADIOCONFIG_BANDWIDTH,     // bandwidth (0=125KHz) (LoRa only)
-    RADIOCONFIG_DATARATE,      // datarate (FSK: bits/s, LoRa: spreading-factor)
+    radio_cfg->bandwidth,     // bandwidth (0=125KHz) (LoRa only)
+    radio_cfg->datarate,      // datarate (FSK: bits/s, LoRa: spreading-factor)
     0,                         // coderate (LoRa only)
-    RADIOCONFIG_PREAMBLE_LEN,  // preamble length (FSK: num bytes, LoRa: symbols (HW adds 4 symbols))
+    radio_cfg->preamble_len,  // preamble length (FSK: num bytes, LoRa: symbols (HW adds 4 symbols))
     false,                     // implicit, i.e. fixed length packets [0: variable, 1: fixed] (LoRa only)
-    RADIOCONFIG_CRC_ON,        // CRC on
+    radio_cfg->crc_on,        // CRC on
     false,                     // FreqHopOn (FHSS)
     0,                         // hop period (for frequency hopping (FHSS) only
     false,                     // iqInverted
@@ -428,22 +1385,22 @@ void linktest_set_tx_config_fsk(void) {
 }
 
 void linktest_set_rx_config_fsk(void) {
-  int32_t bandwidth_rx = radio_get_rx_bandwidth(RADIOCONFIG_FREQUENCY, RADIOCONFIG_BANDWIDTH);
+  int32_t bandwidth_rx = radio_get_rx_bandwidth(radio_cfg->frequency, radio_cfg->bandwidth);
 
   Radio.Standby();
-  Radio.SetChannel(RADIOCONFIG_FREQUENCY);  // center frequency [Hz]
+  Radio.SetChannel(radio_cfg->frequency);  // center frequency [Hz]
 
   Radio.SetRxConfig(
     MODEM_FSK,                // modem
     bandwidth_rx,             // bandwidth
-    RADIOCONFIG_DATARATE,     // datarate
+    radio_cfg->datarate,     // datarate
     0,                        // coderate
     0,                        // bandwidthAfc (not used with SX126x!)
-    RADIOCONFIG_PREAMBLE_LEN, // preambleLen
+    radio_cfg->preamble_len, // preambleLen
     0,                        // symbTimeout
     false,                    // fixLen
     0,                        // payloadLen (only if implicit header is used)
-    RADIOCONFIG_CRC_ON,       // crcOn
+    radio_cfg->crc_on,       // crcOn
     false,                    // FreqHopOn
     0,                        // HopPeriod
     false                     // iqInverted
@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) 2019 - 2021, ETH Zurich, Computer Engineering Group (TEC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * @brief  RAM log arena with optional spill to flash and post-test dump (see linktest_arena.h)
+ */
+
+#include "main.h"
+#include <stdarg.h>
+
+#if TESTCONFIG_LOG_ARENA
+
+#define BLOCK_HDR_LEN                 (2 * sizeof(uint16_t))    // len and num_entries of linktest_arena_block_t
+
+#if TESTCONFIG_LOG_ARENA_PAGES
+#ifndef LINKTEST_LOG_ARENA_IMAGE_END
+extern uint32_t _sidata, _sdata, _edata;                         // see STM32L433CCUX_FLASH.ld
+#define LINKTEST_LOG_ARENA_IMAGE_END  ((uintptr_t)&_sidata + ((uintptr_t)&_edata - (uintptr_t)&_sdata))
+#endif /* LINKTEST_LOG_ARENA_IMAGE_END */
+_Static_assert(sizeof(linktest_arena_block_t) == FLASH_PAGE_SIZE, "LINKTEST_LOG_ARENA_BLOCK_SIZE must be equal to FLASH_PAGE_SIZE");
+#endif /* TESTCONFIG_LOG_ARENA_PAGES */
+
+/* Private variables */
+static linktest_arena_block_t arena[LINKTEST_LOG_ARENA_NUM_BLOCKS];
+static uint32_t               blk_first    = 0;     // oldest block in RAM (free-running, block b is stored in arena[b % LINKTEST_LOG_ARENA_NUM_BLOCKS])
+static uint32_t               blk_cur      = 0;     // block to which entries are appended
+static uint32_t               num_entries  = 0;
+static uint32_t               num_dropped  = 0;     // number of entries which did not fit into the arena (or exceeded LINKTEST_LOG_ARENA_LINE_LEN)
+#if TESTCONFIG_LOG_ARENA_PAGES
+static uintptr_t              flash_addr   = 0;     // address of the first flash page
+static bool                   flash_ok     = false; // false: pages not erased or programming failed (no further blocks are copied)
+static uint32_t               flash_blocks = 0;     // number of blocks copied to flash
+#endif /* TESTCONFIG_LOG_ARENA_PAGES */
+
+
+/******************************************************************************
+ * Appending (task context)
+ ******************************************************************************/
+void linktest_arena_init(void) {
+#if TESTCONFIG_LOG_ARENA_PAGES
+  FLASH_EraseInitTypeDef erase;
+  uint32_t               page_error = 0;
+
+  /* erase the pages before the test (takes ~22ms per page, the CPU is stalled) */
+  flash_addr = FLASH_BASE + FLASH_SIZE - TESTCONFIG_LOG_ARENA_PAGES * FLASH_PAGE_SIZE;
+  if (flash_addr < LINKTEST_LOG_ARENA_IMAGE_END) {
+    LOG_WARNING("TESTCONFIG_LOG_ARENA_PAGES overlap with the firmware image, flash is not used");
+    return;
+  }
+  erase.TypeErase = FLASH_TYPEERASE_PAGES;
+  erase.Banks     = FLASH_BANK_1;
+  erase.Page      = (flash_addr - FLASH_BASE) / FLASH_PAGE_SIZE;
+  erase.NbPages   = TESTCONFIG_LOG_ARENA_PAGES;
+  HAL_FLASH_Unlock();
+  __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_ALL_ERRORS);
+  flash_ok = (HAL_FLASHEx_Erase(&erase, &page_error) == HAL_OK);
+  HAL_FLASH_Lock();
+  if (!flash_ok) {
+    LOG_WARNING("erasing the log arena pages failed, flash is not used");
+  }
+#endif /* TESTCONFIG_LOG_ARENA_PAGES */
+}
+
+void linktest_arena_append(uint8_t type, const void* data, uint16_t len) {
+  linktest_arena_entry_hdr_t hdr = {
+    .type = type,
+    .len  = len,
+  };
+  uint32_t size = sizeof(hdr) + len;
+
+  taskENTER_CRITICAL();
+  linktest_arena_block_t* blk = &arena[blk_cur % LINKTEST_LOG_ARENA_NUM_BLOCKS];
+  if ((blk->len + size) > sizeof(blk->data)) {
+    // entries never span two blocks, drop the entry if all blocks are in use
+    if ((size > sizeof(blk->data)) || ((blk_cur + 1 - blk_first) >= LINKTEST_LOG_ARENA_NUM_BLOCKS)) {
+      num_dropped++;
+      taskEXIT_CRITICAL();
+      return;
+    }
+    blk_cur++;
+    blk = &arena[blk_cur % LINKTEST_LOG_ARENA_NUM_BLOCKS];
+    blk->len         = 0;
+    blk->num_entries = 0;
+  }
+  memcpy(&blk->data[blk->len], &hdr, sizeof(hdr));
+  memcpy(&blk->data[blk->len + sizeof(hdr)], data, len);
+  blk->len += size;
+  blk->num_entries++;
+  num_entries++;
+  taskEXIT_CRITICAL();
+}
+
+void linktest_arena_printf(const char* fmt, ...) {
+  char    line[LINKTEST_LOG_ARENA_LINE_LEN];
+  va_list args;
+  int     len;
+
+  va_start(args, fmt);
+  len = vsnprintf(line, sizeof(line), fmt, args);
+  va_end(args);
+  if ((len < 0) || (len >= (int)sizeof(line))) {
+    // a truncated line is not valid json
+    taskENTER_CRITICAL();
+    num_dropped++;
+    taskEXIT_CRITICAL();
+    return;
+  }
+  linktest_arena_append(LINKTEST_ARENA_ENTRY_TEXT, line, (uint16_t)len);
+}
+
+/* copies all full blocks to flash, must be called between two rounds (flash programming stalls the CPU) */
+void linktest_arena_spill(void) {
+#if TESTCONFIG_LOG_ARENA_PAGES
+  if (!flash_ok) {
+    return;
+  }
+  HAL_FLASH_Unlock();
+  while ((blk_first != blk_cur) && (flash_blocks < TESTCONFIG_LOG_ARENA_PAGES)) {
+    const uint8_t* blk  = (const uint8_t*)&arena[blk_first % LINKTEST_LOG_ARENA_NUM_BLOCKS];
+    uintptr_t      addr = flash_addr + flash_blocks * FLASH_PAGE_SIZE;
+    uint32_t       len  = BLOCK_HDR_LEN + ((const linktest_arena_block_t*)blk)->len;
+    uint32_t       ofs;
+    uint64_t       dword;
+
+    // only the used part of the block is programmed (double words)
+    for (ofs = 0; ofs < len; ofs += sizeof(dword)) {
+      memcpy(&dword, &blk[ofs], sizeof(dword));
+      if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, addr + ofs, dword) != HAL_OK) {
+        flash_ok = false;
+        break;
+      }
+    }
+    if (!flash_ok) {
+      LOG_WARNING("programming the log arena pages failed, flash is not used");
+      break;
+    }
+    flash_blocks++;
+    taskENTER_CRITICAL();
+    blk_first++;
+    taskEXIT_CRITICAL();
+  }
+  HAL_FLASH_Lock();
+#endif /* TESTCONFIG_LOG_ARENA_PAGES */
+}
+
+
+/******************************************************************************
+ * Dump (after the last round)
+ ******************************************************************************/
+static void linktest_arena_dump_block(const linktest_arena_block_t* blk, uint32_t blockIdx) {
+  static char                line[LINKTEST_LOG_ARENA_LINE_LEN];
+  linktest_arena_entry_hdr_t hdr;
+  uint32_t                   len       = (blk->len > sizeof(blk->data)) ? sizeof(blk->data) : blk->len;
+  uint32_t                   ofs       = 0;
+  uint32_t                   num_bytes = 0;
+  uint16_t                   i;
+
+  for (i = 0; (i < blk->num_entries) && ((ofs + sizeof(hdr)) <= len); i++) {
+    memcpy(&hdr, &blk->data[ofs], sizeof(hdr));
+    const uint8_t* data = &blk->data[ofs + sizeof(hdr)];
+    if ((hdr.type == LINKTEST_ARENA_ENTRY_TEXT) && (hdr.len < sizeof(line))) {
+      memcpy(line, data, hdr.len);
+      line[hdr.len] = 0;
+    }
+    else if ((hdr.type == LINKTEST_ARENA_ENTRY_BINARY) && ((4U * ((hdr.len + 2U) / 3U) + 2U) <= sizeof(line))) {
+      line[0] = LINKTEST_LOG_MARKER;
+      linktest_log_base64(data, hdr.len, &line[1]);
+    }
+    else {
+      // invalid entry (e.g. corrupted flash page), detected by the CRC check of the eval script
+      line[0] = 0;
+    }
+    /* single %s argument, no number formatting required */
+    LOG_INFO("%s", line);
+    num_bytes += strlen(line) + 1;
+    ofs       += sizeof(hdr) + hdr.len;
+  }
+  LOG_INFO("{\"type\":\"LogBlock\","
+           "\"block\":%lu,"
+           "\"numEntries\":%u,"
+           "\"len\":%u,"
+           "\"crc\":%u}",
+    (unsigned long)blockIdx,
+    blk->num_entries,
+    blk->len,
+    linktest_log_crc16(blk->data, len, 0xffff)
+  );
+
+#if !LOG_PRINT_IMMEDIATELY
+  log_flush();
+#endif /* LOG_PRINT_IMMEDIATELY */
+  /* limit the output rate (FlockLab serial service) */
+  vTaskDelay(pdMS_TO_TICKS(num_bytes * 1000 / LINKTEST_LOG_ARENA_DUMP_RATE + 1));
+}
+
+void linktest_arena_dump(void) {
+  uint32_t num_flash = 0;
+  uint32_t num_ram   = blk_cur - blk_first + (arena[blk_cur % LINKTEST_LOG_ARENA_NUM_BLOCKS].len ? 1 : 0);
+  uint32_t blockIdx  = 0;
+  uint32_t b;
+
+#if TESTCONFIG_LOG_ARENA_PAGES
+  num_flash = flash_blocks;
+#endif /* TESTCONFIG_LOG_ARENA_PAGES */
+  LOG_INFO("{\"type\":\"LogArena\","
+           "\"numBlocks\":%lu,"
+           "\"numFlashBlocks\":%lu,"
+           "\"numEntries\":%lu,"
+           "\"numDropped\":%lu}",
+    (unsigned long)(num_flash + num_ram),
+    (unsigned long)num_flash,
+    (unsigned long)num_entries,
+    (unsigned long)num_dropped
+  );
+
+  /* blocks in flash are older than the blocks in RAM */
+#if TESTCONFIG_LOG_ARENA_PAGES
+  for (b = 0; b < flash_blocks; b++) {
+    linktest_arena_dump_block((const linktest_arena_block_t*)(flash_addr + b * FLASH_PAGE_SIZE), blockIdx++);
+  }
+#endif /* TESTCONFIG_LOG_ARENA_PAGES */
+  for (b = blk_first; b != (blk_first + num_ram); b++) {
+    linktest_arena_dump_block(&arena[b % LINKTEST_LOG_ARENA_NUM_BLOCKS], blockIdx++);
+  }
+}
+
+#endif /* TESTCONFIG_LOG_ARENA */
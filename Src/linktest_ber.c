@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2019 - 2021, ETH Zurich, Computer Engineering Group (TEC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * @brief  Bit error pattern analysis (P2P mode)
+ */
+
+#include "main.h"
+
+#if TESTCONFIG_BER_MODE
+
+
+/******************************************************************************
+ * PRBS
+ ******************************************************************************/
+
+/* fills data with the PRBS of the given counter (xorshift32, seeded with the counter) */
+void linktest_ber_fill(uint8_t* data, uint16_t counter, uint16_t len) {
+  uint32_t state = ((uint32_t)counter + 1) * 2654435761UL;
+  uint16_t i;
+  for (i = 0; i < len; i++) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    data[i] = (uint8_t)(state >> 24);
+  }
+}
+
+
+/******************************************************************************
+ * Analysis
+ ******************************************************************************/
+
+void linktest_ber_rx(const uint8_t* payload, uint16_t size, int16_t rssi, int8_t snr, bool crc_error, uint16_t slotIdx) {
+  uint8_t  expected[LINKTEST_BER_MSG_LEN];
+  uint16_t bursts[LINKTEST_BER_MAX_BURSTS][2];    // start bit, length
+  char     bursts_str[LINKTEST_BER_MAX_BURSTS * 12 + 1];
+#if TESTCONFIG_BER_HEX_DUMP
+  char     xor_str[2 * LINKTEST_BER_MSG_LEN + 1];
+#endif /* TESTCONFIG_BER_HEX_DUMP */
+  int32_t  bit_errors = -1;                       // -1: size mismatch, no comparison possible
+  uint16_t num_bursts = 0;
+  uint16_t max_burst  = 0;
+  uint16_t burst_len  = 0;
+  uint16_t counter    = (size >= sizeof(uint16_t)) ? (payload[0] | ((uint16_t)payload[1] << 8)) : 0;
+  uint32_t len        = 0;
+  uint16_t i;
+  uint8_t  j;
+
+  bursts_str[0] = 0;
+#if TESTCONFIG_BER_HEX_DUMP
+  xor_str[0] = 0;
+#endif /* TESTCONFIG_BER_HEX_DUMP */
+
+  if (size == LINKTEST_BER_MSG_LEN) {
+    // the counter can be corrupted as well, the expected counter is the slot in which the packet was received
+    // (or the previous slot if the RxDone event was delayed beyond the start of the next slot)
+    uint16_t expected_counter = ((uint16_t)(counter + 1) == slotIdx) ? counter : slotIdx;
+    expected[0] = (uint8_t)(expected_counter & 0xff);
+    expected[1] = (uint8_t)(expected_counter >> 8);
+    linktest_ber_fill(&expected[sizeof(uint16_t)], expected_counter, TESTCONFIG_BER_PAYLOAD_LEN);
+
+    bit_errors = 0;
+    for (i = 0; i < LINKTEST_BER_MSG_LEN; i++) {
+      uint8_t x = payload[i] ^ expected[i];
+#if TESTCONFIG_BER_HEX_DUMP
+      snprintf(&xor_str[2 * i], 3, "%02x", x);
+#endif /* TESTCONFIG_BER_HEX_DUMP */
+      for (j = 0; j < 8; j++) {
+        if (x & (0x80 >> j)) {
+          bit_errors++;
+          burst_len++;
+        }
+        else if (burst_len) {
+          // end of a burst
+          if (num_bursts < LINKTEST_BER_MAX_BURSTS) {
+            bursts[num_bursts][0] = i * 8 + j - burst_len;
+            bursts[num_bursts][1] = burst_len;
+          }
+          num_bursts++;
+          max_burst = (burst_len > max_burst) ? burst_len : max_burst;
+          burst_len = 0;
+        }
+      }
+    }
+    if (burst_len) {
+      // burst at the end of the payload
+      if (num_bursts < LINKTEST_BER_MAX_BURSTS) {
+        bursts[num_bursts][0] = LINKTEST_BER_MSG_LEN * 8 - burst_len;
+        bursts[num_bursts][1] = burst_len;
+      }
+      num_bursts++;
+      max_burst = (burst_len > max_burst) ? burst_len : max_burst;
+    }
+    for (i = 0; i < num_bursts && i < LINKTEST_BER_MAX_BURSTS; i++) {
+      len += snprintf(&bursts_str[len], sizeof(bursts_str) - len, (i == 0) ? "[%u,%u]" : ",[%u,%u]", bursts[i][0], bursts[i][1]);
+    }
+  }
+
+  LINKTEST_LOG("{\"type\":\"BitErrors\","
+               "\"counter\":%u,"
+               "\"size\":%u,"
+               "\"rssi\":%d,"
+               "\"snr\":%d,"
+               "\"crc_error\":%d,"
+               "\"bitErrors\":%ld,"
+               "\"numBursts\":%u,"
+               "\"maxBurst\":%u,"
+               "\"bursts\":[%s]"
+#if TESTCONFIG_BER_HEX_DUMP
+           ",\"xor\":\"%s\""
+#endif /* TESTCONFIG_BER_HEX_DUMP */
+           "}",
+    counter,
+    size,
+    rssi,
+    snr,
+    crc_error,
+    (long)bit_errors,
+    num_bursts,
+    max_burst,
+    bursts_str
+#if TESTCONFIG_BER_HEX_DUMP
+    , xor_str
+#endif /* TESTCONFIG_BER_HEX_DUMP */
+  );
+}
+
+#endif /* TESTCONFIG_BER_MODE */
@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2019 - 2021, ETH Zurich, Computer Engineering Group (TEC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * @brief  Lock-free ISR-to-task ring buffer for radio events (P2P mode)
+ */
+
+#include "main.h"
+
+#if TESTCONFIG_LOG_DEFERRED
+
+#define RING_MASK                     (LINKTEST_EVENT_RING_SIZE - 1)
+
+/* Private variables */
+static linktest_event_t   ring[LINKTEST_EVENT_RING_SIZE];
+static volatile uint32_t  ring_head     = 0;      // free-running, written by the producer (ISR) only
+static volatile uint32_t  ring_tail     = 0;      // free-running, written by the consumer (task) only
+static TaskHandle_t       consumer_task = NULL;
+
+/* instrumentation (written in ISR context, read and reset at the end of a round while the radio is in standby) */
+static volatile uint32_t  num_events    = 0;
+static volatile uint32_t  num_dropped   = 0;
+static volatile uint32_t  ring_hwm      = 0;      // high-water mark (max. number of used slots)
+static volatile uint32_t  isr_cnt       = 0;
+static volatile uint32_t  isr_sum       = 0;      // [hs_timer ticks]
+static volatile uint32_t  isr_max       = 0;      // [hs_timer ticks]
+static uint32_t           latency_max   = 0;      // max. time between event and processing [hs_timer ticks]
+
+
+/******************************************************************************
+ * Producer (ISR context)
+ ******************************************************************************/
+static linktest_event_t* linktest_events_alloc(void) {
+  uint32_t head = ring_head;
+  if ((head - ring_tail) >= LINKTEST_EVENT_RING_SIZE) {
+    num_dropped++;
+    return 0;
+  }
+  return &ring[head & RING_MASK];
+}
+
+static void linktest_events_commit(void) {
+  BaseType_t higher_prio_task_woken = pdFALSE;
+  uint32_t   head = ring_head + 1;
+
+  LINKTEST_EVENT_BARRIER();   // record must be complete before it is published
+  ring_head = head;
+  num_events++;
+  if ((head - ring_tail) > ring_hwm) {
+    ring_hwm = head - ring_tail;
+  }
+  if (consumer_task) {
+    vTaskNotifyGiveFromISR(consumer_task, &higher_prio_task_woken);
+  }
+  portYIELD_FROM_ISR(higher_prio_task_woken);
+}
+
+bool linktest_events_push_rxdone(const uint8_t* payload, uint16_t size, int16_t rssi, int8_t snr, bool crc_error, uint16_t slotIdx, uint64_t syncTs) {
+  linktest_event_t* ev = linktest_events_alloc();
+  if (!ev) {
+    return false;
+  }
+  ev->timestamp = (uint32_t)hs_timer_get_current_timestamp();
+  ev->ts        = syncTs;
+  ev->type      = LINKTEST_EVENT_RXDONE;
+  ev->rssi      = rssi;
+  ev->snr       = snr;
+  ev->size      = (uint8_t)size;
+  ev->crc_error = crc_error;
+  ev->slot      = slotIdx;
+  memcpy(ev->payload, payload, (size < LINKTEST_EVENT_PAYLOAD_LEN) ? size : LINKTEST_EVENT_PAYLOAD_LEN);
+  linktest_events_commit();
+  return true;
+}
+
+bool linktest_events_push_txdone(uint64_t txDoneTs, uint16_t slotIdx) {
+  linktest_event_t* ev = linktest_events_alloc();
+  if (!ev) {
+    return false;
+  }
+  ev->timestamp = (uint32_t)hs_timer_get_current_timestamp();
+  ev->ts        = txDoneTs;
+  ev->type      = LINKTEST_EVENT_TXDONE;
+  ev->slot      = slotIdx;
+  linktest_events_commit();
+  return true;
+}
+
+void linktest_events_isr_time(uint32_t ticks) {
+  isr_cnt++;
+  isr_sum += ticks;
+  if (ticks > isr_max) {
+    isr_max = ticks;
+  }
+}
+
+
+/******************************************************************************
+ * Consumer (task context)
+ ******************************************************************************/
+static void linktest_events_handle(const linktest_event_t* ev) {
+  static uint8_t payload[sizeof(linktest_message_t) + 1];   // +1 for the zero termination of the key
+  uint32_t latency = (uint32_t)hs_timer_get_current_timestamp() - ev->timestamp;
+
+  if (latency > latency_max) {
+    latency_max = latency;
+  }
+  if (ev->type == LINKTEST_EVENT_RXDONE) {
+    // bytes beyond the stored header are zero (sanitized like any other invalid character)
+    memset(payload, 0, sizeof(payload));
+    memcpy(payload, ev->payload, (ev->size < LINKTEST_EVENT_PAYLOAD_LEN) ? ev->size : LINKTEST_EVENT_PAYLOAD_LEN);
+    linktest_process_rxdone(payload, ev->size, ev->rssi, ev->snr, ev->crc_error, ev->slot, ev->ts);
+  }
+  else if (ev->type == LINKTEST_EVENT_TXDONE) {
+    linktest_process_txdone(ev->ts, ev->slot);
+  }
+}
+
+void linktest_events_set_consumer(TaskHandle_t task) {
+  consumer_task = task;
+}
+
+void linktest_events_process(void) {
+  uint32_t tail = ring_tail;
+  while (tail != ring_head) {
+    LINKTEST_EVENT_BARRIER();   // read the record only after it has been published
+    linktest_events_handle(&ring[tail & RING_MASK]);
+    LINKTEST_EVENT_BARRIER();   // release the slot only after the record has been processed
+    tail++;
+    ring_tail = tail;
+  }
+}
+
+void linktest_events_flush(void) {
+  if (!consumer_task) {
+    // no logging task (e.g. host simulation): process the events in the context of the caller
+    linktest_events_process();
+    return;
+  }
+  // wait until the logging task has processed all pending events
+  while (ring_tail != ring_head) {
+    xTaskNotifyGive(consumer_task);
+    vTaskDelay(pdMS_TO_TICKS(1));
+  }
+}
+
+void linktest_events_print_stats(uint16_t roundIdx) {
+  LINKTEST_LOG("{\"type\":\"EventStats\","
+               "\"round\":%u,"
+               "\"numEvents\":%lu,"
+               "\"numDropped\":%lu,"
+               "\"ringHwm\":%lu,"
+               "\"isrCnt\":%lu,"
+               "\"isrAvg\":%lu,"
+               "\"isrMax\":%lu,"
+               "\"latencyMax\":%lu}",
+    roundIdx,
+    (unsigned long)num_events,
+    (unsigned long)num_dropped,
+    (unsigned long)ring_hwm,
+    (unsigned long)isr_cnt,
+    (unsigned long)(isr_cnt ? ((uint64_t)isr_sum * 1000000 / HS_TIMER_FREQUENCY / isr_cnt) : 0),
+    (unsigned long)((uint64_t)isr_max * 1000000 / HS_TIMER_FREQUENCY),
+    (unsigned long)((uint64_t)latency_max * 1000000 / HS_TIMER_FREQUENCY)
+  );
+  linktest_events_reset_stats();
+}
+
+void linktest_events_reset_stats(void) {
+  num_events  = 0;
+  num_dropped = 0;
+  ring_hwm    = 0;
+  isr_cnt     = 0;
+  isr_sum     = 0;
+  isr_max     = 0;
+  latency_max = 0;
+}
+
+
+/******************************************************************************
+ * Logging task
+ ******************************************************************************/
+void vTask_linktest_log(void const * argument) {
+  linktest_events_set_consumer(xTaskGetCurrentTaskHandle());
+
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    linktest_events_process();
+  }
+}
+
+#endif /* TESTCONFIG_LOG_DEFERRED */
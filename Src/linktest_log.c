@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2019 - 2021, ETH Zurich, Computer Engineering Group (TEC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * @brief  Binary log records (compact alternative to the JSON output)
+ */
+
+#include "main.h"
+
+
+/* Private variables */
+static uint16_t log_seq = 0;
+
+static const char base64_table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+
+/******************************************************************************
+ * Encoding
+ ******************************************************************************/
+
+/* CRC-16/CCITT-FALSE (poly 0x1021), use crc=0xffff as initial value */
+uint16_t linktest_log_crc16(const uint8_t* data, uint32_t len, uint16_t crc) {
+  uint32_t i;
+  uint8_t  j;
+  for (i = 0; i < len; i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (j = 0; j < 8; j++) {
+      crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+    }
+  }
+  return crc;
+}
+
+/* writes header, payload and CRC into out, returns the number of bytes written */
+uint32_t linktest_log_encode(uint8_t type, const void* payload, uint8_t payload_len, uint8_t* out) {
+  linktest_log_hdr_t hdr = {
+    .type = type,
+    .len  = payload_len,
+    .seq  = log_seq++,
+  };
+  uint32_t len = 0;
+  memcpy(out, &hdr, sizeof(hdr));
+  len += sizeof(hdr);
+  if (payload_len) {
+    memcpy(out + len, payload, payload_len);
+    len += payload_len;
+  }
+  uint16_t crc = linktest_log_crc16(out, len, 0xffff);
+  out[len++] = (uint8_t)(crc & 0xff);
+  out[len++] = (uint8_t)(crc >> 8);
+  return len;
+}
+
+/* base64 encoding with padding, out must hold at least 4*((len+2)/3)+1 chars */
+uint32_t linktest_log_base64(const uint8_t* data, uint32_t len, char* out) {
+  uint32_t i;
+  uint32_t n = 0;
+  for (i = 0; i < len; i += 3) {
+    uint32_t v = (uint32_t)data[i] << 16;
+    if (i + 1 < len) { v |= (uint32_t)data[i + 1] << 8; }
+    if (i + 2 < len) { v |= (uint32_t)data[i + 2]; }
+    out[n++] = base64_table[(v >> 18) & 0x3f];
+    out[n++] = base64_table[(v >> 12) & 0x3f];
+    out[n++] = (i + 1 < len) ? base64_table[(v >> 6) & 0x3f] : '=';
+    out[n++] = (i + 2 < len) ? base64_table[v & 0x3f] : '=';
+  }
+  out[n] = 0;
+  return n;
+}
+
+void linktest_log_record(uint8_t type, const void* payload, uint8_t payload_len) {
+  uint8_t rec[LINKTEST_LOG_MAX_REC_LEN];
+
+  uint32_t len = linktest_log_encode(type, payload, payload_len, rec);
+#if TESTCONFIG_LOG_ARENA
+  /* stored without base64 encoding, encoded when the arena is dumped */
+  linktest_arena_append(LINKTEST_ARENA_ENTRY_BINARY, rec, (uint16_t)len);
+#else /* TESTCONFIG_LOG_ARENA */
+  char line[4 * ((LINKTEST_LOG_MAX_REC_LEN + 2) / 3) + 2];
+  line[0] = LINKTEST_LOG_MARKER;
+  linktest_log_base64(rec, len, &line[1]);
+  /* single %s argument, no number formatting required */
+  LOG_INFO("%s", line);
+#endif /* TESTCONFIG_LOG_ARENA */
+}
+
+
+/******************************************************************************
+ * Records
+ ******************************************************************************/
+
+void linktest_log_rxdone(const uint8_t* payload, uint16_t size, int16_t rssi, int8_t snr, bool crc_error, uint64_t syncTs) {
+  linktest_log_rxdone_t rec;
+  const linktest_message_t *msg = (const linktest_message_t*) payload;
+  uint16_t key_len = (size > sizeof(msg->counter)) ? (size - sizeof(msg->counter)) : 0;
+
+  memset(&rec, 0, sizeof(rec));
+  rec.ts_sync   = syncTs;
+  rec.counter   = (size >= sizeof(msg->counter)) ? msg->counter : 0;
+  rec.rssi      = rssi;
+  rec.snr       = snr;
+  rec.size      = (uint8_t)size;
+  rec.crc_error = crc_error;
+  rec.key_len   = (uint8_t)key_len;
+  memcpy(rec.key, msg->key, (key_len > LINKTEST_LOG_KEY_LEN) ? LINKTEST_LOG_KEY_LEN : key_len);
+
+  linktest_log_record(LINKTEST_LOG_REC_RXDONE, &rec, sizeof(rec));
+}
+
+void linktest_log_txdone(uint64_t ts, uint16_t slot) {
+  linktest_log_txdone_t rec = {
+    .ts   = ts,
+    .slot = slot,
+  };
+  linktest_log_record(LINKTEST_LOG_REC_TXDONE, &rec, sizeof(rec));
+}
+
+void linktest_log_flood(const linktest_log_flood_t* rec) {
+  /* only the used entries of rx[] are printed */
+  uint8_t len = sizeof(*rec) - sizeof(rec->rx) + rec->num_rx * sizeof(rec->rx[0]);
+  linktest_log_record(LINKTEST_LOG_REC_FLOOD, rec, len);
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2019 - 2021, ETH Zurich, Computer Engineering Group (TEC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * @brief  Per-round accounting of CPU and radio state times
+ */
+
+#include "main.h"
+
+#if TESTCONFIG_LOG_STATE_TIME
+
+#define LPTIMER_TICKS_TO_US(t)        ((uint64_t)(t) * 1000000 / LPTIMER_SECOND)
+
+/* Private variables */
+static volatile uint8_t   radio_state = LINKTEST_RADIO_STANDBY;
+static volatile uint64_t  state_ts    = 0;                            // lptimer timestamp of the last state transition
+static volatile uint64_t  state_time[LINKTEST_RADIO_NUM_STATES];      // accumulated time per radio state [lptimer ticks]
+static uint64_t           round_start_ts  = 0;                        // [lptimer ticks]
+static uint64_t           cpu_start_time  = 0;                        // CPU active time at the start of the round [lptimer ticks]
+
+
+/* radio state transition (radio driver, ISR or task context) */
+void linktest_state_time_radio(unsigned int state) {
+  uint64_t now;
+  uint32_t mask = 0;
+  bool     isr  = (__get_IPSR() != 0);
+
+  if (state >= LINKTEST_RADIO_NUM_STATES) {
+    return;
+  }
+  /* the update must not be interrupted by a transition in another context */
+  if (isr) {
+    mask = taskENTER_CRITICAL_FROM_ISR();
+  }
+  else {
+    taskENTER_CRITICAL();
+  }
+  now = lptimer_now();
+  state_time[radio_state] += now - state_ts;
+  state_ts    = now;
+  radio_state = state;
+  if (isr) {
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+  }
+  else {
+    taskEXIT_CRITICAL();
+  }
+}
+
+void linktest_state_time_start_round(void) {
+  uint32_t i;
+  taskENTER_CRITICAL();
+  round_start_ts = lptimer_now();
+  state_ts       = round_start_ts;
+  for (i = 0; i < LINKTEST_RADIO_NUM_STATES; i++) {
+    state_time[i] = 0;
+  }
+  taskEXIT_CRITICAL();
+  cpu_start_time = RTOS_getActiveTime();
+}
+
+void linktest_state_time_end_round(uint16_t roundIdx) {
+  uint64_t times[LINKTEST_RADIO_NUM_STATES];
+  uint64_t now;
+  uint32_t i;
+
+  /* account the ongoing state up to now */
+  taskENTER_CRITICAL();
+  now = lptimer_now();
+  state_time[radio_state] += now - state_ts;
+  state_ts = now;
+  for (i = 0; i < LINKTEST_RADIO_NUM_STATES; i++) {
+    times[i] = state_time[i];
+  }
+  taskEXIT_CRITICAL();
+
+  LINKTEST_LOG("{\"type\":\"StateTime\","
+               "\"round\":%u,"
+               "\"duration\":%lu,"
+               "\"cpu\":%lu,"
+               "\"tx\":%lu,"
+               "\"rx\":%lu,"
+               "\"standby\":%lu}",
+    roundIdx,
+    (unsigned long)LPTIMER_TICKS_TO_US(now - round_start_ts),
+    (unsigned long)LPTIMER_TICKS_TO_US(RTOS_getActiveTime() - cpu_start_time),
+    (unsigned long)LPTIMER_TICKS_TO_US(times[LINKTEST_RADIO_TX]),
+    (unsigned long)LPTIMER_TICKS_TO_US(times[LINKTEST_RADIO_RX]),
+    (unsigned long)LPTIMER_TICKS_TO_US(times[LINKTEST_RADIO_STANDBY])
+  );
+}
+
+#endif /* TESTCONFIG_LOG_STATE_TIME */
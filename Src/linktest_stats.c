@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2019 - 2021, ETH Zurich, Computer Engineering Group (TEC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * @brief  On-node aggregation of per-link statistics (P2P mode)
+ */
+
+#include "main.h"
+
+#if TESTCONFIG_LOG_STATS
+
+extern const uint16_t TESTCONFIG_NODE_LIST[];
+
+/* Private variables */
+static linktest_stats_t stats[TESTCONFIG_NUM_NODES];   // one entry per transmitter (of the current radio config)
+static linktest_stats_t *stats_cur    = 0;
+static int32_t           last_counter = -1;           // counter of the last valid packet in the current round
+
+
+/******************************************************************************
+ * Helper Functions
+ ******************************************************************************/
+static void linktest_stats_add_gap(int32_t gap) {
+  if (gap <= 0) {
+    return;
+  }
+  if (gap > LINKTEST_STATS_GAP_BINS) {
+    gap = LINKTEST_STATS_GAP_BINS;
+  }
+  stats_cur->gap_hist[gap - 1]++;
+}
+
+static bool linktest_stats_key_valid(const linktest_message_t* msg, uint16_t size) {
+  const uint16_t key_len = sizeof(TESTCONFIG_KEY) - 1;
+  return (size == sizeof(msg->counter) + key_len) && (memcmp(msg->key, TESTCONFIG_KEY, key_len) == 0);
+}
+
+
+/******************************************************************************
+ * Accumulation
+ ******************************************************************************/
+void linktest_stats_start_round(uint16_t roundIdx) {
+  stats_cur = &stats[LINKTEST_ROUND_NODE_IDX(roundIdx)];
+  memset(stats_cur, 0, sizeof(linktest_stats_t));
+  stats_cur->round    = roundIdx;
+  stats_cur->node     = TESTCONFIG_NODE_LIST[LINKTEST_ROUND_NODE_IDX(roundIdx)];
+  stats_cur->rssi_min = INT16_MAX;
+  stats_cur->rssi_max = INT16_MIN;
+  stats_cur->snr_min  = INT8_MAX;
+  stats_cur->snr_max  = INT8_MIN;
+  last_counter = -1;
+}
+
+void linktest_stats_rx(const uint8_t* payload, uint16_t size, int16_t rssi, int8_t snr, bool crc_error) {
+  const linktest_message_t *msg = (const linktest_message_t*) payload;
+
+  if (!stats_cur) {
+    return;
+  }
+  if (crc_error) {
+    stats_cur->num_crc_error++;
+    return;
+  }
+  if (!linktest_stats_key_valid(msg, size)) {
+    return;
+  }
+  stats_cur->num_rx++;
+  stats_cur->rssi_sum    += rssi;
+  stats_cur->rssi_sq_sum += (int32_t)rssi * rssi;
+  stats_cur->snr_sum     += snr;
+  stats_cur->snr_sq_sum  += (int32_t)snr * snr;
+  if (rssi < stats_cur->rssi_min) { stats_cur->rssi_min = rssi; }
+  if (rssi > stats_cur->rssi_max) { stats_cur->rssi_max = rssi; }
+  if (snr < stats_cur->snr_min)   { stats_cur->snr_min = snr; }
+  if (snr > stats_cur->snr_max)   { stats_cur->snr_max = snr; }
+
+  // loss burst between the previous and the current packet
+  if ((int32_t)msg->counter > last_counter) {
+    linktest_stats_add_gap((int32_t)msg->counter - last_counter - 1);
+    last_counter = msg->counter;
+  }
+}
+
+void linktest_stats_tx(void) {
+  if (stats_cur) {
+    stats_cur->num_tx++;
+  }
+}
+
+void linktest_stats_end_round(uint16_t roundIdx) {
+  if (!stats_cur) {
+    return;
+  }
+  if (stats_cur->node != NODE_ID) {
+    // loss burst at the end of the round
+    linktest_stats_add_gap(TESTCONFIG_NUM_SLOTS - 1 - last_counter);
+  }
+
+#if TESTCONFIG_LOG_BINARY
+  linktest_log_record(LINKTEST_LOG_REC_STATS, stats_cur, sizeof(linktest_stats_t));
+#else /* TESTCONFIG_LOG_BINARY */
+  char     gap_hist[LINKTEST_STATS_GAP_BINS * 6 + 1];
+  uint32_t len = 0;
+  uint32_t i;
+  for (i = 0; i < LINKTEST_STATS_GAP_BINS; i++) {
+    len += snprintf(&gap_hist[len], sizeof(gap_hist) - len, (i == 0) ? "%u" : ",%u", stats_cur->gap_hist[i]);
+  }
+  LINKTEST_LOG("{\"type\":\"RoundStats\","
+               "\"round\":%u,"
+               "\"node\":%u,"
+               "\"numTx\":%u,"
+               "\"numRx\":%u,"
+               "\"numCrcError\":%u,"
+               "\"rssiSum\":%ld,"
+               "\"rssiSqSum\":%lu,"
+               "\"rssiMin\":%d,"
+               "\"rssiMax\":%d,"
+               "\"snrSum\":%ld,"
+               "\"snrSqSum\":%lu,"
+               "\"snrMin\":%d,"
+               "\"snrMax\":%d,"
+               "\"gapHist\":[%s]}",
+    stats_cur->round,
+    stats_cur->node,
+    stats_cur->num_tx,
+    stats_cur->num_rx,
+    stats_cur->num_crc_error,
+    (long)stats_cur->rssi_sum,
+    (unsigned long)stats_cur->rssi_sq_sum,
+    stats_cur->rssi_min,
+    stats_cur->rssi_max,
+    (long)stats_cur->snr_sum,
+    (unsigned long)stats_cur->snr_sq_sum,
+    stats_cur->snr_min,
+    stats_cur->snr_max,
+    gap_hist
+  );
+#endif /* TESTCONFIG_LOG_BINARY */
+
+  stats_cur = 0;
+}
+
+const linktest_stats_t* linktest_stats_get(uint16_t roundIdx) {
+  return (roundIdx < LINKTEST_NUM_ROUNDS) ? &stats[LINKTEST_ROUND_NODE_IDX(roundIdx)] : 0;
+}
+
+#endif /* TESTCONFIG_LOG_STATS */
@@ -311,6 +311,11 @@ void LPTIM1_IRQHandler(void)
 void EXTI3_IRQHandler(void)
 {
   /* USER CODE BEGIN EXTI3_IRQn 0 */
+#if TESTCONFIG_SYNC_EXTI
+  if (__HAL_GPIO_EXTI_GET_IT(LINKTEST_SYNC_PIN) != 0) {
+    linktest_sync_isr();
+  }
+#endif /* TESTCONFIG_SYNC_EXTI */
 
   /* USER CODE END EXTI3_IRQn 0 */
   HAL_GPIO_EXTI_IRQHandler(COM_TREQ_Pin);
@@ -38,9 +38,9 @@ void vTask_linktest(void const * argument)
   const uint32_t SetupTime  = TESTCONFIG_SETUP_TIME;
   const uint32_t StartDelay = TESTCONFIG_START_DELAY;
   const uint32_t StopDelay  = TESTCONFIG_STOP_DELAY;
-  const uint32_t SlotGap    = TESTCONFIG_SLOT_GAP;
+  uint32_t       SlotGap    = TESTCONFIG_SLOT_GAP;
 
-  vTaskDelay(pdMS_TO_TICKS(1000));
+  vTaskDelay(pdMS_TO_TICKS(LINKTEST_STARTUP_DELAY));
   LOG_INFO_CONST("linktest task started!");
   LOG_INFO("{\"type\":\"TestConfig\","
            "\"p2pMode\":%d,"
@@ -51,6 +51,16 @@ void vTask_linktest(void const * argument)
            "\"startDelay\":%d,"
            "\"stopDelay\":%d,"
            "\"txSlack\":%d,"
+           "\"numConfigs\":%d,"
+           "\"berMode\":%d,"
+           "\"berPayloadLen\":%d,"
+           "\"numPayloadLens\":%d,"
+           "\"hsTimerFreq\":%lu,"
+           "\"pingPong\":%d,"
+           "\"numChannels\":%d,"
+           "\"scheduleCrc\":%lu,"
+           "\"captureMode\":%d,"
+           "\"logArena\":%d,"
            "\"key\":\"%s\"}",
     TESTCONFIG_P2P_MODE,
     TESTCONFIG_FLOOD_MODE,
@@ -60,11 +70,62 @@ void vTask_linktest(void const * argument)
     TESTCONFIG_START_DELAY,
     TESTCONFIG_STOP_DELAY,
     TESTCONFIG_SLOT_GAP,
+    TESTCONFIG_NUM_CONFIGS,
+    TESTCONFIG_BER_MODE,
+    TESTCONFIG_BER_PAYLOAD_LEN,
+    TESTCONFIG_NUM_PAYLOAD_LENS,
+    (unsigned long)HS_TIMER_FREQUENCY,
+    TESTCONFIG_PING_PONG,
+    TESTCONFIG_NUM_CHANNELS,
+#if TESTCONFIG_NUM_CHANNELS > 1
+    (unsigned long)LINKTEST_SCHEDULE_CRC,
+#else
+    0UL,
+#endif /* TESTCONFIG_NUM_CHANNELS */
+    TESTCONFIG_CAPTURE_MODE,
+    TESTCONFIG_LOG_ARENA,
     TESTCONFIG_KEY
   );
 
-  if (TESTCONFIG_P2P_MODE) {
+#if TESTCONFIG_CAPTURE_MODE
+  static char captureOffsets[TESTCONFIG_NUM_CAPTURE_OFFSETS * 12 + 1];
+  uint32_t    captureOffsetsLen = 0;
+  for (uint32_t i = 0; i < TESTCONFIG_NUM_CAPTURE_OFFSETS; i++) {
+    captureOffsetsLen += snprintf(&captureOffsets[captureOffsetsLen], sizeof(captureOffsets) - captureOffsetsLen, i ? ",%ld" : "%ld", (long)linktest_get_capture_offset(i));
+  }
+  LOG_INFO("{\"type\":\"CaptureConfig\","
+           "\"samePayload\":%d,"
+           "\"offsets\":[%s]}",
+    TESTCONFIG_CAPTURE_SAME_PAYLOAD,
+    captureOffsets
+  );
+#endif /* TESTCONFIG_CAPTURE_MODE */
+
+#if TESTCONFIG_NUM_CHANNELS > 1
+  // node IDs in the order of the schedule columns
+  static char nodeIds[TESTCONFIG_NUM_NODES * 6 + 1];
+  uint32_t    nodeIdsLen = 0;
+  for (uint32_t i = 0; i < TESTCONFIG_NUM_NODES; i++) {
+    nodeIdsLen += snprintf(&nodeIds[nodeIdsLen], sizeof(nodeIds) - nodeIdsLen, i ? ",%u" : "%u", TESTCONFIG_NODE_LIST[i]);
+  }
+  LOG_INFO("{\"type\":\"Schedule\","
+           "\"numRounds\":%d,"
+           "\"numSlots\":%d,"
+           "\"channelSpacing\":%lu,"
+           "\"nodeIds\":[%s]}",
+    LINKTEST_SCHEDULE_NUM_ROUNDS,
+    LINKTEST_SCHEDULE_NUM_SLOTS,
+    (unsigned long)TESTCONFIG_CHANNEL_SPACING,
+    nodeIds
+  );
+#endif /* TESTCONFIG_NUM_CHANNELS */
+
+#if TESTCONFIG_P2P_MODE
+  uint8_t cfgIdx;
+  for (cfgIdx = 0; cfgIdx < TESTCONFIG_NUM_CONFIGS; cfgIdx++) {
+    const linktest_radio_config_t* cfg = linktest_get_radio_config(cfgIdx);
     LOG_INFO("{\"type\":\"RadioConfig\","
+      "\"configIdx\":%d,"
       "\"txPower\":%d,"
       "\"frequency\":%lu,"
       "\"modulation\":%d,"
@@ -74,17 +135,19 @@ void vTask_linktest(void const * argument)
       "\"preamleLength\":%d,"
       "\"implicitHeader\":%d,"
       "\"crcOn\":%d}",
-      RADIOCONFIG_TX_POWER,
-      RADIOCONFIG_FREQUENCY,
-      RADIOCONFIG_MODULATION,
-      RADIOCONFIG_DATARATE,
-      RADIOCONFIG_BANDWIDTH,
-      RADIOCONFIG_CODERATE,
-      RADIOCONFIG_PREAMBLE_LEN,
-      RADIOCONFIG_IMPLICIT_HEADER,
-      RADIOCONFIG_CRC_ON
+      cfgIdx,
+      cfg->tx_power,
+      (unsigned long)cfg->frequency,
+      cfg->modulation,
+      cfg->datarate,
+      cfg->bandwidth,
+      cfg->coderate,
+      cfg->preamble_len,
+      cfg->implicit_header,
+      cfg->crc_on
     );
   }
+#endif /* TESTCONFIG_P2P_MODE */
   if (TESTCONFIG_FLOOD_MODE) {
     LOG_INFO("{\"type\":\"FloodConfig\","
       "\"rfBand\":%d,"
@@ -94,7 +157,12 @@ void vTask_linktest(void const * argument)
       "\"numHops\":%d,"
       "\"floodGap\":%d,"
       "\"delayTx\":%d,"
-      "\"initiator\":%d}",
+      "\"numDelays\":%d,"
+      "\"initiator\":%d,"
+      "\"adaptive\":%d,"
+      "\"adaptiveMaxHops\":%d,"
+      "\"adaptiveGap\":%d,"
+      "\"trace\":%d}",
       FLOODCONFIG_RF_BAND,
       FLOODCONFIG_TX_POWER,
       FLOODCONFIG_MODULATION,
@@ -102,7 +170,12 @@ void vTask_linktest(void const * argument)
       FLOODCONFIG_NUM_HOPS,
       FLOODCONFIG_FLOOD_GAP,
       FLOODCONFIG_DELAY_TX,
-      FLOODCONFIG_INITIATOR
+      FLOODCONFIG_NUM_DELAYS,
+      FLOODCONFIG_INITIATOR,
+      FLOODCONFIG_ADAPTIVE,
+      FLOODCONFIG_ADAPTIVE_MAX_HOPS,
+      FLOODCONFIG_ADAPTIVE_GAP,
+      FLOODCONFIG_TRACE
     );
   }
 
@@ -110,24 +183,86 @@ void vTask_linktest(void const * argument)
   log_flush();
 #endif /* LOG_PRINT_IMMEDIATELY */
 
+#if TESTCONFIG_LOG_ARENA
+  linktest_arena_init();
+#endif /* TESTCONFIG_LOG_ARENA */
+
   uint32_t SlotTime;
   linktest_init(&SlotTime);
+#if TESTCONFIG_NUM_PAYLOAD_LENS > 1
+  uint8_t lenIdx;
+  for (cfgIdx = 0; cfgIdx < TESTCONFIG_NUM_CONFIGS; cfgIdx++) {
+    for (lenIdx = 0; lenIdx < TESTCONFIG_NUM_PAYLOAD_LENS; lenIdx++) {
+      LOG_INFO("{\"type\":\"PayloadLen\","
+        "\"configIdx\":%d,"
+        "\"lenIdx\":%d,"
+        "\"payloadLen\":%d,"
+        "\"timeOnAir\":%lu}",
+        cfgIdx,
+        lenIdx,
+        linktest_get_payload_len(lenIdx),
+        linktest_get_time_on_air(cfgIdx, lenIdx)
+      );
+    }
+  }
+#if !LOG_PRINT_IMMEDIATELY
+  log_flush();
+#endif /* LOG_PRINT_IMMEDIATELY */
+#endif /* TESTCONFIG_NUM_PAYLOAD_LENS */
+#if TESTCONFIG_SLOT_CALIBRATION
+  /* slots are scheduled with the calibrated slot period, the round period is based on the upper bound (needs to be identical on all nodes) */
+  SlotGap = linktest_get_slot_gap();
+#endif /* TESTCONFIG_SLOT_CALIBRATION */
+#if TESTCONFIG_NUM_CHANNELS > 1
+  /* transmissions start after the channel switch of the receivers */
+  SlotGap += LINKTEST_CHANNEL_SWITCH_TIME;
+#endif /* TESTCONFIG_NUM_CHANNELS */
 
   uint32_t SlotPeriod = SlotTime + SlotGap;
-  uint32_t RoundPeriod = SetupTime + StartDelay + (TESTCONFIG_NUM_SLOTS-1)*SlotPeriod + SlotTime + StopDelay;
+  uint32_t RoundPeriod = SetupTime + StartDelay + (LINKTEST_NUM_SLOTS-1)*SlotPeriod + SlotTime + StopDelay;
+#if TESTCONFIG_SLOT_HS_TIMER || (TESTCONFIG_NUM_PAYLOAD_LENS > 1)
+  /* slots are scheduled in hs_timer ticks or differ in length, the round period is based on the slot budget in us */
+  RoundPeriod = SetupTime + StartDelay + linktest_get_slots_time(0) + StopDelay;
+#endif /* TESTCONFIG_SLOT_HS_TIMER || TESTCONFIG_NUM_PAYLOAD_LENS */
+#if TESTCONFIG_SLOT_HS_TIMER
+  uint64_t FirstSlotHs = 0;
+#endif /* TESTCONFIG_SLOT_HS_TIMER */
 
-  /* wait for sync signal */
-  while (FLOCKLAB_PIN_GET(FLOCKLAB_SIG1) == 0) {
-    vTaskDelay(pdMS_TO_TICKS(1));
-  };
-
-  /* initialize time reference */
-  TickType_t xLastRoundPeriodStart = xTaskGetTickCount();
+  /* wait for sync signal and initialize time reference */
+  TickType_t xLastRoundPeriodStart;
+#if TESTCONFIG_SLOT_HS_TIMER && TESTCONFIG_SYNC_EXTI
+  /* rounds are anchored to the hs_timer timestamp of the sync edge */
+  uint64_t RoundStartHs = linktest_wait_for_sync(&xLastRoundPeriodStart);
+#else
+  linktest_wait_for_sync(&xLastRoundPeriodStart);
+#endif /* TESTCONFIG_SLOT_HS_TIMER && TESTCONFIG_SYNC_EXTI */
+#if TESTCONFIG_FLOOD_MODE && FLOODCONFIG_ADAPTIVE
+  /* calibration and feedback floods with the full budget, the rounds use the reduced slot time */
+  linktest_flood_calibrate(&xLastRoundPeriodStart, SlotPeriod, &SlotTime);
+  SlotPeriod  = SlotTime + SlotGap;
+  RoundPeriod = SetupTime + StartDelay + (LINKTEST_NUM_SLOTS-1)*SlotPeriod + SlotTime + StopDelay;
+#endif /* TESTCONFIG_FLOOD_MODE && FLOODCONFIG_ADAPTIVE */
   TickType_t xTmpTs = xLastRoundPeriodStart;
 
-  uint8_t roundIdx;
+  uint16_t roundIdx;
   uint16_t slotIdx;
-  for (roundIdx=0; roundIdx<TESTCONFIG_NUM_NODES; roundIdx++) {
+  for (roundIdx=0; roundIdx<LINKTEST_NUM_ROUNDS; roundIdx++) {
+#if TESTCONFIG_NUM_CONFIGS > 1
+    // the slot and round periods depend on the radio config (identical on all nodes)
+    if (LINKTEST_ROUND_NODE_IDX(roundIdx) == 0) {
+      SlotTime    = linktest_get_time_on_air(LINKTEST_ROUND_CONFIG_IDX(roundIdx), 0) / 1000;
+      SlotPeriod  = SlotTime + SlotGap;
+      RoundPeriod = SetupTime + StartDelay + (LINKTEST_NUM_SLOTS-1)*SlotPeriod + SlotTime + StopDelay;
+#if TESTCONFIG_SLOT_HS_TIMER || (TESTCONFIG_NUM_PAYLOAD_LENS > 1)
+      RoundPeriod = SetupTime + StartDelay + linktest_get_slots_time(LINKTEST_ROUND_CONFIG_IDX(roundIdx)) + StopDelay;
+#endif /* TESTCONFIG_SLOT_HS_TIMER || TESTCONFIG_NUM_PAYLOAD_LENS */
+    }
+#endif /* TESTCONFIG_NUM_CONFIGS */
+
+#if TESTCONFIG_LOG_STATE_TIME
+    linktest_state_time_start_round();
+#endif /* TESTCONFIG_LOG_STATE_TIME */
+
     // indicate start of round (indication happens before SetupTime)
     FLOCKLAB_PIN_SET(FLOCKLAB_INT1);
     vTaskDelay(pdMS_TO_TICKS(1));
@@ -137,35 +272,78 @@ void vTask_linktest(void const * argument)
     xTmpTs = xLastRoundPeriodStart;
     vTaskDelayUntil(&xTmpTs, pdMS_TO_TICKS(SetupTime));
     // start of round
-    LOG_INFO("{\"type\":\"StartOfRound\",\"round\":%d,\"node\":%d}", roundIdx, TESTCONFIG_NODE_LIST[roundIdx]);
+    LINKTEST_LOG("{\"type\":\"StartOfRound\",\"round\":%d,\"node\":%d,\"config\":%d}", roundIdx, TESTCONFIG_NODE_LIST[LINKTEST_ROUND_NODE_IDX(roundIdx)], LINKTEST_ROUND_CONFIG_IDX(roundIdx));
 
-    linktest_round_pre(roundIdx);
+    linktest_round_pre(roundIdx);   // selects the radio config (determines the slot periods)
 
     // wait StartDelay
     xTmpTs = xLastRoundPeriodStart;
+#if TESTCONFIG_SLOT_HS_TIMER && TESTCONFIG_SYNC_EXTI
+    // wake up one tick early (tick phase is not aligned with the sync edge), the first slot starts exactly SetupTime + StartDelay after the round start
+    vTaskDelayUntil(&xTmpTs, pdMS_TO_TICKS(SetupTime + StartDelay - 1));
+    FirstSlotHs = RoundStartHs + LINKTEST_US_TO_HS_TICKS((uint64_t)(SetupTime + StartDelay) * 1000);
+    linktest_wait_until(FirstSlotHs);
+#else
     vTaskDelayUntil(&xTmpTs, pdMS_TO_TICKS(SetupTime + StartDelay));
+#if TESTCONFIG_SLOT_HS_TIMER
+    FirstSlotHs = hs_timer_get_current_timestamp();
+#endif /* TESTCONFIG_SLOT_HS_TIMER */
+#endif /* TESTCONFIG_SLOT_HS_TIMER && TESTCONFIG_SYNC_EXTI */
 
-    for (slotIdx=0; slotIdx<TESTCONFIG_NUM_SLOTS; slotIdx++) {
+    for (slotIdx=0; slotIdx<LINKTEST_NUM_SLOTS; slotIdx++) {
+#if TESTCONFIG_CAPTURE_MODE
+      linktest_capture_set_slot_start(FirstSlotHs + linktest_get_slot_start(slotIdx));
+#endif /* TESTCONFIG_CAPTURE_MODE */
       linktest_slot(roundIdx, slotIdx, xTmpTs);
 
       // wait, if not last iteration
-      if (slotIdx < (TESTCONFIG_NUM_SLOTS-1)) {
+      if (slotIdx < (LINKTEST_NUM_SLOTS-1)) {
+#if TESTCONFIG_SLOT_HS_TIMER
+        linktest_wait_until(FirstSlotHs + linktest_get_slot_start(slotIdx+1));
+#else
         xTmpTs = xLastRoundPeriodStart;
+#if TESTCONFIG_SLOT_CALIBRATION || (TESTCONFIG_NUM_PAYLOAD_LENS > 1)
+        vTaskDelayUntil(&xTmpTs, pdMS_TO_TICKS(SetupTime + StartDelay) + linktest_get_slot_offset(slotIdx+1));
+#else
         vTaskDelayUntil(&xTmpTs, pdMS_TO_TICKS(SetupTime + StartDelay + (slotIdx+1)*SlotPeriod));
+#endif /* TESTCONFIG_SLOT_CALIBRATION || TESTCONFIG_NUM_PAYLOAD_LENS */
+#endif /* TESTCONFIG_SLOT_HS_TIMER */
       }
     }
 
+#if TESTCONFIG_SLOT_HS_TIMER && TESTCONFIG_SYNC_EXTI
+    // round boundaries follow the hs_timer, the tick time reference is re-initialized every round
+    RoundStartHs += LINKTEST_US_TO_HS_TICKS((uint64_t)RoundPeriod * 1000);
+    xTmpTs = xLastRoundPeriodStart;
+    vTaskDelayUntil(&xTmpTs, pdMS_TO_TICKS(RoundPeriod - 1));
+    linktest_wait_until(RoundStartHs);
+    xLastRoundPeriodStart = xTaskGetTickCount();
+#else
     vTaskDelayUntil(&xLastRoundPeriodStart, pdMS_TO_TICKS(RoundPeriod));
+#endif /* TESTCONFIG_SLOT_HS_TIMER && TESTCONFIG_SYNC_EXTI */
+
+#if TESTCONFIG_LOG_STATE_TIME
+    linktest_state_time_end_round(roundIdx);
+#endif /* TESTCONFIG_LOG_STATE_TIME */
 
     linktest_round_post(roundIdx);
 
-    LOG_INFO("{\"type\":\"EndOfRound\",\"round\":%d,\"node\":%d}", roundIdx, TESTCONFIG_NODE_LIST[roundIdx]);
+    LINKTEST_LOG("{\"type\":\"EndOfRound\",\"round\":%d,\"node\":%d,\"config\":%d}", roundIdx, TESTCONFIG_NODE_LIST[LINKTEST_ROUND_NODE_IDX(roundIdx)], LINKTEST_ROUND_CONFIG_IDX(roundIdx));
+#if TESTCONFIG_LOG_ARENA
+    // the radio is in standby until the next round
+    linktest_arena_spill();
+#endif /* TESTCONFIG_LOG_ARENA */
 
 #if !LOG_PRINT_IMMEDIATELY
     log_flush();
 #endif /* LOG_PRINT_IMMEDIATELY */
   }
 
+#if TESTCONFIG_LOG_ARENA
+  // print all records of the rounds before the end of the test is indicated
+  linktest_arena_dump();
+#endif /* TESTCONFIG_LOG_ARENA */
+
   FLOCKLAB_PIN_SET(FLOCKLAB_INT1);
   vTaskDelay(pdMS_TO_TICKS(500));
   FLOCKLAB_PIN_CLR(FLOCKLAB_INT1);